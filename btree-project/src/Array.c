@@ -10,6 +10,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 // IntegerArray
 
@@ -20,6 +21,11 @@ IntegerArray *IntegerArray_init(int capacity) {
     return array;
 }
 
+void IntegerArray_init_in_place(IntegerArray *array, uint64_t *items) {
+    array->items = items;
+    array->size = 0;
+}
+
 void IntegerArray_destroy(IntegerArray **array) {
     free((*array)->items);
     free(*array);
@@ -27,9 +33,7 @@ void IntegerArray_destroy(IntegerArray **array) {
 }
 
 void IntegerArray_insert_at_index(IntegerArray *array, int index, uint64_t item) {
-    for (int i = array->size - 1; i >= index; i--) {
-        array->items[i + 1] = array->items[i];
-    }
+    memmove(array->items + index + 1, array->items + index, sizeof(uint64_t) * (array->size - index));
 
     array->items[index] = item;
     array->size++;
@@ -90,9 +94,7 @@ bool IntegerArray_binary_search(IntegerArray *array, uint64_t item, int *index)
 }
 
 void IntegerArray_delete_at_index(IntegerArray *array, int index) {
-    for (int i = index; i < array->size - 1; i++) {
-        array->items[i] = array->items[i + 1];
-    }
+    memmove(array->items + index, array->items + index + 1, sizeof(uint64_t) * (array->size - index - 1));
 
     array->size--;
 }
@@ -116,9 +118,7 @@ void IntegerArray_clear(IntegerArray *array) {
 }
 
 void IntegerArray_copy(IntegerArray *src, IntegerArray *dest) {
-    for (int i = 0; i < src->size; i++) {
-        dest->items[i] = src->items[i];
-    }
+    memcpy(dest->items, src->items, sizeof(uint64_t) * src->size);
 
     dest->size = src->size;
 }
@@ -132,6 +132,11 @@ BPTreeNodeArray *BPTreeNodeArray_init(int capacity) {
     return array;
 }
 
+void BPTreeNodeArray_init_in_place(BPTreeNodeArray *array, BPTreeNode **items) {
+    array->items = items;
+    array->size = 0;
+}
+
 void BPTreeNodeArray_destroy(BPTreeNodeArray **array) {
     free((*array)->items);
     free(*array);
@@ -139,9 +144,7 @@ void BPTreeNodeArray_destroy(BPTreeNodeArray **array) {
 }
 
 void BPTreeNodeArray_insert_at_index(BPTreeNodeArray *array, int index, BPTreeNode *item) {
-    for (int i = array->size - 1; i >= index; i--) {
-        array->items[i + 1] = array->items[i];
-    }
+    memmove(array->items + index + 1, array->items + index, sizeof(BPTreeNode *) * (array->size - index));
 
     array->items[index] = item;
     array->size++;
@@ -163,9 +166,7 @@ int BPTreeNodeArray_search(BPTreeNodeArray *array, BPTreeNode *item) {
 }
 
 void BPTreeNodeArray_delete_at_index(BPTreeNodeArray *array, int index) {
-    for (int i = index; i < array->size - 1; i++) {
-        array->items[i] = array->items[i + 1];
-    }
+    memmove(array->items + index, array->items + index + 1, sizeof(BPTreeNode *) * (array->size - index - 1));
 
     array->size--;
 }
@@ -175,9 +176,7 @@ void BPTreeNodeArray_clear(BPTreeNodeArray *array) {
 }
 
 void BPTreeNodeArray_copy(BPTreeNodeArray *src, BPTreeNodeArray *dest) {
-    for (int i = 0; i < src->size; i++) {
-        dest->items[i] = src->items[i];
-    }
+    memcpy(dest->items, src->items, sizeof(BPTreeNode *) * src->size);
 
     dest->size = src->size;
 }
@@ -29,6 +29,14 @@ typedef struct IntegerArray {
  */
 IntegerArray *IntegerArray_init(int capacity);
 
+/**
+ * @brief Initializes an "IntegerArray" whose structure and items are given, the caller frees them itself.
+ *
+ * @param array The structure of the array.
+ * @param items Room for the maximum number of items the array can contain.
+ */
+void IntegerArray_init_in_place(IntegerArray *array, uint64_t *items);
+
 /**
  * @brief Destroys the array and free its memory.
  *
@@ -133,6 +141,14 @@ typedef struct BPTreeNodeArray {
  */
 BPTreeNodeArray *BPTreeNodeArray_init(int capacity);
 
+/**
+ * @brief Initializes a "BPTreeNodeArray" whose structure and items are given, the caller frees them itself.
+ *
+ * @param array The structure of the array.
+ * @param items Room for the maximum number of items the array can contain.
+ */
+void BPTreeNodeArray_init_in_place(BPTreeNodeArray *array, BPTreeNode **items);
+
 /**
  * @brief Destroys the array and free its memory.
  *
@@ -0,0 +1,406 @@
+/**
+ * @file AsyncReader.c
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#include "AsyncReader.h"
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Ring : io_uring accessed directly through its system calls.
+
+/**
+ * @brief Data structure that represents the submission and completion queues shared with the kernel.
+ *
+ */
+typedef struct Ring {
+    int fd;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ptr;
+    void *cq_ptr;
+    size_t sq_size;
+    size_t cq_size;
+    size_t sqes_size;
+} Ring;
+
+/**
+ * @brief Sets up an io_uring instance and maps its queues.
+ *
+ * @param ring The ring to initialize.
+ * @param entries The number of entries of the submission queue.
+ * @return true The ring is ready.
+ * @return false io_uring is not available.
+ */
+static bool Ring_init(Ring *ring, unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+
+    if (ring->fd < 0) {
+        return false;
+    }
+
+    ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        // Both queues are in the same mapping.
+        ring->sq_size = ring->sq_size > ring->cq_size ? ring->sq_size : ring->cq_size;
+    }
+
+    ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    ring->cq_ptr = ring->sq_ptr;
+
+    if (ring->sq_ptr != MAP_FAILED && !(params.features & IORING_FEAT_SINGLE_MMAP)) {
+        ring->cq_ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    }
+
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+
+    if (ring->sq_ptr == MAP_FAILED || ring->cq_ptr == MAP_FAILED || ring->sqes == MAP_FAILED) {
+        close(ring->fd);
+        return false;
+    }
+
+    uint8_t *sq_ptr = (uint8_t *)ring->sq_ptr;
+    ring->sq_head = (unsigned *)(sq_ptr + params.sq_off.head);
+    ring->sq_tail = (unsigned *)(sq_ptr + params.sq_off.tail);
+    ring->sq_mask = (unsigned *)(sq_ptr + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(sq_ptr + params.sq_off.array);
+
+    uint8_t *cq_ptr = (uint8_t *)ring->cq_ptr;
+    ring->cq_head = (unsigned *)(cq_ptr + params.cq_off.head);
+    ring->cq_tail = (unsigned *)(cq_ptr + params.cq_off.tail);
+    ring->cq_mask = (unsigned *)(cq_ptr + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq_ptr + params.cq_off.cqes);
+    return true;
+}
+
+/**
+ * @brief Unmaps the queues and closes the io_uring instance.
+ *
+ * @param ring The ring to destroy.
+ */
+static void Ring_destroy(Ring *ring) {
+    munmap(ring->sqes, ring->sqes_size);
+
+    if (ring->cq_ptr != ring->sq_ptr) {
+        munmap(ring->cq_ptr, ring->cq_size);
+    }
+
+    munmap(ring->sq_ptr, ring->sq_size);
+    close(ring->fd);
+}
+
+/**
+ * @brief Reaps the completions available in the completion queue, in whatever order the device finished the reads.
+ *
+ * @param ring The ring.
+ * @param reads The read requests.
+ * @param is_completed The completed reads are marked in this array.
+ * @param callback The function called for each completed read.
+ * @param context Passed as is to the callback.
+ * @return int The number of completions reaped.
+ */
+static int reap_completions(Ring *ring, AsyncRead *reads, bool *is_completed, AsyncReadCallback callback, void *context) {
+    unsigned head = *ring->cq_head;
+    int reaped_count = 0;
+
+    while (head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+        struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+        int index = (int)cqe->user_data;
+        bool is_ok = cqe->res == reads[index].size;
+        head++;
+        __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+        is_completed[index] = true;
+        callback(index, is_ok, context);
+        reaped_count++;
+    }
+
+    return reaped_count;
+}
+
+/**
+ * @brief Performs the reads through io_uring, keeping up to ASYNC_READER_QUEUE_DEPTH reads in flight.
+ *
+ * @param ring The ring.
+ * @param fd The file descriptor of the file to read.
+ * @param reads The read requests.
+ * @param count The number of read requests.
+ * @param callback The function called for each completed read.
+ * @param context Passed as is to the callback.
+ * @return true The ring can be used again.
+ * @return false The ring has failed, the reads have been completed with pread.
+ */
+static bool read_all_with_ring(Ring *ring, int fd, AsyncRead *reads, int count, AsyncReadCallback callback, void *context) {
+    struct iovec *iovecs = (struct iovec *)malloc(sizeof(struct iovec) * (count > 0 ? count : 1));
+    bool *is_completed = (bool *)calloc(count > 0 ? count : 1, sizeof(bool));
+    bool is_ring_ok = true;
+    unsigned first_head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    int submitted_count = 0;
+    int completed_count = 0;
+
+    while (completed_count < count) {
+        // Fills the submission queue.
+        unsigned tail = *ring->sq_tail;
+        unsigned to_submit;
+
+        while (submitted_count < count && submitted_count - completed_count < ASYNC_READER_QUEUE_DEPTH) {
+            AsyncRead *read = &reads[submitted_count];
+            iovecs[submitted_count].iov_base = read->buffer;
+            iovecs[submitted_count].iov_len = read->size;
+
+            unsigned index = tail & *ring->sq_mask;
+            struct io_uring_sqe *sqe = &ring->sqes[index];
+            memset(sqe, 0, sizeof(struct io_uring_sqe));
+            sqe->opcode = IORING_OP_READV;
+            sqe->fd = fd;
+            sqe->off = read->offset;
+            sqe->addr = (uint64_t)(uintptr_t)&iovecs[submitted_count];
+            sqe->len = 1;
+            sqe->user_data = submitted_count;
+            ring->sq_array[index] = index;
+
+            tail++;
+            submitted_count++;
+        }
+
+        // The kernel must see the entries before the new tail.
+        __atomic_store_n(ring->sq_tail, tail, __ATOMIC_RELEASE);
+        // Entries not consumed by an interrupted previous call are submitted again.
+        to_submit = tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+        long result = syscall(__NR_io_uring_enter, ring->fd, to_submit, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+
+        // EINTR and EAGAIN are transient, EBUSY means that the completions must be reaped first.
+        if (result < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            // The reads already consumed by the kernel could still write into their buffers once the caller has freed
+            // them, so their completions are waited for. The reads left in the submission queue are never performed.
+            int consumed_count = (int)(__atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) - first_head);
+
+            while (completed_count < consumed_count) {
+                int reaped_count = reap_completions(ring, reads, is_completed, callback, context);
+                completed_count += reaped_count;
+
+                if (reaped_count == 0) {
+                    // The kernel cannot be waited for through the ring anymore, the completion queue is polled.
+                    sched_yield();
+                }
+            }
+
+            // The other reads are performed with pread.
+            for (int i = 0; i < count; i++) {
+                if (!is_completed[i]) {
+                    callback(i, pread(fd, reads[i].buffer, reads[i].size, reads[i].offset) == reads[i].size, context);
+                }
+            }
+            is_ring_ok = false;
+            break;
+        }
+
+        completed_count += reap_completions(ring, reads, is_completed, callback, context);
+    }
+
+    free(is_completed);
+    free(iovecs);
+    return is_ring_ok;
+}
+
+// Thread pool : fallback when io_uring is not available.
+
+/**
+ * @brief Takes the next read of the current call, performs it with pread and publishes its completion, until the
+ * reader is destroyed.
+ *
+ * @param arg The reader.
+ * @return void* Always NULL.
+ */
+static void *pread_worker(void *arg) {
+    AsyncReader *reader = (AsyncReader *)arg;
+    pthread_mutex_lock(&reader->mutex);
+
+    while (true) {
+        while (!reader->is_stopping && (reader->reads == NULL || reader->next_index >= reader->count)) {
+            pthread_cond_wait(&reader->work_available, &reader->mutex);
+        }
+
+        if (reader->is_stopping) {
+            break;
+        }
+
+        int index = reader->next_index;
+        reader->next_index++;
+        AsyncRead *read = &reader->reads[index];
+        int fd = reader->fd;
+
+        // The reads are performed outside the lock so that the threads read at the same time.
+        pthread_mutex_unlock(&reader->mutex);
+        bool is_ok = pread(fd, read->buffer, read->size, read->offset) == read->size;
+        pthread_mutex_lock(&reader->mutex);
+
+        reader->completed_indexes[reader->completed_count] = index;
+        reader->completed_is_ok[reader->completed_count] = is_ok;
+        reader->completed_count++;
+        pthread_cond_signal(&reader->completed);
+    }
+
+    pthread_mutex_unlock(&reader->mutex);
+    return NULL;
+}
+
+/**
+ * @brief Starts the threads of the pool, if they are not started yet.
+ *
+ * @param reader The reader.
+ */
+static void start_threads(AsyncReader *reader) {
+    for (; reader->thread_count < ASYNC_READER_THREAD_COUNT; reader->thread_count++) {
+        pthread_create(&reader->threads[reader->thread_count], NULL, pread_worker, reader);
+    }
+}
+
+/**
+ * @brief Performs the reads with the threads of the pool.
+ *
+ * @param reader The reader.
+ * @param fd The file descriptor of the file to read.
+ * @param reads The read requests.
+ * @param count The number of read requests.
+ * @param callback The function called for each completed read.
+ * @param context Passed as is to the callback.
+ */
+static void read_all_with_threads(AsyncReader *reader, int fd, AsyncRead *reads, int count, AsyncReadCallback callback, void *context) {
+    pthread_mutex_lock(&reader->mutex);
+    reader->fd = fd;
+    reader->reads = reads;
+    reader->count = count;
+    reader->next_index = 0;
+    reader->completed_indexes = (int *)malloc(sizeof(int) * count);
+    reader->completed_is_ok = (bool *)malloc(sizeof(bool) * count);
+    reader->completed_count = 0;
+    pthread_cond_broadcast(&reader->work_available);
+
+    int consumed_count = 0;
+    while (consumed_count < count) {
+        while (reader->completed_count == consumed_count) {
+            pthread_cond_wait(&reader->completed, &reader->mutex);
+        }
+        int completed_count = reader->completed_count;
+        pthread_mutex_unlock(&reader->mutex);
+
+        // The callbacks are called outside the lock so that the threads keep reading meanwhile.
+        for (; consumed_count < completed_count; consumed_count++) {
+            callback(reader->completed_indexes[consumed_count], reader->completed_is_ok[consumed_count], context);
+        }
+
+        pthread_mutex_lock(&reader->mutex);
+    }
+
+    // All the reads have completed, no thread uses them anymore.
+    reader->reads = NULL;
+    free(reader->completed_indexes);
+    free(reader->completed_is_ok);
+    pthread_mutex_unlock(&reader->mutex);
+}
+
+/**
+ * @brief Allocates a reader that has neither a ring nor threads yet.
+ *
+ * @return AsyncReader* The allocated reader.
+ */
+static AsyncReader *AsyncReader_alloc() {
+    AsyncReader *reader = (AsyncReader *)malloc(sizeof(AsyncReader));
+    reader->ring = NULL;
+    pthread_mutex_init(&reader->call_mutex, NULL);
+    reader->thread_count = 0;
+    pthread_mutex_init(&reader->mutex, NULL);
+    pthread_cond_init(&reader->work_available, NULL);
+    pthread_cond_init(&reader->completed, NULL);
+    reader->is_stopping = false;
+    reader->reads = NULL;
+    return reader;
+}
+
+AsyncReader *AsyncReader_init() {
+    AsyncReader *reader = AsyncReader_alloc();
+    reader->ring = (Ring *)malloc(sizeof(Ring));
+    if (!Ring_init(reader->ring, ASYNC_READER_QUEUE_DEPTH)) {
+        free(reader->ring);
+        reader->ring = NULL;
+        start_threads(reader);
+    }
+
+    return reader;
+}
+
+AsyncReader *AsyncReader_init_with_threads() {
+    AsyncReader *reader = AsyncReader_alloc();
+    start_threads(reader);
+    return reader;
+}
+
+void AsyncReader_destroy(AsyncReader **reader) {
+    if ((*reader)->ring != NULL) {
+        Ring_destroy((*reader)->ring);
+        free((*reader)->ring);
+    }
+
+    pthread_mutex_lock(&(*reader)->mutex);
+    (*reader)->is_stopping = true;
+    pthread_cond_broadcast(&(*reader)->work_available);
+    pthread_mutex_unlock(&(*reader)->mutex);
+
+    for (int i = 0; i < (*reader)->thread_count; i++) {
+        pthread_join((*reader)->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&(*reader)->call_mutex);
+    pthread_mutex_destroy(&(*reader)->mutex);
+    pthread_cond_destroy(&(*reader)->work_available);
+    pthread_cond_destroy(&(*reader)->completed);
+    free(*reader);
+    *reader = NULL;
+}
+
+void AsyncReader_read_all(AsyncReader *reader, int fd, AsyncRead *reads, int count, AsyncReadCallback callback, void *context) {
+    if (count <= 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&reader->call_mutex);
+
+    if (reader->ring != NULL) {
+        if (!read_all_with_ring(reader->ring, fd, reads, count, callback, context)) {
+            // The ring is not used anymore, the next calls are served by the threads.
+            Ring_destroy(reader->ring);
+            free(reader->ring);
+            reader->ring = NULL;
+            start_threads(reader);
+        }
+    } else {
+        read_all_with_threads(reader, fd, reads, count, callback, context);
+    }
+
+    pthread_mutex_unlock(&reader->call_mutex);
+}
@@ -0,0 +1,100 @@
+/**
+ * @file AsyncReader.h
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#ifndef ASYNC_READER_H
+#define ASYNC_READER_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ASYNC_READER_QUEUE_DEPTH 64
+#define ASYNC_READER_THREAD_COUNT 8
+
+/**
+ * @brief Data structure that represents a read request.
+ *
+ */
+typedef struct AsyncRead {
+    uint64_t offset;
+    uint8_t *buffer;
+    int size;
+} AsyncRead;
+
+/**
+ * @brief Function called when a read has completed.
+ *
+ * @param index The index of the read in the array of reads.
+ * @param is_ok true = all the bytes have been read into the buffer, false = the read has failed.
+ * @param context The context given to AsyncReader_read_all.
+ */
+typedef void (*AsyncReadCallback)(int index, bool is_ok, void *context);
+
+/**
+ * @brief Data structure that represents the means of performing many reads at once: an io_uring instance when the
+ * kernel supports it, otherwise a pool of threads doing pread. Both are kept from one call to the next.
+ *
+ */
+typedef struct AsyncReader {
+    // NULL = io_uring is not available, or it has failed, and the reads are done by the threads.
+    struct Ring *ring;
+    // Taken for the whole of a call, the ring and the threads serve one call at a time.
+    pthread_mutex_t call_mutex;
+    pthread_t threads[ASYNC_READER_THREAD_COUNT];
+    int thread_count;
+    // The state below is shared by the threads and the calling thread, it is protected by the mutex.
+    pthread_mutex_t mutex;
+    pthread_cond_t work_available;
+    pthread_cond_t completed;
+    bool is_stopping;
+    int fd;
+    // The reads of the current call, NULL = there is no call.
+    AsyncRead *reads;
+    int count;
+    int next_index;
+    // Queue of the completed reads, the calling thread consumes it to invoke the callback.
+    int *completed_indexes;
+    bool *completed_is_ok;
+    int completed_count;
+} AsyncReader;
+
+/**
+ * @brief Initializes the "AsyncReader" data structure. The io_uring instance is set up, or the threads are started if
+ * io_uring is not available.
+ *
+ * @return AsyncReader* The initialized reader.
+ */
+AsyncReader *AsyncReader_init();
+
+/**
+ * @brief Initializes the "AsyncReader" data structure without io_uring, the reads are always performed by the threads.
+ *
+ * @return AsyncReader* The initialized reader.
+ */
+AsyncReader *AsyncReader_init_with_threads();
+
+/**
+ * @brief Destroys the reader, stops its threads and free its memory.
+ *
+ * @param reader The reader to be destroyed.
+ */
+void AsyncReader_destroy(AsyncReader **reader);
+
+/**
+ * @brief Performs all the reads with many of them in flight at the same time. The callback is always called on the
+ * calling thread, in the order in which the reads complete. The calls from several threads are served one after the
+ * other.
+ *
+ * @param reader The reader.
+ * @param fd The file descriptor of the file to read.
+ * @param reads The read requests.
+ * @param count The number of read requests.
+ * @param callback The function called for each completed read.
+ * @param context Passed as is to the callback.
+ */
+void AsyncReader_read_all(AsyncReader *reader, int fd, AsyncRead *reads, int count, AsyncReadCallback callback, void *context);
+
+#endif
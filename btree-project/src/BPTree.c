@@ -10,27 +10,73 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "Array.h"
+#include "BPTreeStats.h"
 
 // BPTreeNode
 
+/**
+ * @brief Data structure that represents a node allocated in an arena, the node, its arrays and their items are in
+ * the same block.
+ *
+ */
+typedef struct BPTreeNodeBlock {
+    BPTreeNode node;
+    IntegerArray keys;
+    IntegerArray data;
+    BPTreeNodeArray children;
+    // The keys and the data, capacity items each, then the children.
+    uint64_t items[];
+} BPTreeNodeBlock;
+
+/**
+ * @brief Computes the size of the block of a node allocated in an arena.
+ *
+ * @param order The order of the node.
+ * @return int The size of the block.
+ */
+static int compute_node_block_size(int order) {
+    int capacity = 2 * order;
+    return sizeof(BPTreeNodeBlock) + sizeof(uint64_t) * 2 * capacity + sizeof(BPTreeNode *) * (capacity + 1);
+}
+
 /**
  * @brief Initializes the "BPTreeNode" data structure.
  *
  * @param order The order of the node.
  * @param is_leaf true = the node is a leaf, false = the node is not a leaf.
+ * @param arena The arena in which the node is allocated, NULL = the node is allocated on the heap.
  * @return BPTreeNode* The initialized node.
  */
-static BPTreeNode *BPTreeNode_init(int order, bool is_leaf) {
-    BPTreeNode *root = (BPTreeNode *)malloc(sizeof(BPTreeNode));
+static BPTreeNode *BPTreeNode_init(int order, bool is_leaf, NodeArena *arena) {
+    BPTreeNode *root;
+
+    if (arena != NULL) {
+        BPTreeNodeBlock *block = (BPTreeNodeBlock *)NodeArena_alloc(arena);
+        int capacity = 2 * order;
+        IntegerArray_init_in_place(&block->keys, block->items);
+        IntegerArray_init_in_place(&block->data, block->items + capacity);
+        BPTreeNodeArray_init_in_place(&block->children, (BPTreeNode **)(block->items + 2 * capacity));
+
+        root = &block->node;
+        root->keys = &block->keys;
+        root->data = &block->data;
+        root->children = &block->children;
+    } else {
+        root = (BPTreeNode *)malloc(sizeof(BPTreeNode));
+        root->keys = IntegerArray_init(2 * order);
+        root->data = IntegerArray_init(2 * order);
+        // The length of the children's array is always 1 greater than the keys.
+        root->children = BPTreeNodeArray_init(2 * order + 1);
+    }
+
     root->order = order;
     root->is_leaf = is_leaf;
-    root->keys = IntegerArray_init(2 * root->order);
-    root->data = IntegerArray_init(2 * root->order);
-    // The length of the children's array is always 1 greater than the keys.
-    root->children = BPTreeNodeArray_init(2 * root->order + 1);
     root->next = NULL;
+    root->last_leaf = NULL;
+    root->arena = arena;
     return root;
 }
 
@@ -40,6 +86,12 @@ static BPTreeNode *BPTreeNode_init(int order, bool is_leaf) {
  * @param node The node to be destroyed.
  */
 static void BPTreeNode_destroy(BPTreeNode **node) {
+    if ((*node)->arena != NULL) {
+        NodeArena_free((*node)->arena, *node);
+        *node = NULL;
+        return;
+    }
+
     IntegerArray_destroy(&(*node)->keys);
     IntegerArray_destroy(&(*node)->data);
     BPTreeNodeArray_destroy(&(*node)->children);
@@ -50,10 +102,22 @@ static void BPTreeNode_destroy(BPTreeNode **node) {
 // BPTree
 
 BPTreeNode *BPTree_init(int order) {
-    return BPTreeNode_init(order, true);
+    return BPTreeNode_init(order, true, NULL);
+}
+
+BPTreeNode *BPTree_init_in_arena(int order, NodeArenaPages pages) {
+    return BPTreeNode_init(order, true, NodeArena_init(compute_node_block_size(order), pages));
 }
 
 void BPTree_destroy(BPTreeNode **root) {
+    if ((*root)->arena != NULL) {
+        // The nodes are unmapped along with the arena, the tree does not need to be walked.
+        NodeArena *arena = (*root)->arena;
+        NodeArena_destroy(&arena);
+        *root = NULL;
+        return;
+    }
+
     for (int i = 0; i < (*root)->children->size; i++) {
         BPTree_destroy(&(*root)->children->items[i]);
     }
@@ -88,8 +152,39 @@ void BPTree_print(BPTreeNode *root, int depth) {
     }
 }
 
+BPTreeNode *BPTree_find_first_leaf(BPTreeNode *root) {
+    if (root->is_leaf) {
+        return root;
+    }
+
+    return BPTree_find_first_leaf(root->children->items[0]);
+}
+
+#ifdef BPTREE_STATS
+/**
+ * @brief Computes the maximum number of comparisons made by a binary search.
+ *
+ * @param size The size of the array.
+ * @return int The number of comparisons.
+ */
+static int binary_search_comparisons(int size) {
+    int comparisons = 0;
+
+    while (size > 0) {
+        comparisons++;
+        size /= 2;
+    }
+
+    return comparisons;
+}
+#endif
+
 bool BPTree_search(BPTreeNode *root, uint64_t key, uint64_t *data) {
+    BPTREE_COUNT(search_node_visits, 1);
+    BPTREE_COUNT(search_comparison_bound, binary_search_comparisons(root->keys->size));
+
     if (root->is_leaf) {
+        BPTREE_COUNT(searches, 1);
         int index;
         bool found = IntegerArray_binary_search(root->keys, key, &index);
 
@@ -152,18 +247,16 @@ static void insert_non_full(BPTreeNode *node, uint64_t key, uint64_t data, BPTre
  * @param right_index The information is cut in the left node from the right index.
  */
 static void redistribute_keys(BPTreeNode *left_node, BPTreeNode *right_node, int left_index, int right_index) {
-    for (int i = right_index; i < left_node->keys->size; i++) {
-        IntegerArray_append(right_node->keys, left_node->keys->items[i]);
-    }
-
+    int count = left_node->keys->size - right_index;
+    memcpy(right_node->keys->items + right_node->keys->size, left_node->keys->items + right_index, sizeof(uint64_t) * count);
+    right_node->keys->size += count;
     left_node->keys->size = left_index;
 
     // The data is also redistributed if there is any.
-    for (int i = right_index; i < left_node->data->size; i++) {
-        IntegerArray_append(right_node->data, left_node->data->items[i]);
-    }
-
     if (left_node->data->size > 0) {
+        count = left_node->data->size - right_index;
+        memcpy(right_node->data->items + right_node->data->size, left_node->data->items + right_index, sizeof(uint64_t) * count);
+        right_node->data->size += count;
         left_node->data->size = left_index;
     }
 }
@@ -181,7 +274,8 @@ static uint64_t split_leaf(BPTreeNode *node, uint64_t key, uint64_t data, BPTree
     int virtual_insertion_index = IntegerArray_lower_bound(node->keys, key);
     int median_index = node->keys->size / 2;
     uint64_t median_value;
-    *split_right_node = BPTreeNode_init(node->order, true);
+    *split_right_node = BPTreeNode_init(node->order, true, node->arena);
+    BPTREE_COUNT(leaf_splits, 1);
 
     if (virtual_insertion_index < median_index) {
         // The key is inserted to the left of the median value.
@@ -224,10 +318,9 @@ static uint64_t split_leaf(BPTreeNode *node, uint64_t key, uint64_t data, BPTree
  * @param right_index The information is cut in the left node from the right index.
  */
 static void redistribute_children(BPTreeNode *left_node, BPTreeNode *right_node, int left_index, int right_index) {
-    for (int i = right_index; i < left_node->children->size; i++) {
-        BPTreeNodeArray_append(right_node->children, left_node->children->items[i]);
-    }
-
+    int count = left_node->children->size - right_index;
+    memcpy(right_node->children->items + right_node->children->size, left_node->children->items + right_index, sizeof(BPTreeNode *) * count);
+    right_node->children->size += count;
     left_node->children->size = left_index;
 }
 
@@ -244,7 +337,8 @@ static uint64_t split_internal(BPTreeNode *node, uint64_t key, BPTreeNode *previ
     int virtual_insertion_index = IntegerArray_lower_bound(node->keys, key);
     int median_index = node->keys->size / 2;
     uint64_t median_value;
-    *split_right_node = BPTreeNode_init(node->order, false);
+    *split_right_node = BPTreeNode_init(node->order, false, node->arena);
+    BPTREE_COUNT(internal_splits, 1);
 
     if (virtual_insertion_index < median_index) {
         // The key is inserted to the left of the median value.
@@ -300,9 +394,12 @@ static uint64_t insert_full(BPTreeNode *node, uint64_t key, uint64_t data, BPTre
  * @param split_right_node The right node of the split.
  */
 static void grow(BPTreeNode *root, uint64_t median_value, BPTreeNode *split_right_node) {
+    BPTREE_COUNT(grows, 1);
     // When the tree grows is necessarily no longer a leaf.
     root->is_leaf = false;
-    BPTreeNode *left_node = BPTreeNode_init(root->order, split_right_node->is_leaf);
+    // The last leaf may have been the root itself.
+    root->last_leaf = NULL;
+    BPTreeNode *left_node = BPTreeNode_init(root->order, split_right_node->is_leaf, root->arena);
     // Maintains the linked list of leaf nodes.
     left_node->next = root->next;
     root->next = NULL;
@@ -322,6 +419,233 @@ static void grow(BPTreeNode *root, uint64_t median_value, BPTreeNode *split_righ
     BPTreeNodeArray_append(root->children, split_right_node);
 }
 
+/**
+ * @brief Computes how many items go to a node when items are spread evenly over nodes, the first nodes take one item
+ * more than the others.
+ *
+ * @param item_count The number of items.
+ * @param node_count The number of nodes.
+ * @param index The position of the node.
+ * @return int The number of items of the node.
+ */
+static int spread(int item_count, int node_count, int index) {
+    return item_count / node_count + (index < item_count % node_count ? 1 : 0);
+}
+
+// 2 KB, the groups of the nodes up to the order 20 are gathered on the stack.
+#define SIBLING_GROUP_STACK_BUFFER_LENGTH 256
+
+/**
+ * @brief Data structure that represents the content of two adjacent nodes, the key that separates them in their parent
+ * and the information being inserted, gathered in order before being spread over the nodes again.
+ *
+ */
+typedef struct SiblingGroup {
+    uint64_t *keys;
+    uint64_t *data;
+    BPTreeNode **children;
+    int key_count;
+} SiblingGroup;
+
+/**
+ * @brief Copies the content of a node at the end of a group.
+ *
+ * @param group The group.
+ * @param node The node.
+ */
+static void append_to_group(SiblingGroup *group, BPTreeNode *node) {
+    memcpy(group->keys + group->key_count, node->keys->items, sizeof(uint64_t) * node->keys->size);
+
+    if (node->is_leaf) {
+        memcpy(group->data + group->key_count, node->data->items, sizeof(uint64_t) * node->data->size);
+    } else {
+        // Once the separator has been added after the left node, the group has as many children as keys.
+        memcpy(group->children + group->key_count, node->children->items, sizeof(BPTreeNode *) * node->children->size);
+    }
+
+    group->key_count += node->keys->size;
+}
+
+/**
+ * @brief Computes the size of the memory that holds the group of two nodes: their keys, their data and their children.
+ *
+ * @param order The order of the nodes.
+ * @return size_t The size in bytes.
+ */
+static size_t compute_sibling_group_size(int order) {
+    int capacity = 4 * order + 2;
+    return sizeof(uint64_t) * 2 * capacity + sizeof(BPTreeNode *) * (capacity + 1);
+}
+
+/**
+ * @brief Gathers two adjacent nodes and the information being inserted.
+ *
+ * @param buffer The memory that holds the group, of the size given by compute_sibling_group_size.
+ * @param parent The parent of the nodes.
+ * @param left_node The left node.
+ * @param right_node The right node.
+ * @param key The key to insert.
+ * @param data The data to insert, if the nodes are leaves.
+ * @param previous_split_right_node The node resulting from a previous split, if the nodes are internal.
+ * @return SiblingGroup The content of the nodes, in order.
+ */
+static SiblingGroup gather_siblings(uint64_t *buffer, BPTreeNode *parent, BPTreeNode *left_node, BPTreeNode *right_node, uint64_t key, uint64_t data, BPTreeNode *previous_split_right_node) {
+    int capacity = 4 * parent->order + 2;
+    SiblingGroup group = {buffer, buffer + capacity, (BPTreeNode **)(buffer + 2 * capacity), 0};
+
+    append_to_group(&group, left_node);
+    if (!left_node->is_leaf) {
+        // The key that separates internal nodes goes down between them.
+        group.keys[group.key_count] = parent->keys->items[BPTreeNodeArray_search(parent->children, left_node)];
+        group.key_count++;
+    }
+    append_to_group(&group, right_node);
+
+    int insertion_index = group.key_count;
+    while (insertion_index > 0 && group.keys[insertion_index - 1] > key) {
+        insertion_index--;
+    }
+
+    int count = group.key_count - insertion_index;
+    memmove(group.keys + insertion_index + 1, group.keys + insertion_index, sizeof(uint64_t) * count);
+    group.keys[insertion_index] = key;
+
+    if (left_node->is_leaf) {
+        memmove(group.data + insertion_index + 1, group.data + insertion_index, sizeof(uint64_t) * count);
+        group.data[insertion_index] = data;
+    } else {
+        // previous_split_right_node is inserted to the right of the key in the child array.
+        memmove(group.children + insertion_index + 2, group.children + insertion_index + 1, sizeof(BPTreeNode *) * count);
+        group.children[insertion_index + 1] = previous_split_right_node;
+    }
+
+    group.key_count++;
+    return group;
+}
+
+/**
+ * @brief Spreads a group evenly over nodes. A leaf is separated from the next one by its smallest key, which stays in
+ * the leaf, while the key that separates two internal nodes is taken out of them.
+ *
+ * @param group The group.
+ * @param nodes The nodes, from left to right.
+ * @param node_count The number of nodes.
+ * @param separators The keys that separate the nodes will be assigned to this array.
+ */
+static void spread_siblings(SiblingGroup *group, BPTreeNode **nodes, int node_count, uint64_t *separators) {
+    bool is_leaf = nodes[0]->is_leaf;
+    int item_count = group->key_count - (is_leaf ? 0 : node_count - 1);
+    int key_index = 0;
+    int child_index = 0;
+
+    for (int i = 0; i < node_count; i++) {
+        int count = spread(item_count, node_count, i);
+        IntegerArray_clear(nodes[i]->keys);
+        memcpy(nodes[i]->keys->items, group->keys + key_index, sizeof(uint64_t) * count);
+        nodes[i]->keys->size = count;
+
+        if (is_leaf) {
+            IntegerArray_clear(nodes[i]->data);
+            memcpy(nodes[i]->data->items, group->data + key_index, sizeof(uint64_t) * count);
+            nodes[i]->data->size = count;
+
+            if (i > 0) {
+                separators[i - 1] = group->keys[key_index];
+            }
+        } else {
+            memcpy(nodes[i]->children->items, group->children + child_index, sizeof(BPTreeNode *) * (count + 1));
+            nodes[i]->children->size = count + 1;
+            child_index += count + 1;
+
+            if (i < node_count - 1) {
+                separators[i] = group->keys[key_index + count];
+                key_index++;
+            }
+        }
+
+        key_index += count;
+    }
+}
+
+/**
+ * @brief Inserts information when the node is full and is not the real root, in the manner of a B* Tree. If one of
+ * the adjacent siblings is not full, the keys of the two nodes are shifted so that both have room, and the parent
+ * only gets a new separator. Otherwise the node and a full sibling are split into three nodes that are two thirds
+ * full, instead of one node into two nodes half full.
+ *
+ * @param parent The parent of the node.
+ * @param node The node.
+ * @param key The key to insert.
+ * @param data The data to insert.
+ * @param previous_split_right_node The node resulting from a previous split that must be inserted.
+ * @param split_right_node In this variable is assigned the node created, NULL if the keys have been shifted.
+ * @return uint64_t The key that separates the node created from its left sibling.
+ */
+static uint64_t insert_full_with_siblings(BPTreeNode *parent, BPTreeNode *node, uint64_t key, uint64_t data, BPTreeNode *previous_split_right_node, BPTreeNode **split_right_node) {
+    int index_in_children = BPTreeNodeArray_search(parent->children, node);
+    BPTreeNode *left_sibling = index_in_children > 0 ? parent->children->items[index_in_children - 1] : NULL;
+    BPTreeNode *right_sibling = index_in_children < parent->children->size - 1 ? parent->children->items[index_in_children + 1] : NULL;
+    int capacity = 2 * node->order;
+
+    // The right sibling is preferred, the left one is taken if there is no right sibling or if only the left one has room.
+    BPTreeNode *left_node = node;
+    BPTreeNode *right_node = right_sibling;
+    if (right_sibling == NULL || (right_sibling->keys->size == capacity && left_sibling != NULL && left_sibling->keys->size < capacity)) {
+        left_node = left_sibling;
+        right_node = node;
+    }
+
+    int separator_index = BPTreeNodeArray_search(parent->children, left_node);
+    // The group is on the stack unless the nodes are large, this is done for every insertion into a full node.
+    uint64_t stack_buffer[SIBLING_GROUP_STACK_BUFFER_LENGTH];
+    size_t group_size = compute_sibling_group_size(node->order);
+    uint64_t *buffer = group_size <= sizeof(stack_buffer) ? stack_buffer : (uint64_t *)malloc(group_size);
+    SiblingGroup group = gather_siblings(buffer, parent, left_node, right_node, key, data, previous_split_right_node);
+    uint64_t separators[2];
+
+    if (left_node->keys->size < capacity || right_node->keys->size < capacity) {
+        BPTreeNode *nodes[] = {left_node, right_node};
+        spread_siblings(&group, nodes, 2, separators);
+
+        if (buffer != stack_buffer) {
+            free(buffer);
+        }
+
+        parent->keys->items[separator_index] = separators[0];
+        *split_right_node = NULL;
+
+        if (node->is_leaf) {
+            BPTREE_COUNT(leaf_shifts, 1);
+        } else {
+            BPTREE_COUNT(internal_shifts, 1);
+        }
+
+        return key;
+    }
+
+    BPTreeNode *middle_node = BPTreeNode_init(node->order, node->is_leaf, node->arena);
+    BPTreeNode *nodes[] = {left_node, middle_node, right_node};
+    spread_siblings(&group, nodes, 3, separators);
+
+    if (buffer != stack_buffer) {
+        free(buffer);
+    }
+
+    if (node->is_leaf) {
+        BPTREE_COUNT(leaf_splits, 1);
+        // Maintains the linked list of leaf nodes.
+        middle_node->next = right_node;
+        left_node->next = middle_node;
+    } else {
+        BPTREE_COUNT(internal_splits, 1);
+    }
+
+    // The existing separator now precedes the right node, the middle node is inserted by the parent with the other one.
+    parent->keys->items[separator_index] = separators[1];
+    *split_right_node = middle_node;
+    return separators[0];
+}
+
 /**
  * @brief Insertion sub-function that performs the insertion recursively.
  *
@@ -329,13 +653,14 @@ static void grow(BPTreeNode *root, uint64_t median_value, BPTreeNode *split_righ
  * @param root The root node.
  * @param key The key to insert. A pointer is used for recursions.
  * @param data The data to be inserted with the key.
+ * @param replace true = if the key already exists its data is replaced, false = the existing key is left untouched.
  * @param split_right_node A pointer is used for recursions.
  * @return true The key has been inserted.
  * @return false The key has not been inserted.
  */
-static bool _BPTree_insert(BPTreeNode *parent, BPTreeNode *root, uint64_t *key, uint64_t data, BPTreeNode **split_right_node) {
+static bool _BPTree_insert(BPTreeNode *parent, BPTreeNode *root, uint64_t *key, uint64_t data, bool replace, BPTreeNode **split_right_node) {
     BPTreeNode *previous_split_right_node = NULL;
-    if (!root->is_leaf && !_BPTree_insert(root, traverse(root, *key), key, data, &previous_split_right_node)) {
+    if (!root->is_leaf && !_BPTree_insert(root, traverse(root, *key), key, data, replace, &previous_split_right_node)) {
         // The previous recursion indicates that it is not possible to insert the key.
         return false;
     }
@@ -344,6 +669,11 @@ static bool _BPTree_insert(BPTreeNode *parent, BPTreeNode *root, uint64_t *key,
     int index;
     bool is_found = IntegerArray_binary_search(root->keys, *key, &index);
     if (root->is_leaf && is_found) {
+        if (replace) {
+            // The data of the existing key is overwritten in its slot, the structure of the tree does not change.
+            root->data->items[index] = data;
+        }
+
         // The key cannot be inserted because it already exists.
         return false;
     }
@@ -362,20 +692,483 @@ static bool _BPTree_insert(BPTreeNode *parent, BPTreeNode *root, uint64_t *key,
         return true;
     }
 
-    // Inserts and splits the root node.
+    if (parent != NULL) {
+        // The node shares its keys with a sibling before being split.
+        *key = insert_full_with_siblings(parent, root, *key, data, previous_split_right_node, split_right_node);
+        return true;
+    }
+
+    // Inserts and splits the real root node, the tree must grow.
     *key = insert_full(root, *key, data, previous_split_right_node, split_right_node);
+    grow(root, *key, *split_right_node);
+    return true;
+}
+
+/**
+ * @brief Finds the last leaf of the B+ Tree, which holds the greatest keys. It is kept in the real root until the
+ * structure of the tree changes.
+ *
+ * @param root The real root node.
+ * @return BPTreeNode* The last leaf.
+ */
+static BPTreeNode *find_last_leaf(BPTreeNode *root) {
+    if (root->last_leaf == NULL) {
+        BPTreeNode *node = root;
+
+        while (!node->is_leaf) {
+            node = node->children->items[node->children->size - 1];
+        }
+
+        root->last_leaf = node;
+    }
+
+    return root->last_leaf;
+}
+
+/**
+ * @brief Splits the last node of a level when a key greater than all the keys of the tree is appended to it. The node
+ * keeps as many keys as possible and the new node, which becomes the last one of the level, starts with the minimum:
+ * the key alone for a leaf, the key and the last child of the node for an internal node.
+ *
+ * @param node The node to split, it is full.
+ * @param key The key to append.
+ * @param data The data to append, if the node is a leaf.
+ * @param previous_split_right_node The new last child, if the node is internal.
+ * @param split_right_node In this variable is assigned the right node split.
+ * @return uint64_t The key that separates the node from the right node.
+ */
+static uint64_t split_last_node(BPTreeNode *node, uint64_t key, uint64_t data, BPTreeNode *previous_split_right_node, BPTreeNode **split_right_node) {
+    *split_right_node = BPTreeNode_init(node->order, node->is_leaf, node->arena);
+    IntegerArray_append((*split_right_node)->keys, key);
+
+    if (node->is_leaf) {
+        BPTREE_COUNT(leaf_splits, 1);
+        IntegerArray_append((*split_right_node)->data, data);
+        // Maintains the linked list of leaf nodes.
+        node->next = *split_right_node;
+        return key;
+    }
+
+    BPTREE_COUNT(internal_splits, 1);
+    uint64_t separator = node->keys->items[node->keys->size - 1];
+    BPTreeNodeArray_append((*split_right_node)->children, node->children->items[node->children->size - 1]);
+    BPTreeNodeArray_append((*split_right_node)->children, previous_split_right_node);
+    IntegerArray_delete_at_index(node->keys, node->keys->size - 1);
+    BPTreeNodeArray_delete_at_index(node->children, node->children->size - 1);
+    return separator;
+}
+
+/**
+ * @brief Append sub-function that appends a key along the last nodes of the tree recursively, the last leaf is full.
+ *
+ * @param parent The parent of the root node.
+ * @param root The root node.
+ * @param key The key to append. A pointer is used for recursions.
+ * @param data The data to be appended with the key.
+ * @param split_right_node A pointer is used for recursions.
+ */
+static void _BPTree_append(BPTreeNode *parent, BPTreeNode *root, uint64_t *key, uint64_t data, BPTreeNode **split_right_node) {
+    BPTreeNode *previous_split_right_node = NULL;
+    *split_right_node = NULL;
+
+    if (!root->is_leaf) {
+        _BPTree_append(root, root->children->items[root->children->size - 1], key, data, &previous_split_right_node);
+
+        if (previous_split_right_node == NULL) {
+            return;
+        }
+    }
+
+    if (root->keys->size < 2 * root->order) {
+        // The key is greater than the others, it goes at the end of the node.
+        IntegerArray_append(root->keys, *key);
+        if (root->is_leaf) {
+            IntegerArray_append(root->data, data);
+        } else {
+            BPTreeNodeArray_append(root->children, previous_split_right_node);
+        }
+
+        return;
+    }
+
+    *key = split_last_node(root, *key, data, previous_split_right_node, split_right_node);
 
     if (parent == NULL) {
         // If the root node is the real root, the tree must grow.
         grow(root, *key, *split_right_node);
     }
+}
+
+/**
+ * @brief Appends a key to the last leaf if it is greater than all the keys of the tree, as happens when the keys are
+ * inserted in ascending order. The last leaf is found without traversing the tree, and it is split without sharing its
+ * keys so that the leaves left behind are full.
+ *
+ * @param root The real root node.
+ * @param key The key to append.
+ * @param data The data to be appended with the key.
+ * @return true The key has been appended.
+ * @return false The key is not greater than all the keys of the tree, it must be inserted.
+ */
+static bool append_to_last_leaf(BPTreeNode *root, uint64_t key, uint64_t data) {
+    BPTreeNode *leaf = find_last_leaf(root);
+
+    if (leaf->keys->size > 0 && key <= leaf->keys->items[leaf->keys->size - 1]) {
+        return false;
+    }
+
+    BPTREE_COUNT(appends, 1);
 
+    if (leaf->keys->size < 2 * leaf->order) {
+        IntegerArray_append(leaf->keys, key);
+        IntegerArray_append(leaf->data, data);
+        return true;
+    }
+
+    BPTreeNode *split_right_node;
+    _BPTree_append(NULL, root, &key, data, &split_right_node);
+    // The new last leaf is found again by the next append.
+    root->last_leaf = NULL;
     return true;
 }
 
+/**
+ * @brief Inserts a key from the real root, by appending it if possible.
+ *
+ * @param root The real root node.
+ * @param key The key to insert.
+ * @param data The data to be inserted with the key.
+ * @param replace true = if the key already exists its data is replaced.
+ * @return true The key has been inserted.
+ * @return false The key already exists.
+ */
+static bool insert_from_root(BPTreeNode *root, uint64_t key, uint64_t data, bool replace) {
+    if (append_to_last_leaf(root, key, data)) {
+        return true;
+    }
+
+    BPTreeNode *split_right_node;
+    return _BPTree_insert(NULL, root, &key, data, replace, &split_right_node);
+}
+
 bool BPTree_insert(BPTreeNode *root, uint64_t key, uint64_t data) {
-    BPTreeNode *previous_split_right_node;
-    return _BPTree_insert(NULL, root, &key, data, &previous_split_right_node);
+    bool is_inserted = insert_from_root(root, key, data, false);
+
+    if (is_inserted) {
+        BPTREE_COUNT(insertions, 1);
+    }
+
+    return is_inserted;
+}
+
+bool BPTree_upsert(BPTreeNode *root, uint64_t key, uint64_t data) {
+    bool is_inserted = insert_from_root(root, key, data, true);
+
+    if (is_inserted) {
+        BPTREE_COUNT(insertions, 1);
+    }
+
+    return is_inserted;
+}
+
+/**
+ * @brief Data structure that represents a key of a batch with its data and its position in the batch.
+ *
+ */
+typedef struct BatchItem {
+    uint64_t key;
+    uint64_t data;
+    int index;
+} BatchItem;
+
+/**
+ * @brief Compares two items of a batch by key, then by position so that the first occurrence of a key comes first.
+ *
+ * @param a The first item.
+ * @param b The second item.
+ * @return int A negative value if a comes first, a positive value if b comes first.
+ */
+static int compare_batch_items(const void *a, const void *b) {
+    const BatchItem *item_a = (const BatchItem *)a;
+    const BatchItem *item_b = (const BatchItem *)b;
+
+    if (item_a->key != item_b->key) {
+        return item_a->key < item_b->key ? -1 : 1;
+    }
+
+    return item_a->index - item_b->index;
+}
+
+/**
+ * @brief Data structure that represents a node of the path from the root to a leaf, along with the upper bound
+ * (excluded) of the keys that its subtree covers.
+ *
+ */
+typedef struct PathNode {
+    BPTreeNode *node;
+    bool has_upper_bound;
+    uint64_t upper_bound;
+} PathNode;
+
+/**
+ * @brief Computes the number of levels of the B+ Tree.
+ *
+ * @param root The root of the B+ Tree.
+ * @return int The number of levels, 1 if the root node is a leaf.
+ */
+static int compute_level_count(BPTreeNode *root) {
+    int level_count = 1;
+
+    for (BPTreeNode *node = root; !node->is_leaf; node = node->children->items[0]) {
+        level_count++;
+    }
+
+    return level_count;
+}
+
+/**
+ * @brief Merges sorted keys, which are not in the leaf, into a leaf that has room for them. The keys are moved from
+ * the end so that each key of the leaf moves only once.
+ *
+ * @param leaf The leaf.
+ * @param keys The keys to be inserted.
+ * @param data The data of the keys.
+ * @param count The number of keys.
+ */
+static void merge_into_leaf(BPTreeNode *leaf, uint64_t *keys, uint64_t *data, int count) {
+    int leaf_index = leaf->keys->size - 1;
+    int index = count - 1;
+
+    for (int i = leaf->keys->size + count - 1; index >= 0; i--) {
+        if (leaf_index >= 0 && leaf->keys->items[leaf_index] > keys[index]) {
+            leaf->keys->items[i] = leaf->keys->items[leaf_index];
+            leaf->data->items[i] = leaf->data->items[leaf_index];
+            leaf_index--;
+        } else {
+            leaf->keys->items[i] = keys[index];
+            leaf->data->items[i] = data[index];
+            index--;
+        }
+    }
+
+    leaf->keys->size += count;
+    leaf->data->size += count;
+}
+
+/**
+ * @brief Checks if an item of a sorted batch is overridden by another occurrence of its key: the first occurrence is
+ * kept by an insertion and the last one by an upsert, as if the keys were inserted one by one.
+ *
+ * @param items The sorted items of the batch.
+ * @param index The position of the item.
+ * @param count The number of items.
+ * @param replace true = the batch is an upsert.
+ * @return true The item must be skipped.
+ * @return false The item must be applied.
+ */
+static bool is_overridden(BatchItem *items, int index, int count, bool replace) {
+    if (replace) {
+        return index + 1 < count && items[index + 1].key == items[index].key;
+    }
+
+    return index > 0 && items[index - 1].key == items[index].key;
+}
+
+/**
+ * @brief Insertion sub-function that inserts a batch of keys.
+ *
+ * @param root The root of the B+ Tree.
+ * @param keys The keys to insert.
+ * @param data The data to be inserted with the keys.
+ * @param count The number of keys.
+ * @param replace true = the data of the keys that already exist is replaced.
+ * @return int The number of keys inserted.
+ */
+static int _BPTree_insert_batch(BPTreeNode *root, uint64_t *keys, uint64_t *data, int count, bool replace) {
+    BatchItem *items = (BatchItem *)malloc(sizeof(BatchItem) * (count > 0 ? count : 1));
+    for (int i = 0; i < count; i++) {
+        items[i] = (BatchItem){keys[i], data[i], i};
+    }
+
+    qsort(items, count, sizeof(BatchItem), compare_batch_items);
+
+    int level_count = compute_level_count(root);
+    PathNode *path = (PathNode *)malloc(sizeof(PathNode) * level_count);
+    path[0] = (PathNode){root, false, 0};
+    int path_length = 1;
+
+    uint64_t *run_keys = (uint64_t *)malloc(sizeof(uint64_t) * 2 * root->order);
+    uint64_t *run_data = (uint64_t *)malloc(sizeof(uint64_t) * 2 * root->order);
+    int inserted_count = 0;
+    int i = 0;
+
+    while (i < count) {
+        if (is_overridden(items, i, count, replace)) {
+            i++;
+            continue;
+        }
+
+        // The keys come in ascending order, the path is climbed until the subtree covers the key.
+        while (path_length > 1 && path[path_length - 1].has_upper_bound && items[i].key >= path[path_length - 1].upper_bound) {
+            path_length--;
+        }
+
+        while (!path[path_length - 1].node->is_leaf) {
+            PathNode *parent = &path[path_length - 1];
+            int child_index = IntegerArray_lower_bound(parent->node->keys, items[i].key);
+
+            if (child_index < parent->node->keys->size && parent->node->keys->items[child_index] == items[i].key) {
+                child_index++;
+            }
+
+            PathNode child = {parent->node->children->items[child_index], parent->has_upper_bound, parent->upper_bound};
+            if (child_index < parent->node->keys->size) {
+                child.has_upper_bound = true;
+                child.upper_bound = parent->node->keys->items[child_index];
+            }
+
+            path[path_length] = child;
+            path_length++;
+        }
+
+        PathNode *leaf = &path[path_length - 1];
+        int room = 2 * root->order - leaf->node->keys->size;
+        int run_count = 0;
+        int j = i;
+
+        // Gathers the following keys that belong to the same leaf, as many new keys as the leaf has room for.
+        while (j < count && (!leaf->has_upper_bound || items[j].key < leaf->upper_bound)) {
+            int index;
+
+            if (is_overridden(items, j, count, replace)) {
+                j++;
+                continue;
+            }
+
+            if (IntegerArray_binary_search(leaf->node->keys, items[j].key, &index)) {
+                if (replace) {
+                    leaf->node->data->items[index] = items[j].data;
+                }
+
+                j++;
+                continue;
+            }
+
+            if (run_count == room) {
+                break;
+            }
+
+            run_keys[run_count] = items[j].key;
+            run_data[run_count] = items[j].data;
+            run_count++;
+            j++;
+        }
+
+        if (j > i) {
+            merge_into_leaf(leaf->node, run_keys, run_data, run_count);
+            inserted_count += run_count;
+            i = j;
+            continue;
+        }
+
+        // The leaf is full, the key is inserted from the root so that the splits go up the tree.
+        if (insert_from_root(root, items[i].key, items[i].data, replace)) {
+            inserted_count++;
+        }
+
+        i++;
+        path_length = 1;
+
+        if (compute_level_count(root) > level_count) {
+            level_count = compute_level_count(root);
+            path = (PathNode *)realloc(path, sizeof(PathNode) * level_count);
+        }
+    }
+
+    BPTREE_COUNT(insertions, inserted_count);
+    free(run_keys);
+    free(run_data);
+    free(path);
+    free(items);
+    return inserted_count;
+}
+
+int BPTree_insert_batch(BPTreeNode *root, uint64_t *keys, uint64_t *data, int count) {
+    return _BPTree_insert_batch(root, keys, data, count, false);
+}
+
+int BPTree_upsert_batch(BPTreeNode *root, uint64_t *keys, uint64_t *data, int count) {
+    return _BPTree_insert_batch(root, keys, data, count, true);
+}
+
+// BPTree : Bulk load
+
+void BPTree_bulk_load(BPTreeNode *root, uint64_t *keys, uint64_t *data, int count) {
+    int capacity = 2 * root->order;
+
+    if (count <= capacity) {
+        memcpy(root->keys->items, keys, sizeof(uint64_t) * count);
+        memcpy(root->data->items, data, sizeof(uint64_t) * count);
+        root->keys->size = count;
+        root->data->size = count;
+        return;
+    }
+
+    // The leaves are full, apart from the remainder spread over them so that none holds fewer than order keys.
+    int level_size = (count + capacity - 1) / capacity;
+    BPTreeNode **level = (BPTreeNode **)malloc(sizeof(BPTreeNode *) * level_size);
+    // The smallest key of each subtree of the level, it separates the subtree from its left sibling in the parent.
+    uint64_t *smallest_keys = (uint64_t *)malloc(sizeof(uint64_t) * level_size);
+    int first = 0;
+
+    for (int i = 0; i < level_size; i++) {
+        int size = spread(count, level_size, i);
+        BPTreeNode *leaf = BPTreeNode_init(root->order, true, root->arena);
+        memcpy(leaf->keys->items, keys + first, sizeof(uint64_t) * size);
+        memcpy(leaf->data->items, data + first, sizeof(uint64_t) * size);
+        leaf->keys->size = size;
+        leaf->data->size = size;
+
+        if (i > 0) {
+            level[i - 1]->next = leaf;
+        }
+
+        level[i] = leaf;
+        smallest_keys[i] = keys[first];
+        first += size;
+    }
+
+    // Each level is built over the previous one, in place since a parent is never stored after its first child.
+    while (level_size > 1) {
+        int parent_count = (level_size + capacity) / (capacity + 1);
+        first = 0;
+
+        for (int i = 0; i < parent_count; i++) {
+            int size = spread(level_size, parent_count, i);
+            BPTreeNode *parent = BPTreeNode_init(root->order, false, root->arena);
+            memcpy(parent->children->items, level + first, sizeof(BPTreeNode *) * size);
+            memcpy(parent->keys->items, smallest_keys + first + 1, sizeof(uint64_t) * (size - 1));
+            parent->children->size = size;
+            parent->keys->size = size - 1;
+
+            level[i] = parent;
+            smallest_keys[i] = smallest_keys[first];
+            first += size;
+        }
+
+        level_size = parent_count;
+    }
+
+    // The top node is moved into the root, which remains the handle of the tree.
+    BPTreeNode *top = level[0];
+    root->is_leaf = false;
+    IntegerArray_copy(top->keys, root->keys);
+    BPTreeNodeArray_copy(top->children, root->children);
+    BPTreeNode_destroy(&top);
+    root->last_leaf = NULL;
+
+    free(level);
+    free(smallest_keys);
 }
 
 // BPTree : Deletion
@@ -400,6 +1193,7 @@ static uint64_t find_smallest_key(BPTreeNode *root) {
  * @param root The real root node of the tree.
  */
 static void shrink(BPTreeNode *root) {
+    BPTREE_COUNT(shrinks, 1);
     BPTreeNode *child = root->children->items[0];
     root->is_leaf = child->is_leaf;
 
@@ -468,6 +1262,7 @@ static bool is_sibling_left_side(BPTreeNode *parent, BPTreeNode *node, BPTreeNod
  * @param right_node The right node.
  */
 static void merge(BPTreeNode *parent, BPTreeNode *left_node, BPTreeNode *right_node) {
+    BPTREE_COUNT(merges, 1);
     // The right node is always merged into the left node.
     int index_in_children = BPTreeNodeArray_search(parent->children, left_node);
 
@@ -509,6 +1304,7 @@ static void merge(BPTreeNode *parent, BPTreeNode *left_node, BPTreeNode *right_n
  * @param sibling The sibling.
  */
 static void steal_leaf(BPTreeNode *parent, BPTreeNode *node, BPTreeNode *sibling) {
+    BPTREE_COUNT(leaf_steals, 1);
     int index_in_children = BPTreeNodeArray_search(parent->children, node);
 
     if (is_sibling_left_side(parent, node, sibling)) {
@@ -542,6 +1338,7 @@ static void steal_leaf(BPTreeNode *parent, BPTreeNode *node, BPTreeNode *sibling
  * @param sibling The sibling.
  */
 static void steal_internal(BPTreeNode *parent, BPTreeNode *node, BPTreeNode *sibling) {
+    BPTREE_COUNT(internal_steals, 1);
     int index_in_children = BPTreeNodeArray_search(parent->children, node);
 
     if (is_sibling_left_side(parent, node, sibling)) {
@@ -570,8 +1367,9 @@ static void steal_internal(BPTreeNode *parent, BPTreeNode *node, BPTreeNode *sib
 static void deletion_rebalance(BPTreeNode *parent, BPTreeNode *node) {
     BPTreeNode *sibling = find_sibling(parent, node);
 
-    if (sibling->keys->size == sibling->order) {
-        // The sibling does not have enough keys to steal one, a merge is required.
+    if (sibling->keys->size <= sibling->order) {
+        // The sibling does not have enough keys to steal one, a merge is required. The last node of a level may have
+        // fewer keys than the others.
         if (is_sibling_left_side(parent, node, sibling)) {
             merge(parent, sibling, node);
         } else {
@@ -632,5 +1430,13 @@ static bool _BPTree_delete(BPTreeNode *parent, BPTreeNode *root, uint64_t key) {
 }
 
 bool BPTree_delete(BPTreeNode *root, uint64_t key) {
-    return _BPTree_delete(NULL, root, key);
+    bool is_deleted = _BPTree_delete(NULL, root, key);
+
+    if (is_deleted) {
+        BPTREE_COUNT(deletions, 1);
+        // The last leaf may have been merged.
+        root->last_leaf = NULL;
+    }
+
+    return is_deleted;
 }
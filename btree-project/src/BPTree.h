@@ -11,6 +11,7 @@
 #include <stdint.h>
 
 #include "Array.h"
+#include "NodeArena.h"
 
 /**
  * @brief Data structure that represents a B+ Tree.
@@ -23,6 +24,10 @@ typedef struct BPTreeNode {
     IntegerArray *data;
     BPTreeNodeArray *children;
     struct BPTreeNode *next;
+    // Only used by the real root: the last leaf, where the keys inserted in ascending order are appended, NULL = unknown.
+    struct BPTreeNode *last_leaf;
+    // The arena shared by all the nodes of the tree, NULL = the nodes are allocated on the heap.
+    NodeArena *arena;
 } BPTreeNode;
 
 /**
@@ -33,6 +38,17 @@ typedef struct BPTreeNode {
  */
 BPTreeNode *BPTree_init(int order);
 
+/**
+ * @brief Initializes a B+ Tree whose nodes are allocated in an arena, each node with its keys, its data and its
+ * children in a single block. With huge pages, a random search touches fewer pages, so the addresses of its nodes
+ * are translated with fewer TLB misses. The tree is destroyed by unmapping the arena.
+ *
+ * @param order The order of the B+ Tree.
+ * @param pages The kind of pages of the arena.
+ * @return BPTreeNode* An empty B+ Tree.
+ */
+BPTreeNode *BPTree_init_in_arena(int order, NodeArenaPages pages);
+
 /**
  * @brief Destroys the B+ Tree and free its memory.
  *
@@ -48,6 +64,14 @@ void BPTree_destroy(BPTreeNode **root);
  */
 void BPTree_print(BPTreeNode *root, int depth);
 
+/**
+ * @brief Finds the leftmost leaf node, the start of the linked list of leaf nodes.
+ *
+ * @param root The root of the B+ Tree.
+ * @return BPTreeNode* The leftmost leaf node.
+ */
+BPTreeNode *BPTree_find_first_leaf(BPTreeNode *root);
+
 /**
  * @brief Searches for a key in the B+ Tree.
  *
@@ -60,7 +84,9 @@ void BPTree_print(BPTreeNode *root, int depth);
 bool BPTree_search(BPTreeNode *root, uint64_t key, uint64_t *data);
 
 /**
- * @brief Inserts a key in the B+ Tree.
+ * @brief Inserts a key in the B+ Tree. A key greater than all the keys of the tree is appended to the last leaf without
+ * traversing the tree, and the last leaf is then split so that it stays full, which is why the last node of each
+ * level may have fewer keys than the minimum.
  *
  * @param root The root of the B+ Tree.
  * @param key The key to insert.
@@ -70,6 +96,53 @@ bool BPTree_search(BPTreeNode *root, uint64_t key, uint64_t *data);
  */
 bool BPTree_insert(BPTreeNode *root, uint64_t key, uint64_t data);
 
+/**
+ * @brief Inserts a key in the B+ Tree or replaces its data if the key already exists.
+ *
+ * @param root The root of the B+ Tree.
+ * @param key The key to insert or update.
+ * @param data The data to be associated with the key.
+ * @return true The key did not exist and has been inserted.
+ * @return false The key already existed and its data has been replaced.
+ */
+bool BPTree_upsert(BPTreeNode *root, uint64_t key, uint64_t data);
+
+/**
+ * @brief Inserts many keys in the B+ Tree. The keys are sorted first, then the keys that belong to the same leaf are
+ * inserted together with a single descent from the root. The keys that already exist are left untouched, as well as
+ * the later occurrences of a key that appears several times in the batch.
+ *
+ * @param root The root of the B+ Tree.
+ * @param keys The keys to insert.
+ * @param data The data to be inserted with the keys, in the same order.
+ * @param count The number of keys.
+ * @return int The number of keys inserted.
+ */
+int BPTree_insert_batch(BPTreeNode *root, uint64_t *keys, uint64_t *data, int count);
+
+/**
+ * @brief Inserts many keys in the B+ Tree or replaces the data of the keys that already exist, like BPTree_insert_batch.
+ * When a key appears several times in the batch, its last occurrence is kept.
+ *
+ * @param root The root of the B+ Tree.
+ * @param keys The keys to insert or update.
+ * @param data The data to be associated with the keys, in the same order.
+ * @param count The number of keys.
+ * @return int The number of keys that did not exist and have been inserted.
+ */
+int BPTree_upsert_batch(BPTreeNode *root, uint64_t *keys, uint64_t *data, int count);
+
+/**
+ * @brief Builds the B+ Tree from sorted keys, level by level from the leaves, instead of inserting them one by one.
+ * The leaves are filled up, which suits a tree that is mostly searched.
+ *
+ * @param root The root of an empty B+ Tree.
+ * @param keys The keys in strictly ascending order.
+ * @param data The data of the keys, in the same order.
+ * @param count The number of keys.
+ */
+void BPTree_bulk_load(BPTreeNode *root, uint64_t *keys, uint64_t *data, int count);
+
 /**
  * @brief Deletes a key from the B+ Tree.
  *
@@ -0,0 +1,171 @@
+/**
+ * @file BPTreeStats.c
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#include "BPTreeStats.h"
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "BPTree.h"
+
+// The counters of each thread are chained together, they are never freed so that the counts of the finished threads remain.
+static BPTreeCounters *registered_counters = NULL;
+static pthread_mutex_t registered_counters_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+#ifdef BPTREE_STATS
+
+_Thread_local BPTreeCounters *BPTreeCounters_local = NULL;
+
+BPTreeCounters *BPTreeCounters_register() {
+    BPTreeCounters *counters = (BPTreeCounters *)calloc(1, sizeof(BPTreeCounters));
+
+    pthread_mutex_lock(&registered_counters_mutex);
+    counters->next = registered_counters;
+    registered_counters = counters;
+    pthread_mutex_unlock(&registered_counters_mutex);
+
+    BPTreeCounters_local = counters;
+    return counters;
+}
+
+#endif
+
+/**
+ * @brief Adds or resets the counters of one thread.
+ *
+ * @param src The counters of the thread.
+ * @param dest The sum, NULL to reset the counters of the thread.
+ */
+static void accumulate_counters(BPTreeCounters *src, BPTreeCounters *dest) {
+    uint64_t *src_fields = (uint64_t *)src;
+    int field_count = offsetof(BPTreeCounters, next) / sizeof(uint64_t);
+
+    for (int i = 0; i < field_count; i++) {
+        if (dest == NULL) {
+            __atomic_store_n(&src_fields[i], 0, __ATOMIC_RELAXED);
+        } else {
+            ((uint64_t *)dest)[i] += __atomic_load_n(&src_fields[i], __ATOMIC_RELAXED);
+        }
+    }
+}
+
+void BPTree_collect_counters(BPTreeCounters *counters) {
+    memset(counters, 0, sizeof(BPTreeCounters));
+
+    pthread_mutex_lock(&registered_counters_mutex);
+    for (BPTreeCounters *current = registered_counters; current != NULL; current = current->next) {
+        accumulate_counters(current, counters);
+    }
+    pthread_mutex_unlock(&registered_counters_mutex);
+}
+
+void BPTree_reset_counters() {
+    pthread_mutex_lock(&registered_counters_mutex);
+    for (BPTreeCounters *current = registered_counters; current != NULL; current = current->next) {
+        accumulate_counters(current, NULL);
+    }
+    pthread_mutex_unlock(&registered_counters_mutex);
+}
+
+/**
+ * @brief Finds out in which bucket of the histogram a node falls.
+ *
+ * @param node The node.
+ * @return int The index of the bucket.
+ */
+static int fill_bucket(BPTreeNode *node) {
+    int bucket = node->keys->size * BPTREE_FILL_HISTOGRAM_BUCKETS / (2 * node->order);
+    // A full node is counted in the last bucket.
+    return bucket < BPTREE_FILL_HISTOGRAM_BUCKETS ? bucket : BPTREE_FILL_HISTOGRAM_BUCKETS - 1;
+}
+
+/**
+ * @brief Sub-function of the shape computation that walks the tree recursively.
+ *
+ * @param root The root node.
+ * @param depth The depth of the root node.
+ * @param shape The shape being computed.
+ */
+static void _BPTree_compute_shape(BPTreeNode *root, int depth, BPTreeShape *shape) {
+    double fill = (double)root->keys->size / (2 * root->order);
+
+    if (root->is_leaf) {
+        shape->height = depth + 1;
+        shape->leaf_count++;
+        shape->key_count += root->keys->size;
+        shape->average_leaf_fill += fill;
+        shape->leaf_fill_histogram[fill_bucket(root)]++;
+        return;
+    }
+
+    shape->internal_count++;
+    shape->average_internal_fill += fill;
+    shape->internal_fill_histogram[fill_bucket(root)]++;
+
+    for (int i = 0; i < root->children->size; i++) {
+        _BPTree_compute_shape(root->children->items[i], depth + 1, shape);
+    }
+}
+
+void BPTree_compute_shape(BPTreeNode *root, BPTreeShape *shape) {
+    memset(shape, 0, sizeof(BPTreeShape));
+    _BPTree_compute_shape(root, 0, shape);
+
+    if (shape->leaf_count > 0) {
+        shape->average_leaf_fill /= shape->leaf_count;
+    }
+
+    if (shape->internal_count > 0) {
+        shape->average_internal_fill /= shape->internal_count;
+    }
+}
+
+/**
+ * @brief Displays a fill histogram on the console.
+ *
+ * @param title The title of the histogram.
+ * @param histogram The buckets of the histogram.
+ */
+static void print_fill_histogram(char *title, int histogram[BPTREE_FILL_HISTOGRAM_BUCKETS]) {
+    printf("%s\n", title);
+
+    for (int i = 0; i < BPTREE_FILL_HISTOGRAM_BUCKETS; i++) {
+        int bucket_width = 100 / BPTREE_FILL_HISTOGRAM_BUCKETS;
+        printf("    %3d%% - %3d%% : %d\n", i * bucket_width, (i + 1) * bucket_width, histogram[i]);
+    }
+}
+
+void BPTree_print_stats(BPTreeNode *root) {
+    BPTreeCounters counters;
+    BPTree_collect_counters(&counters);
+    BPTreeShape shape;
+    BPTree_compute_shape(root, &shape);
+
+    printf("Searches: %" PRIu64 "\n", counters.searches);
+    if (counters.searches > 0) {
+        printf("Nodes visited per search: %.2f\n", (double)counters.search_node_visits / counters.searches);
+        printf("Comparisons per search, at most: %.2f\n", (double)counters.search_comparison_bound / counters.searches);
+    }
+    printf("Insertions: %" PRIu64 ", of which appended: %" PRIu64 "\n", counters.insertions, counters.appends);
+    printf("Deletions: %" PRIu64 "\n", counters.deletions);
+    printf("Splits: %" PRIu64 " leaf, %" PRIu64 " internal\n", counters.leaf_splits, counters.internal_splits);
+    printf("Shifts: %" PRIu64 " leaf, %" PRIu64 " internal\n", counters.leaf_shifts, counters.internal_shifts);
+    printf("Steals: %" PRIu64 " leaf, %" PRIu64 " internal\n", counters.leaf_steals, counters.internal_steals);
+    printf("Merges: %" PRIu64 "\n", counters.merges);
+    printf("Grows: %" PRIu64 ", Shrinks: %" PRIu64 "\n", counters.grows, counters.shrinks);
+
+    printf("Height: %d\n", shape.height);
+    printf("Keys: %" PRIu64 "\n", shape.key_count);
+    printf("Nodes: %d leaf, %d internal\n", shape.leaf_count, shape.internal_count);
+    printf("Average fill: %.1f%% leaf, %.1f%% internal\n", shape.average_leaf_fill * 100, shape.average_internal_fill * 100);
+    print_fill_histogram("Leaf fill histogram:", shape.leaf_fill_histogram);
+    print_fill_histogram("Internal fill histogram:", shape.internal_fill_histogram);
+}
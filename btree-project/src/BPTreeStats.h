@@ -0,0 +1,110 @@
+/**
+ * @file BPTreeStats.h
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#ifndef BPTREE_STATS_H
+#define BPTREE_STATS_H
+
+#include <stdint.h>
+
+#include "BPTree.h"
+
+#define BPTREE_FILL_HISTOGRAM_BUCKETS 10
+
+/**
+ * @brief Data structure that represents the counters of the operations performed on B+ Trees.
+ *
+ */
+typedef struct BPTreeCounters {
+    uint64_t searches;
+    uint64_t search_node_visits;
+    // The sum of the maximum number of comparisons of the binary search of each node visited, not the comparisons made.
+    uint64_t search_comparison_bound;
+    uint64_t insertions;
+    uint64_t appends;
+    uint64_t deletions;
+    uint64_t leaf_splits;
+    uint64_t internal_splits;
+    uint64_t leaf_shifts;
+    uint64_t internal_shifts;
+    uint64_t merges;
+    uint64_t leaf_steals;
+    uint64_t internal_steals;
+    uint64_t grows;
+    uint64_t shrinks;
+    struct BPTreeCounters *next;
+} BPTreeCounters;
+
+/**
+ * @brief Data structure that represents the shape of a B+ Tree at a given moment.
+ *
+ */
+typedef struct BPTreeShape {
+    int height;
+    int leaf_count;
+    int internal_count;
+    uint64_t key_count;
+    double average_leaf_fill;
+    double average_internal_fill;
+    int leaf_fill_histogram[BPTREE_FILL_HISTOGRAM_BUCKETS];
+    int internal_fill_histogram[BPTREE_FILL_HISTOGRAM_BUCKETS];
+} BPTreeShape;
+
+#ifdef BPTREE_STATS
+
+extern _Thread_local BPTreeCounters *BPTreeCounters_local;
+
+/**
+ * @brief Allocates the counters of the calling thread and registers them for the aggregation.
+ *
+ * @return BPTreeCounters* The counters of the calling thread.
+ */
+BPTreeCounters *BPTreeCounters_register();
+
+// Only the owner thread writes its counters, the store is atomic so that the aggregation can read them at any time.
+#define BPTREE_COUNT(field, n)                                                             \
+    do {                                                                                   \
+        BPTreeCounters *counters_ = BPTreeCounters_local;                                  \
+        if (counters_ == NULL) {                                                           \
+            counters_ = BPTreeCounters_register();                                         \
+        }                                                                                  \
+        __atomic_store_n(&counters_->field, counters_->field + (n), __ATOMIC_RELAXED);     \
+    } while (0)
+
+#else
+
+#define BPTREE_COUNT(field, n) ((void)0)
+
+#endif
+
+/**
+ * @brief Sums the counters of all the threads. Everything is zero when compiled without BPTREE_STATS.
+ *
+ * @param counters The sum of the counters will be assigned to this variable.
+ */
+void BPTree_collect_counters(BPTreeCounters *counters);
+
+/**
+ * @brief Resets the counters of all the threads.
+ *
+ */
+void BPTree_reset_counters();
+
+/**
+ * @brief Walks the B+ Tree to compute its height, its number of nodes and how full the nodes are.
+ *
+ * @param root The root of the B+ Tree.
+ * @param shape The shape of the tree will be assigned to this variable.
+ */
+void BPTree_compute_shape(BPTreeNode *root, BPTreeShape *shape);
+
+/**
+ * @brief Displays the counters and the shape of the B+ Tree on the console.
+ *
+ * @param root The root of the B+ Tree.
+ */
+void BPTree_print_stats(BPTreeNode *root);
+
+#endif
@@ -0,0 +1,498 @@
+/**
+ * @file BPTreeTemplate.h
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ *
+ * B+ Tree specialized at compile time for a type of key and a type of data. The keys and the data are stored inline
+ * in the nodes, the number of keys of a node grows as the keys get smaller. It is a separate implementation from
+ * BPTree.h, which remains the B+ Tree of 64-bit keys: it has neither the batch insertion, nor the redistribution to
+ * the siblings of a full node, nor the append path of the last leaf, nor the node arenas. The file is included once
+ * per specialization, after the following macros have been defined:
+ *
+ *   BPTREE_NAME      The prefix of the generated types and functions, e.g. U32Tree gives U32TreeNode, U32Tree_insert...
+ *   BPTREE_KEY       The type of the keys.
+ *   BPTREE_DATA      The type of the data.
+ *   BPTREE_LESS      Optional, BPTREE_LESS(a, b) is true if key a is smaller than key b, the operator < by default.
+ *   BPTREE_KEYS_SIZE_IN_BYTES
+ *                    Optional, the size of the keys of a full node, 256 bytes by default.
+ *
+ * The macros are undefined at the end of the file.
+ */
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(BPTREE_NAME) || !defined(BPTREE_KEY) || !defined(BPTREE_DATA)
+#error "BPTREE_NAME, BPTREE_KEY and BPTREE_DATA must be defined before BPTreeTemplate.h is included."
+#endif
+
+#ifndef BPTREE_LESS
+#define BPTREE_LESS(a, b) ((a) < (b))
+#endif
+
+#ifndef BPTREE_KEYS_SIZE_IN_BYTES
+#define BPTREE_KEYS_SIZE_IN_BYTES 256
+#endif
+
+#ifndef BPTREE_CONCAT
+#define BPTREE_CONCAT_EXPANDED(a, b) a##b
+#define BPTREE_CONCAT(a, b) BPTREE_CONCAT_EXPANDED(a, b)
+#endif
+
+#define BPTREE_NODE BPTREE_CONCAT(BPTREE_NAME, Node)
+#define BPTREE_FUNCTION(name) BPTREE_CONCAT(BPTREE_NAME, _##name)
+#define BPTREE_ORDER BPTREE_FUNCTION(ORDER)
+
+// The order is the minimum number of keys of a node, except the root node, a node has at most 2 * order keys.
+enum { BPTREE_ORDER = BPTREE_KEYS_SIZE_IN_BYTES / sizeof(BPTREE_KEY) / 2 >= 2 ? BPTREE_KEYS_SIZE_IN_BYTES / sizeof(BPTREE_KEY) / 2 : 2 };
+
+/**
+ * @brief Data structure that represents a node of the B+ Tree. The arrays have room for one more key than allowed, the
+ * node is split once this extra key is used.
+ *
+ */
+typedef struct BPTREE_NODE {
+    bool is_leaf;
+    int size;
+    BPTREE_KEY keys[2 * BPTREE_ORDER + 1];
+    union {
+        BPTREE_DATA data[2 * BPTREE_ORDER + 1];
+        struct BPTREE_NODE *children[2 * BPTREE_ORDER + 2];
+    };
+    struct BPTREE_NODE *next;
+} BPTREE_NODE;
+
+/**
+ * @brief Allocates an empty node.
+ *
+ * @param is_leaf true = the node is a leaf.
+ * @return BPTREE_NODE* The allocated node.
+ */
+static inline BPTREE_NODE *BPTREE_FUNCTION(alloc_node)(bool is_leaf) {
+    BPTREE_NODE *node = (BPTREE_NODE *)malloc(sizeof(BPTREE_NODE));
+    node->is_leaf = is_leaf;
+    node->size = 0;
+    node->next = NULL;
+    return node;
+}
+
+/**
+ * @brief Initializes a B+ Tree.
+ *
+ * @return BPTREE_NODE* An empty B+ Tree.
+ */
+static inline BPTREE_NODE *BPTREE_FUNCTION(init)() {
+    return BPTREE_FUNCTION(alloc_node)(true);
+}
+
+/**
+ * @brief Destroys the B+ Tree and free its memory.
+ *
+ * @param root The root of the B+ Tree.
+ */
+static inline void BPTREE_FUNCTION(destroy)(BPTREE_NODE **root) {
+    if (!(*root)->is_leaf) {
+        for (int i = 0; i <= (*root)->size; i++) {
+            BPTREE_FUNCTION(destroy)(&(*root)->children[i]);
+        }
+    }
+
+    free(*root);
+    *root = NULL;
+}
+
+/**
+ * @brief Finds the first key of a node that is not smaller than the searched key.
+ *
+ * @param node The node.
+ * @param key The searched key.
+ * @return int The position of the key, the number of keys if they are all smaller.
+ */
+static inline int BPTREE_FUNCTION(lower_bound)(BPTREE_NODE *node, BPTREE_KEY key) {
+    int low = 0;
+    int high = node->size;
+
+    while (low < high) {
+        int middle = (low + high) / 2;
+
+        if (BPTREE_LESS(node->keys[middle], key)) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+/**
+ * @brief Finds the child of an internal node that covers a key.
+ *
+ * @param node The internal node.
+ * @param key The key.
+ * @return int The position of the child, that is the number of keys of the node that are not greater than the key.
+ */
+static inline int BPTREE_FUNCTION(find_child)(BPTREE_NODE *node, BPTREE_KEY key) {
+    int low = 0;
+    int high = node->size;
+
+    while (low < high) {
+        int middle = (low + high) / 2;
+
+        if (BPTREE_LESS(key, node->keys[middle])) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+
+    return low;
+}
+
+/**
+ * @brief Finds the leftmost leaf node.
+ *
+ * @param root The root of the B+ Tree.
+ * @return BPTREE_NODE* The leftmost leaf node, the leaves are then chained by their "next" field.
+ */
+static inline BPTREE_NODE *BPTREE_FUNCTION(find_first_leaf)(BPTREE_NODE *root) {
+    while (!root->is_leaf) {
+        root = root->children[0];
+    }
+
+    return root;
+}
+
+/**
+ * @brief Searches for a key in the B+ Tree.
+ *
+ * @param root The root of the B+ Tree.
+ * @param key The key to be searched.
+ * @param data The data associated with the key will be assigned to this variable.
+ * @return true The key exists in the B+ Tree.
+ * @return false The key does not exist in the B+ Tree.
+ */
+static inline bool BPTREE_FUNCTION(search)(BPTREE_NODE *root, BPTREE_KEY key, BPTREE_DATA *data) {
+    BPTREE_NODE *node = root;
+
+    while (!node->is_leaf) {
+        node = node->children[BPTREE_FUNCTION(find_child)(node, key)];
+    }
+
+    int index = BPTREE_FUNCTION(lower_bound)(node, key);
+
+    if (index == node->size || BPTREE_LESS(key, node->keys[index])) {
+        return false;
+    }
+
+    *data = node->data[index];
+    return true;
+}
+
+/**
+ * @brief Splits a leaf node that has one key too many, the upper half of its keys goes to a new leaf node.
+ *
+ * @param node The leaf node.
+ * @param split_key The first key of the new node will be assigned to this variable.
+ * @return BPTREE_NODE* The new node, on the right of the split node.
+ */
+static inline BPTREE_NODE *BPTREE_FUNCTION(split_leaf)(BPTREE_NODE *node, BPTREE_KEY *split_key) {
+    BPTREE_NODE *right = BPTREE_FUNCTION(alloc_node)(true);
+    right->size = node->size - BPTREE_ORDER;
+    memcpy(right->keys, node->keys + BPTREE_ORDER, sizeof(BPTREE_KEY) * right->size);
+    memcpy(right->data, node->data + BPTREE_ORDER, sizeof(BPTREE_DATA) * right->size);
+    node->size = BPTREE_ORDER;
+
+    right->next = node->next;
+    node->next = right;
+    *split_key = right->keys[0];
+    return right;
+}
+
+/**
+ * @brief Splits an internal node that has one key too many, its middle key moves up to the parent node.
+ *
+ * @param node The internal node.
+ * @param split_key The middle key will be assigned to this variable.
+ * @return BPTREE_NODE* The new node, on the right of the split node.
+ */
+static inline BPTREE_NODE *BPTREE_FUNCTION(split_internal)(BPTREE_NODE *node, BPTREE_KEY *split_key) {
+    BPTREE_NODE *right = BPTREE_FUNCTION(alloc_node)(false);
+    right->size = node->size - BPTREE_ORDER - 1;
+    memcpy(right->keys, node->keys + BPTREE_ORDER + 1, sizeof(BPTREE_KEY) * right->size);
+    memcpy(right->children, node->children + BPTREE_ORDER + 1, sizeof(BPTREE_NODE *) * (right->size + 1));
+    *split_key = node->keys[BPTREE_ORDER];
+    node->size = BPTREE_ORDER;
+    return right;
+}
+
+/**
+ * @brief Inserts a key into a subtree.
+ *
+ * @param node The root of the subtree.
+ * @param key The key to be inserted.
+ * @param data The data to be inserted.
+ * @param replace true = the data of a key that already exists is replaced.
+ * @param is_inserted false will be assigned to this variable if the key already exists.
+ * @param split_key The key that separates the node from its new right node will be assigned to this variable.
+ * @return BPTREE_NODE* The new right node if the node has been split, NULL otherwise.
+ */
+static inline BPTREE_NODE *BPTREE_FUNCTION(insert_into)(BPTREE_NODE *node, BPTREE_KEY key, BPTREE_DATA data, bool replace, bool *is_inserted, BPTREE_KEY *split_key) {
+    if (node->is_leaf) {
+        int index = BPTREE_FUNCTION(lower_bound)(node, key);
+
+        if (index < node->size && !BPTREE_LESS(key, node->keys[index])) {
+            // The key already exists.
+            if (replace) {
+                node->data[index] = data;
+            }
+
+            *is_inserted = false;
+            return NULL;
+        }
+
+        memmove(node->keys + index + 1, node->keys + index, sizeof(BPTREE_KEY) * (node->size - index));
+        memmove(node->data + index + 1, node->data + index, sizeof(BPTREE_DATA) * (node->size - index));
+        node->keys[index] = key;
+        node->data[index] = data;
+        node->size++;
+        *is_inserted = true;
+        return node->size > 2 * BPTREE_ORDER ? BPTREE_FUNCTION(split_leaf)(node, split_key) : NULL;
+    }
+
+    int index = BPTREE_FUNCTION(find_child)(node, key);
+    BPTREE_KEY child_split_key;
+    BPTREE_NODE *right = BPTREE_FUNCTION(insert_into)(node->children[index], key, data, replace, is_inserted, &child_split_key);
+
+    if (right == NULL) {
+        return NULL;
+    }
+
+    // The child has been split, the new child is inserted on its right.
+    memmove(node->keys + index + 1, node->keys + index, sizeof(BPTREE_KEY) * (node->size - index));
+    memmove(node->children + index + 2, node->children + index + 1, sizeof(BPTREE_NODE *) * (node->size - index));
+    node->keys[index] = child_split_key;
+    node->children[index + 1] = right;
+    node->size++;
+    return node->size > 2 * BPTREE_ORDER ? BPTREE_FUNCTION(split_internal)(node, split_key) : NULL;
+}
+
+/**
+ * @brief Inserts a key into the B+ Tree. When the root node is split, its content moves to a new node so that the
+ * root node remains the same.
+ *
+ * @param root The root of the B+ Tree.
+ * @param key The key to be inserted.
+ * @param data The data to be inserted.
+ * @param replace true = the data of a key that already exists is replaced.
+ * @return true The key has been inserted.
+ * @return false The key already exists.
+ */
+static inline bool BPTREE_FUNCTION(insert_or_replace)(BPTREE_NODE *root, BPTREE_KEY key, BPTREE_DATA data, bool replace) {
+    bool is_inserted;
+    BPTREE_KEY split_key;
+    BPTREE_NODE *right = BPTREE_FUNCTION(insert_into)(root, key, data, replace, &is_inserted, &split_key);
+
+    if (right != NULL) {
+        BPTREE_NODE *left = BPTREE_FUNCTION(alloc_node)(root->is_leaf);
+        *left = *root;
+        root->is_leaf = false;
+        root->size = 1;
+        root->keys[0] = split_key;
+        root->children[0] = left;
+        root->children[1] = right;
+        root->next = NULL;
+    }
+
+    return is_inserted;
+}
+
+/**
+ * @brief Inserts a key into the B+ Tree.
+ *
+ * @param root The root of the B+ Tree.
+ * @param key The key to be inserted.
+ * @param data The data to be inserted.
+ * @return true The key has been inserted.
+ * @return false The key already exists, the B+ Tree is unchanged.
+ */
+static inline bool BPTREE_FUNCTION(insert)(BPTREE_NODE *root, BPTREE_KEY key, BPTREE_DATA data) {
+    return BPTREE_FUNCTION(insert_or_replace)(root, key, data, false);
+}
+
+/**
+ * @brief Inserts a key into the B+ Tree, or replaces its data if it already exists.
+ *
+ * @param root The root of the B+ Tree.
+ * @param key The key.
+ * @param data The data.
+ * @return true The key has been inserted.
+ * @return false The key already existed, its data has been replaced.
+ */
+static inline bool BPTREE_FUNCTION(upsert)(BPTREE_NODE *root, BPTREE_KEY key, BPTREE_DATA data) {
+    return BPTREE_FUNCTION(insert_or_replace)(root, key, data, true);
+}
+
+/**
+ * @brief Moves the last key of the left sibling of a child into the child.
+ *
+ * @param parent The parent node.
+ * @param index The position of the child.
+ */
+static inline void BPTREE_FUNCTION(steal_from_left)(BPTREE_NODE *parent, int index) {
+    BPTREE_NODE *left = parent->children[index - 1];
+    BPTREE_NODE *child = parent->children[index];
+    memmove(child->keys + 1, child->keys, sizeof(BPTREE_KEY) * child->size);
+
+    if (child->is_leaf) {
+        memmove(child->data + 1, child->data, sizeof(BPTREE_DATA) * child->size);
+        child->keys[0] = left->keys[left->size - 1];
+        child->data[0] = left->data[left->size - 1];
+        parent->keys[index - 1] = child->keys[0];
+    } else {
+        // The key of the parent comes down and the last key of the left sibling goes up.
+        memmove(child->children + 1, child->children, sizeof(BPTREE_NODE *) * (child->size + 1));
+        child->keys[0] = parent->keys[index - 1];
+        child->children[0] = left->children[left->size];
+        parent->keys[index - 1] = left->keys[left->size - 1];
+    }
+
+    left->size--;
+    child->size++;
+}
+
+/**
+ * @brief Moves the first key of the right sibling of a child into the child.
+ *
+ * @param parent The parent node.
+ * @param index The position of the child.
+ */
+static inline void BPTREE_FUNCTION(steal_from_right)(BPTREE_NODE *parent, int index) {
+    BPTREE_NODE *child = parent->children[index];
+    BPTREE_NODE *right = parent->children[index + 1];
+
+    if (child->is_leaf) {
+        child->keys[child->size] = right->keys[0];
+        child->data[child->size] = right->data[0];
+        memmove(right->data, right->data + 1, sizeof(BPTREE_DATA) * (right->size - 1));
+        memmove(right->keys, right->keys + 1, sizeof(BPTREE_KEY) * (right->size - 1));
+        parent->keys[index] = right->keys[0];
+    } else {
+        // The key of the parent comes down and the first key of the right sibling goes up.
+        child->keys[child->size] = parent->keys[index];
+        child->children[child->size + 1] = right->children[0];
+        parent->keys[index] = right->keys[0];
+        memmove(right->keys, right->keys + 1, sizeof(BPTREE_KEY) * (right->size - 1));
+        memmove(right->children, right->children + 1, sizeof(BPTREE_NODE *) * right->size);
+    }
+
+    right->size--;
+    child->size++;
+}
+
+/**
+ * @brief Merges a child with its right sibling, the right sibling is destroyed.
+ *
+ * @param parent The parent node.
+ * @param index The position of the child.
+ */
+static inline void BPTREE_FUNCTION(merge)(BPTREE_NODE *parent, int index) {
+    BPTREE_NODE *left = parent->children[index];
+    BPTREE_NODE *right = parent->children[index + 1];
+
+    if (left->is_leaf) {
+        memcpy(left->keys + left->size, right->keys, sizeof(BPTREE_KEY) * right->size);
+        memcpy(left->data + left->size, right->data, sizeof(BPTREE_DATA) * right->size);
+        left->size += right->size;
+        left->next = right->next;
+    } else {
+        // The key of the parent that separates the two nodes comes down between their keys.
+        left->keys[left->size] = parent->keys[index];
+        memcpy(left->keys + left->size + 1, right->keys, sizeof(BPTREE_KEY) * right->size);
+        memcpy(left->children + left->size + 1, right->children, sizeof(BPTREE_NODE *) * (right->size + 1));
+        left->size += right->size + 1;
+    }
+
+    free(right);
+    memmove(parent->keys + index, parent->keys + index + 1, sizeof(BPTREE_KEY) * (parent->size - index - 1));
+    memmove(parent->children + index + 1, parent->children + index + 2, sizeof(BPTREE_NODE *) * (parent->size - index - 1));
+    parent->size--;
+}
+
+/**
+ * @brief Deletes a key from a subtree, a child that has too few keys left borrows a key from a sibling or is merged.
+ *
+ * @param node The root of the subtree.
+ * @param key The key to be deleted.
+ * @return true The key has been deleted.
+ * @return false The key does not exist.
+ */
+static inline bool BPTREE_FUNCTION(delete_from)(BPTREE_NODE *node, BPTREE_KEY key) {
+    if (node->is_leaf) {
+        int index = BPTREE_FUNCTION(lower_bound)(node, key);
+
+        if (index == node->size || BPTREE_LESS(key, node->keys[index])) {
+            return false;
+        }
+
+        memmove(node->keys + index, node->keys + index + 1, sizeof(BPTREE_KEY) * (node->size - index - 1));
+        memmove(node->data + index, node->data + index + 1, sizeof(BPTREE_DATA) * (node->size - index - 1));
+        node->size--;
+        return true;
+    }
+
+    int index = BPTREE_FUNCTION(find_child)(node, key);
+
+    if (!BPTREE_FUNCTION(delete_from)(node->children[index], key)) {
+        return false;
+    }
+
+    if (node->children[index]->size >= BPTREE_ORDER) {
+        return true;
+    }
+
+    if (index > 0 && node->children[index - 1]->size > BPTREE_ORDER) {
+        BPTREE_FUNCTION(steal_from_left)(node, index);
+    } else if (index < node->size && node->children[index + 1]->size > BPTREE_ORDER) {
+        BPTREE_FUNCTION(steal_from_right)(node, index);
+    } else if (index > 0) {
+        BPTREE_FUNCTION(merge)(node, index - 1);
+    } else {
+        BPTREE_FUNCTION(merge)(node, index);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Deletes a key from the B+ Tree. When the root node has a single child left, the content of the child moves to
+ * the root node so that the root node remains the same.
+ *
+ * @param root The root of the B+ Tree.
+ * @param key The key to be deleted.
+ * @return true The key has been deleted.
+ * @return false The key does not exist.
+ */
+static inline bool BPTREE_FUNCTION(delete)(BPTREE_NODE *root, BPTREE_KEY key) {
+    if (!BPTREE_FUNCTION(delete_from)(root, key)) {
+        return false;
+    }
+
+    if (!root->is_leaf && root->size == 0) {
+        BPTREE_NODE *child = root->children[0];
+        *root = *child;
+        free(child);
+    }
+
+    return true;
+}
+
+#undef BPTREE_NAME
+#undef BPTREE_KEY
+#undef BPTREE_DATA
+#undef BPTREE_LESS
+#undef BPTREE_KEYS_SIZE_IN_BYTES
+#undef BPTREE_NODE
+#undef BPTREE_FUNCTION
+#undef BPTREE_ORDER
@@ -0,0 +1,50 @@
+/**
+ * @file BPTreeTypes.h
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ *
+ * Specializations of the B+ Tree of BPTreeTemplate.h for the common types of keys. There is none for 64-bit keys and
+ * data, BPTree.h is the B+ Tree of these keys.
+ */
+#ifndef BPTREE_TYPES_H
+#define BPTREE_TYPES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Data structure that represents a 16-byte key, for example a longer prefix of a hash.
+ *
+ */
+typedef struct Key128 {
+    uint64_t high;
+    uint64_t low;
+} Key128;
+
+/**
+ * @brief Compares two 16-byte keys.
+ *
+ * @param a The first key.
+ * @param b The second key.
+ * @return true a is smaller than b.
+ * @return false a is greater than or equal to b.
+ */
+static inline bool Key128_less(Key128 a, Key128 b) {
+    return a.high < b.high || (a.high == b.high && a.low < b.low);
+}
+
+// 32-bit keys and data, a node holds 64 keys.
+#define BPTREE_NAME U32Tree
+#define BPTREE_KEY uint32_t
+#define BPTREE_DATA uint32_t
+#include "BPTreeTemplate.h"
+
+// 16-byte keys and 64-bit data, a node holds 16 keys.
+#define BPTREE_NAME Key128Tree
+#define BPTREE_KEY Key128
+#define BPTREE_DATA uint64_t
+#define BPTREE_LESS(a, b) Key128_less(a, b)
+#include "BPTreeTemplate.h"
+
+#endif
@@ -0,0 +1,155 @@
+/**
+ * @file BPTreeWriteBatch.c
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#include "BPTreeWriteBatch.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "BPTree.h"
+
+/**
+ * @brief Finds the slot of a key in the hash table, linear probing is used.
+ *
+ * @param batch The batch.
+ * @param key The key.
+ * @return BPTreeWrite* The slot of the key, or the empty slot where it would go.
+ */
+static BPTreeWrite *find_slot(BPTreeWriteBatch *batch, uint64_t key) {
+    // Fibonacci hashing, the high bits of the product are the best mixed.
+    uint64_t mask = batch->slot_count - 1;
+    uint64_t index = (key * 0x9E3779B97F4A7C15) >> 32 & mask;
+
+    while (batch->writes[index].type != BPTREE_WRITE_NONE && batch->writes[index].key != key) {
+        index = (index + 1) & mask;
+    }
+
+    return &batch->writes[index];
+}
+
+/**
+ * @brief Adds a modification to the batch, it replaces the previous modification of the key. The batch is applied
+ * when full.
+ *
+ * @param batch The batch.
+ * @param key The key.
+ * @param data The data of an upsert.
+ * @param type The type of modification.
+ */
+static void add_write(BPTreeWriteBatch *batch, uint64_t key, uint64_t data, uint8_t type) {
+    BPTreeWrite *write = find_slot(batch, key);
+
+    if (write->type == BPTREE_WRITE_NONE) {
+        batch->size++;
+    }
+
+    write->key = key;
+    write->data = data;
+    write->type = type;
+
+    if (batch->size == batch->capacity) {
+        BPTreeWriteBatch_flush(batch);
+    }
+}
+
+/**
+ * @brief Compares two modifications by key.
+ *
+ * @param a The first modification.
+ * @param b The second modification.
+ * @return int A negative value if a comes first, a positive value if b comes first.
+ */
+static int compare_writes(const void *a, const void *b) {
+    uint64_t key_a = ((const BPTreeWrite *)a)->key;
+    uint64_t key_b = ((const BPTreeWrite *)b)->key;
+    return key_a < key_b ? -1 : key_a > key_b;
+}
+
+BPTreeWriteBatch *BPTreeWriteBatch_init(BPTreeNode *root, int capacity) {
+    BPTreeWriteBatch *batch = (BPTreeWriteBatch *)malloc(sizeof(BPTreeWriteBatch));
+    batch->root = root;
+    batch->capacity = capacity > 0 ? capacity : 1;
+    batch->slot_count = 1;
+
+    while (batch->slot_count < 2 * batch->capacity) {
+        batch->slot_count *= 2;
+    }
+
+    batch->writes = (BPTreeWrite *)calloc(batch->slot_count, sizeof(BPTreeWrite));
+    batch->size = 0;
+    return batch;
+}
+
+void BPTreeWriteBatch_destroy(BPTreeWriteBatch **batch) {
+    BPTreeWriteBatch_flush(*batch);
+    free((*batch)->writes);
+    free(*batch);
+    *batch = NULL;
+}
+
+void BPTreeWriteBatch_upsert(BPTreeWriteBatch *batch, uint64_t key, uint64_t data) {
+    add_write(batch, key, data, BPTREE_WRITE_UPSERT);
+}
+
+void BPTreeWriteBatch_delete(BPTreeWriteBatch *batch, uint64_t key) {
+    add_write(batch, key, 0, BPTREE_WRITE_DELETE);
+}
+
+bool BPTreeWriteBatch_search(BPTreeWriteBatch *batch, uint64_t key, uint64_t *data) {
+    BPTreeWrite *write = find_slot(batch, key);
+
+    if (write->type == BPTREE_WRITE_UPSERT) {
+        *data = write->data;
+        return true;
+    }
+
+    if (write->type == BPTREE_WRITE_DELETE) {
+        return false;
+    }
+
+    return BPTree_search(batch->root, key, data);
+}
+
+void BPTreeWriteBatch_flush(BPTreeWriteBatch *batch) {
+    if (batch->size == 0) {
+        return;
+    }
+
+    // The modifications are packed at the start of the table, then sorted so that the B+ Tree is traversed in order.
+    int count = 0;
+    for (int i = 0; i < batch->slot_count; i++) {
+        if (batch->writes[i].type != BPTREE_WRITE_NONE) {
+            batch->writes[count] = batch->writes[i];
+            count++;
+        }
+    }
+
+    qsort(batch->writes, count, sizeof(BPTreeWrite), compare_writes);
+
+    uint64_t *keys = (uint64_t *)malloc(sizeof(uint64_t) * count);
+    uint64_t *data = (uint64_t *)malloc(sizeof(uint64_t) * count);
+    int upsert_count = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (batch->writes[i].type == BPTREE_WRITE_DELETE) {
+            BPTree_delete(batch->root, batch->writes[i].key);
+        } else {
+            keys[upsert_count] = batch->writes[i].key;
+            data[upsert_count] = batch->writes[i].data;
+            upsert_count++;
+        }
+    }
+
+    // Each key has a single modification, so the deletions and the upserts can be applied separately.
+    BPTree_upsert_batch(batch->root, keys, data, upsert_count);
+
+    free(keys);
+    free(data);
+    memset(batch->writes, 0, sizeof(BPTreeWrite) * batch->slot_count);
+    batch->size = 0;
+}
@@ -0,0 +1,101 @@
+/**
+ * @file BPTreeWriteBatch.h
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#ifndef BPTREE_WRITE_BATCH_H
+#define BPTREE_WRITE_BATCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "BPTree.h"
+
+#define BPTREE_WRITE_NONE 0
+#define BPTREE_WRITE_UPSERT 1
+#define BPTREE_WRITE_DELETE 2
+
+/**
+ * @brief Data structure that represents a pending modification of a key.
+ *
+ */
+typedef struct BPTreeWrite {
+    uint64_t key;
+    uint64_t data;
+    uint8_t type;
+} BPTreeWrite;
+
+/**
+ * @brief Data structure that represents a batch of modifications of a B+ Tree. The batch is a hash table that keeps the
+ * last modification of each key, once it is full the modifications are applied to the B+ Tree in the order of the
+ * keys, so the upserts that land in the same leaf share a single descent. It is only a batching helper, the nodes of
+ * the B+ Tree do not buffer anything: a search that is not answered by the batch descends the B+ Tree as usual.
+ *
+ */
+typedef struct BPTreeWriteBatch {
+    // The B+ Tree is not owned by the batch.
+    BPTreeNode *root;
+    BPTreeWrite *writes;
+    // The number of modifications after which the batch is applied.
+    int capacity;
+    // The size of the hash table, a power of 2 at least twice the capacity.
+    int slot_count;
+    int size;
+} BPTreeWriteBatch;
+
+/**
+ * @brief Initializes an empty batch of modifications of a B+ Tree.
+ *
+ * @param root The root of the B+ Tree.
+ * @param capacity The number of modifications that are kept before being applied to the B+ Tree.
+ * @return BPTreeWriteBatch* The empty batch.
+ */
+BPTreeWriteBatch *BPTreeWriteBatch_init(BPTreeNode *root, int capacity);
+
+/**
+ * @brief Applies the pending modifications to the B+ Tree, then destroys the batch and free its memory. The B+ Tree is
+ * not destroyed.
+ *
+ * @param batch The batch to be destroyed.
+ */
+void BPTreeWriteBatch_destroy(BPTreeWriteBatch **batch);
+
+/**
+ * @brief Inserts a key or replaces its data. The modification is only kept in the batch, whether the key existed is
+ * unknown.
+ *
+ * @param batch The batch.
+ * @param key The key to insert or update.
+ * @param data The data to be associated with the key.
+ */
+void BPTreeWriteBatch_upsert(BPTreeWriteBatch *batch, uint64_t key, uint64_t data);
+
+/**
+ * @brief Deletes a key if it exists. The modification is only kept in the batch.
+ *
+ * @param batch The batch.
+ * @param key The key to be deleted.
+ */
+void BPTreeWriteBatch_delete(BPTreeWriteBatch *batch, uint64_t key);
+
+/**
+ * @brief Searches for a key, the pending modification of the key takes precedence over the B+ Tree.
+ *
+ * @param batch The batch.
+ * @param key The key to search.
+ * @param data The data found will be assigned to this variable.
+ * @return true The key exists.
+ * @return false The key does not exist.
+ */
+bool BPTreeWriteBatch_search(BPTreeWriteBatch *batch, uint64_t key, uint64_t *data);
+
+/**
+ * @brief Applies the pending modifications to the B+ Tree and empties the batch. The B+ Tree must be flushed before it
+ * is read directly.
+ *
+ * @param batch The batch.
+ */
+void BPTreeWriteBatch_flush(BPTreeWriteBatch *batch);
+
+#endif
@@ -0,0 +1,121 @@
+/**
+ * @file Bitmap.c
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#include "Bitmap.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+Bitmap *Bitmap_init(int size) {
+    Bitmap *bitmap = (Bitmap *)malloc(sizeof(Bitmap));
+    bitmap->capacity = 64;
+    bitmap->size = 0;
+    bitmap->words = (uint64_t *)calloc(bitmap->capacity / 64, sizeof(uint64_t));
+    Bitmap_resize(bitmap, size);
+    return bitmap;
+}
+
+void Bitmap_destroy(Bitmap **bitmap) {
+    free((*bitmap)->words);
+    free(*bitmap);
+    *bitmap = NULL;
+}
+
+void Bitmap_resize(Bitmap *bitmap, int size) {
+    if (size > bitmap->capacity) {
+        int capacity = bitmap->capacity;
+        while (capacity < size) {
+            capacity *= 2;
+        }
+
+        bitmap->words = (uint64_t *)realloc(bitmap->words, sizeof(uint64_t) * (capacity / 64));
+        memset(bitmap->words + bitmap->capacity / 64, 0, sizeof(uint64_t) * ((capacity - bitmap->capacity) / 64));
+        bitmap->capacity = capacity;
+    }
+
+    // The bits beyond the size are always 0 so that the word-level operations can ignore the size.
+    for (int i = size; i < bitmap->size; i++) {
+        Bitmap_clear(bitmap, i);
+    }
+
+    bitmap->size = size;
+}
+
+void Bitmap_set(Bitmap *bitmap, int index) {
+    bitmap->words[index / 64] |= (uint64_t)1 << (index % 64);
+}
+
+void Bitmap_clear(Bitmap *bitmap, int index) {
+    bitmap->words[index / 64] &= ~((uint64_t)1 << (index % 64));
+}
+
+bool Bitmap_get(Bitmap *bitmap, int index) {
+    return (bitmap->words[index / 64] >> (index % 64)) & 1;
+}
+
+int Bitmap_count(Bitmap *bitmap) {
+    int count = 0;
+
+    for (int i = 0; i < (bitmap->size + 63) / 64; i++) {
+        count += __builtin_popcountll(bitmap->words[i]);
+    }
+
+    return count;
+}
+
+/**
+ * @brief Finds the first bit equal to a value from an index.
+ *
+ * @param bitmap The bitmap.
+ * @param from The index from which to search, included.
+ * @param value The value of the bit.
+ * @return int The index of the bit, -1 if there is none.
+ */
+static int find_next(Bitmap *bitmap, int from, bool value) {
+    if (from >= bitmap->size) {
+        return -1;
+    }
+
+    int i = from / 64;
+    // The word is inverted when searching for a 0, then the bits before "from" are ignored.
+    uint64_t word = (value ? bitmap->words[i] : ~bitmap->words[i]) & (~(uint64_t)0 << (from % 64));
+
+    while (word == 0) {
+        i++;
+
+        if (i >= (bitmap->size + 63) / 64) {
+            return -1;
+        }
+
+        word = value ? bitmap->words[i] : ~bitmap->words[i];
+    }
+
+    int index = i * 64 + __builtin_ctzll(word);
+    return index < bitmap->size ? index : -1;
+}
+
+int Bitmap_find_next_set(Bitmap *bitmap, int from) {
+    return find_next(bitmap, from, true);
+}
+
+int Bitmap_find_next_clear(Bitmap *bitmap, int from) {
+    return find_next(bitmap, from, false);
+}
+
+uint8_t Bitmap_get_byte(Bitmap *bitmap, int index) {
+    return (uint8_t)(bitmap->words[index / 8] >> (index % 8 * 8));
+}
+
+void Bitmap_set_byte(Bitmap *bitmap, int index, uint8_t byte) {
+    if (8 * (index + 1) > bitmap->size) {
+        Bitmap_resize(bitmap, 8 * (index + 1));
+    }
+
+    bitmap->words[index / 8] &= ~((uint64_t)255 << (index % 8 * 8));
+    bitmap->words[index / 8] |= (uint64_t)byte << (index % 8 * 8);
+}
@@ -0,0 +1,116 @@
+/**
+ * @file Bitmap.h
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#ifndef BITMAP_H
+#define BITMAP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Data structure that represents an array of bits, stored 64 per word.
+ *
+ */
+typedef struct Bitmap {
+    uint64_t *words;
+    int capacity;
+    int size;
+} Bitmap;
+
+/**
+ * @brief Initializes the "Bitmap" data structure with all its bits cleared.
+ *
+ * @param size The number of bits.
+ * @return Bitmap* The initialized bitmap.
+ */
+Bitmap *Bitmap_init(int size);
+
+/**
+ * @brief Destroys the bitmap and free its memory.
+ *
+ * @param bitmap The bitmap to be destroyed.
+ */
+void Bitmap_destroy(Bitmap **bitmap);
+
+/**
+ * @brief Changes the number of bits, the added bits are cleared.
+ *
+ * @param bitmap The bitmap.
+ * @param size The new number of bits.
+ */
+void Bitmap_resize(Bitmap *bitmap, int size);
+
+/**
+ * @brief Sets a bit to 1.
+ *
+ * @param bitmap The bitmap.
+ * @param index The index of the bit.
+ */
+void Bitmap_set(Bitmap *bitmap, int index);
+
+/**
+ * @brief Sets a bit to 0.
+ *
+ * @param bitmap The bitmap.
+ * @param index The index of the bit.
+ */
+void Bitmap_clear(Bitmap *bitmap, int index);
+
+/**
+ * @brief Gets the value of a bit.
+ *
+ * @param bitmap The bitmap.
+ * @param index The index of the bit.
+ * @return true The bit is 1.
+ * @return false The bit is 0.
+ */
+bool Bitmap_get(Bitmap *bitmap, int index);
+
+/**
+ * @brief Counts the bits set to 1.
+ *
+ * @param bitmap The bitmap.
+ * @return int The number of bits set to 1.
+ */
+int Bitmap_count(Bitmap *bitmap);
+
+/**
+ * @brief Finds the first bit set to 1 from an index, the bits are examined 64 at a time.
+ *
+ * @param bitmap The bitmap.
+ * @param from The index from which to search, included.
+ * @return int The index of the bit, -1 if there is none.
+ */
+int Bitmap_find_next_set(Bitmap *bitmap, int from);
+
+/**
+ * @brief Finds the first bit set to 0 from an index, the bits are examined 64 at a time.
+ *
+ * @param bitmap The bitmap.
+ * @param from The index from which to search, included.
+ * @return int The index of the bit, -1 if there is none.
+ */
+int Bitmap_find_next_clear(Bitmap *bitmap, int from);
+
+/**
+ * @brief Gets the byte that contains a bit, the bits of byte i are the bits 8i to 8i + 7.
+ *
+ * @param bitmap The bitmap.
+ * @param index The index of the byte.
+ * @return uint8_t The byte.
+ */
+uint8_t Bitmap_get_byte(Bitmap *bitmap, int index);
+
+/**
+ * @brief Replaces a byte of the bitmap, the bitmap is resized if needed.
+ *
+ * @param bitmap The bitmap.
+ * @param index The index of the byte.
+ * @param byte The new value of the byte.
+ */
+void Bitmap_set_byte(Bitmap *bitmap, int index, uint8_t byte);
+
+#endif
@@ -0,0 +1,80 @@
+/**
+ * @file BloomFilter.c
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#include "BloomFilter.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @brief Mixes the bits of a key to derive a second independent hash.
+ *
+ * @param key The key to mix.
+ * @return uint64_t The mixed key.
+ */
+static uint64_t mix(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdLLU;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53LLU;
+    key ^= key >> 33;
+    return key;
+}
+
+BloomFilter *BloomFilter_init(int capacity) {
+    if (capacity < BLOOM_FILTER_MIN_CAPACITY) {
+        capacity = BLOOM_FILTER_MIN_CAPACITY;
+    }
+
+    // The number of bits is rounded up to a power of 2 so that the position of a bit is computed with a mask.
+    uint64_t bit_count = 64;
+    while (bit_count < (uint64_t)capacity * BLOOM_FILTER_BITS_PER_ITEM) {
+        bit_count *= 2;
+    }
+
+    BloomFilter *filter = (BloomFilter *)malloc(sizeof(BloomFilter));
+    filter->bits = (uint64_t *)calloc(bit_count / 64, sizeof(uint64_t));
+    filter->mask = bit_count - 1;
+    filter->capacity = capacity;
+    filter->size = 0;
+    return filter;
+}
+
+void BloomFilter_destroy(BloomFilter **filter) {
+    free((*filter)->bits);
+    free(*filter);
+    *filter = NULL;
+}
+
+void BloomFilter_add(BloomFilter *filter, uint64_t key) {
+    // Double hashing: the i-th bit is h1 + i * h2. The key is mixed as well, the keys of the radix tree index are the
+    // digits of the phone numbers and their low bits are all 0.
+    uint64_t h1 = mix(key);
+    uint64_t h2 = mix(h1) | 1;
+
+    for (int i = 0; i < BLOOM_FILTER_HASH_COUNT; i++) {
+        uint64_t bit = (h1 + i * h2) & filter->mask;
+        filter->bits[bit / 64] |= (uint64_t)1 << (bit % 64);
+    }
+
+    filter->size++;
+}
+
+bool BloomFilter_may_contain(BloomFilter *filter, uint64_t key) {
+    uint64_t h1 = mix(key);
+    uint64_t h2 = mix(h1) | 1;
+
+    for (int i = 0; i < BLOOM_FILTER_HASH_COUNT; i++) {
+        uint64_t bit = (h1 + i * h2) & filter->mask;
+
+        if ((filter->bits[bit / 64] & ((uint64_t)1 << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
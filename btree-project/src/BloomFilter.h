@@ -0,0 +1,61 @@
+/**
+ * @file BloomFilter.h
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BLOOM_FILTER_BITS_PER_ITEM 10
+#define BLOOM_FILTER_HASH_COUNT 7
+#define BLOOM_FILTER_MIN_CAPACITY 128
+
+/**
+ * @brief Data structure that represents a Bloom filter over 64-bit keys.
+ *
+ */
+typedef struct BloomFilter {
+    uint64_t *bits;
+    uint64_t mask;
+    int capacity;
+    int size;
+} BloomFilter;
+
+/**
+ * @brief Initializes the "BloomFilter" data structure.
+ *
+ * @param capacity Number of keys the filter can hold before its false positive rate degrades.
+ * @return BloomFilter* An empty "BloomFilter".
+ */
+BloomFilter *BloomFilter_init(int capacity);
+
+/**
+ * @brief Destroys the filter and free its memory.
+ *
+ * @param filter The filter to be destroyed.
+ */
+void BloomFilter_destroy(BloomFilter **filter);
+
+/**
+ * @brief Adds a key to the filter.
+ *
+ * @param filter The filter in which the key is added.
+ * @param key The key to be added.
+ */
+void BloomFilter_add(BloomFilter *filter, uint64_t key);
+
+/**
+ * @brief Checks if a key may have been added to the filter.
+ *
+ * @param filter The filter in which the key is searched.
+ * @param key The sought-after key.
+ * @return true The key may have been added (false positives are possible).
+ * @return false The key has definitely not been added.
+ */
+bool BloomFilter_may_contain(BloomFilter *filter, uint64_t key);
+
+#endif
@@ -0,0 +1,332 @@
+/**
+ * @file ColumnStore.c
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#include "ColumnStore.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "Array.h"
+#include "DirectoryRecord.h"
+
+#define DELETED_COLUMN "deleted"
+#define PHONE_NUMBER_COLUMN "phone"
+#define NAME_COLUMN "name"
+#define SURNAME_COLUMN "surname"
+#define BIRTH_DATE_COLUMN "birth_date"
+
+// The largest packed birth date that can be compared with signed 32-bit comparisons.
+#define BIRTH_DATE_MAX 0x7ffffffe
+
+/**
+ * @brief Opens the file of a column.
+ *
+ * @param store The store.
+ * @param column The name of the column.
+ * @param mode The mode passed to fopen.
+ * @return FILE* The file, NULL if it cannot be opened.
+ */
+static FILE *open_column(ColumnStore *store, char *column, char *mode) {
+    char filename[COLUMN_STORE_FILENAME_MAXLEN + 16];
+    snprintf(filename, sizeof(filename), "%s.%s", store->name, column);
+    return fopen(filename, mode);
+}
+
+/**
+ * @brief Appends values to the file of a column.
+ *
+ * @param store The store.
+ * @param column The name of the column.
+ * @param values The bytes of the values.
+ * @param size The size of the values in bytes.
+ */
+static void append_values(ColumnStore *store, char *column, void *values, int size) {
+    FILE *fp = open_column(store, column, "ab");
+
+    if (fp == NULL) {
+        exit(EXIT_FAILURE);
+    }
+
+    fwrite(values, 1, size, fp);
+    fclose(fp);
+}
+
+/**
+ * @brief Reads the value of a slot from the file of a column.
+ *
+ * @param store The store.
+ * @param column The name of the column.
+ * @param slot The slot.
+ * @param value The bytes of the value will be assigned to this variable.
+ * @param size The size of the value.
+ */
+static void read_value(ColumnStore *store, char *column, int slot, void *value, int size) {
+    FILE *fp = open_column(store, column, "rb");
+
+    if (fp == NULL) {
+        exit(EXIT_FAILURE);
+    }
+
+    fseek(fp, (long)slot * size, SEEK_SET);
+    fread(value, 1, size, fp);
+    fclose(fp);
+}
+
+ColumnStore *ColumnStore_init(char name[COLUMN_STORE_FILENAME_MAXLEN]) {
+    ColumnStore *store = (ColumnStore *)malloc(sizeof(ColumnStore));
+    strcpy(store->name, name);
+    store->size = 0;
+
+    // The number of records is given by the size of any column, the "deleted" column has 1 byte per record.
+    FILE *fp = open_column(store, DELETED_COLUMN, "rb");
+
+    if (fp != NULL) {
+        fseek(fp, 0, SEEK_END);
+        store->size = (int)ftell(fp);
+        fclose(fp);
+    }
+
+    return store;
+}
+
+void ColumnStore_destroy(ColumnStore **store) {
+    free(*store);
+    *store = NULL;
+}
+
+void ColumnStore_clear(ColumnStore *store) {
+    char *columns[] = {DELETED_COLUMN, PHONE_NUMBER_COLUMN, NAME_COLUMN, SURNAME_COLUMN, BIRTH_DATE_COLUMN};
+
+    for (int i = 0; i < 5; i++) {
+        FILE *fp = open_column(store, columns[i], "wb");
+
+        if (fp != NULL) {
+            fclose(fp);
+        }
+    }
+
+    store->size = 0;
+}
+
+uint32_t ColumnStore_pack_birth_date(int year, int month, int day) {
+    // 5 bits for the day, 4 bits for the month and the rest for the year.
+    return (uint32_t)year << 9 | (uint32_t)month << 5 | (uint32_t)day;
+}
+
+int ColumnStore_append(ColumnStore *store, DirectoryRecord *record) {
+    ColumnStore_append_batch(store, &record, 1);
+    return store->size - 1;
+}
+
+void ColumnStore_append_batch(ColumnStore *store, DirectoryRecord **records, int count) {
+    uint8_t *deleted = (uint8_t *)malloc(count);
+    char *phone_numbers = (char *)malloc(PHONE_NUMBER_MAXLEN_WITHOUT_NULL_CHARACTER * count);
+    char *names = (char *)malloc(NAME_MAXLEN_WITHOUT_NULL_CHARACTER * count);
+    char *surnames = (char *)malloc(SURNAME_MAXLEN_WITHOUT_NULL_CHARACTER * count);
+    uint32_t *birth_dates = (uint32_t *)malloc(sizeof(uint32_t) * count);
+
+    // The values of each column are gathered so that each file is written once.
+    for (int i = 0; i < count; i++) {
+        DirectoryRecord *record = records[i];
+        deleted[i] = (uint8_t)record->is_deleted;
+        memcpy(phone_numbers + i * PHONE_NUMBER_MAXLEN_WITHOUT_NULL_CHARACTER, record->phone_number, PHONE_NUMBER_MAXLEN_WITHOUT_NULL_CHARACTER);
+        memcpy(names + i * NAME_MAXLEN_WITHOUT_NULL_CHARACTER, record->name, NAME_MAXLEN_WITHOUT_NULL_CHARACTER);
+        memcpy(surnames + i * SURNAME_MAXLEN_WITHOUT_NULL_CHARACTER, record->surname, SURNAME_MAXLEN_WITHOUT_NULL_CHARACTER);
+        birth_dates[i] = ColumnStore_pack_birth_date(record->birth_date_year, record->birth_date_month, record->birth_date_day);
+    }
+
+    append_values(store, DELETED_COLUMN, deleted, count);
+    append_values(store, PHONE_NUMBER_COLUMN, phone_numbers, PHONE_NUMBER_MAXLEN_WITHOUT_NULL_CHARACTER * count);
+    append_values(store, NAME_COLUMN, names, NAME_MAXLEN_WITHOUT_NULL_CHARACTER * count);
+    append_values(store, SURNAME_COLUMN, surnames, SURNAME_MAXLEN_WITHOUT_NULL_CHARACTER * count);
+    append_values(store, BIRTH_DATE_COLUMN, birth_dates, sizeof(uint32_t) * count);
+    store->size += count;
+
+    free(deleted);
+    free(phone_numbers);
+    free(names);
+    free(surnames);
+    free(birth_dates);
+}
+
+DirectoryRecord *ColumnStore_read(ColumnStore *store, int slot) {
+    uint8_t is_deleted;
+    char phone_number[PHONE_NUMBER_MAXLEN] = {0};
+    char name[NAME_MAXLEN] = {0};
+    char surname[SURNAME_MAXLEN] = {0};
+    uint32_t birth_date;
+
+    read_value(store, DELETED_COLUMN, slot, &is_deleted, 1);
+    read_value(store, PHONE_NUMBER_COLUMN, slot, phone_number, PHONE_NUMBER_MAXLEN_WITHOUT_NULL_CHARACTER);
+    read_value(store, NAME_COLUMN, slot, name, NAME_MAXLEN_WITHOUT_NULL_CHARACTER);
+    read_value(store, SURNAME_COLUMN, slot, surname, SURNAME_MAXLEN_WITHOUT_NULL_CHARACTER);
+    read_value(store, BIRTH_DATE_COLUMN, slot, &birth_date, sizeof(uint32_t));
+
+    return DirectoryRecord_init((bool)is_deleted, phone_number, name, surname, birth_date >> 9, (birth_date >> 5) & 15, birth_date & 31);
+}
+
+void ColumnStore_delete(ColumnStore *store, int slot) {
+    FILE *fp = open_column(store, DELETED_COLUMN, "r+b");
+
+    if (fp == NULL) {
+        exit(EXIT_FAILURE);
+    }
+
+    uint8_t is_deleted = (uint8_t) true;
+    fseek(fp, slot, SEEK_SET);
+    fwrite(&is_deleted, 1, 1, fp);
+    fclose(fp);
+}
+
+/**
+ * @brief Computes which dates of a block are in the range and belong to records that are not deleted.
+ *
+ * @param dates The packed birth dates.
+ * @param deleted The "deleted" bytes.
+ * @param from The first date, included.
+ * @param to The last date, included.
+ * @param matches The match of each date will be assigned to this array.
+ * @param size The number of dates.
+ * @return int The number of matches.
+ */
+static int match_born_between(uint32_t *dates, uint8_t *deleted, uint32_t from, uint32_t to, bool *matches, int size) {
+    int count = 0;
+    int i = 0;
+
+#ifdef __SSE2__
+    // 4 dates are compared at once, the dates fit in 31 bits so the signed comparisons are correct.
+    __m128i lower = _mm_set1_epi32((int32_t)from - 1);
+    __m128i upper = _mm_set1_epi32((int32_t)to + 1);
+
+    for (; i + 4 <= size; i += 4) {
+        __m128i values = _mm_loadu_si128((__m128i *)(dates + i));
+        __m128i is_in_range = _mm_and_si128(_mm_cmpgt_epi32(values, lower), _mm_cmplt_epi32(values, upper));
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(is_in_range));
+
+        for (int j = 0; j < 4; j++) {
+            matches[i + j] = ((mask >> j) & 1) && !deleted[i + j];
+            count += matches[i + j];
+        }
+    }
+#endif
+
+    for (; i < size; i++) {
+        matches[i] = dates[i] >= from && dates[i] <= to && !deleted[i];
+        count += matches[i];
+    }
+
+    return count;
+}
+
+/**
+ * @brief Scans the "deleted" and "birth_date" columns block by block.
+ *
+ * @param store The store.
+ * @param from The first date, included.
+ * @param to The last date, included.
+ * @param slots The matching slots are appended to this array, NULL to only count them.
+ * @return int The number of matching records.
+ */
+static int scan_born_between(ColumnStore *store, uint32_t from, uint32_t to, IntegerArray *slots) {
+    if (to > BIRTH_DATE_MAX) {
+        to = BIRTH_DATE_MAX;
+    }
+
+    if (store->size == 0 || from > to) {
+        return 0;
+    }
+
+    FILE *deleted_fp = open_column(store, DELETED_COLUMN, "rb");
+    FILE *dates_fp = open_column(store, BIRTH_DATE_COLUMN, "rb");
+
+    if (deleted_fp == NULL || dates_fp == NULL) {
+        exit(EXIT_FAILURE);
+    }
+
+    uint8_t *deleted = (uint8_t *)malloc(COLUMN_STORE_SCAN_BLOCK_SIZE);
+    uint32_t *dates = (uint32_t *)malloc(sizeof(uint32_t) * COLUMN_STORE_SCAN_BLOCK_SIZE);
+    bool *matches = (bool *)malloc(sizeof(bool) * COLUMN_STORE_SCAN_BLOCK_SIZE);
+    int count = 0;
+
+    for (int base = 0; base < store->size; base += COLUMN_STORE_SCAN_BLOCK_SIZE) {
+        int size = store->size - base < COLUMN_STORE_SCAN_BLOCK_SIZE ? store->size - base : COLUMN_STORE_SCAN_BLOCK_SIZE;
+        fread(deleted, 1, size, deleted_fp);
+        fread(dates, sizeof(uint32_t), size, dates_fp);
+
+        int block_count = match_born_between(dates, deleted, from, to, matches, size);
+        count += block_count;
+
+        for (int i = 0; slots != NULL && block_count > 0 && i < size; i++) {
+            if (matches[i]) {
+                IntegerArray_append(slots, base + i);
+            }
+        }
+    }
+
+    free(deleted);
+    free(dates);
+    free(matches);
+    fclose(deleted_fp);
+    fclose(dates_fp);
+    return count;
+}
+
+int ColumnStore_count_born_between(ColumnStore *store, uint32_t from, uint32_t to) {
+    return scan_born_between(store, from, to, NULL);
+}
+
+IntegerArray *ColumnStore_select_born_between(ColumnStore *store, uint32_t from, uint32_t to) {
+    IntegerArray *slots = IntegerArray_init(store->size);
+    scan_born_between(store, from, to, slots);
+    return slots;
+}
+
+IntegerArray *ColumnStore_select_by_surname(ColumnStore *store, char surname[SURNAME_MAXLEN]) {
+    IntegerArray *slots = IntegerArray_init(store->size);
+
+    if (store->size == 0) {
+        return slots;
+    }
+
+    FILE *deleted_fp = open_column(store, DELETED_COLUMN, "rb");
+    FILE *surnames_fp = open_column(store, SURNAME_COLUMN, "rb");
+
+    if (deleted_fp == NULL || surnames_fp == NULL) {
+        exit(EXIT_FAILURE);
+    }
+
+    // The surname is padded with null characters like in the column.
+    char padded_surname[SURNAME_MAXLEN_WITHOUT_NULL_CHARACTER] = {0};
+    strncpy(padded_surname, surname, SURNAME_MAXLEN_WITHOUT_NULL_CHARACTER);
+
+    uint8_t *deleted = (uint8_t *)malloc(COLUMN_STORE_SCAN_BLOCK_SIZE);
+    char *surnames = (char *)malloc(SURNAME_MAXLEN_WITHOUT_NULL_CHARACTER * COLUMN_STORE_SCAN_BLOCK_SIZE);
+
+    for (int base = 0; base < store->size; base += COLUMN_STORE_SCAN_BLOCK_SIZE) {
+        int size = store->size - base < COLUMN_STORE_SCAN_BLOCK_SIZE ? store->size - base : COLUMN_STORE_SCAN_BLOCK_SIZE;
+        fread(deleted, 1, size, deleted_fp);
+        fread(surnames, SURNAME_MAXLEN_WITHOUT_NULL_CHARACTER, size, surnames_fp);
+
+        for (int i = 0; i < size; i++) {
+            if (!deleted[i] && memcmp(surnames + i * SURNAME_MAXLEN_WITHOUT_NULL_CHARACTER, padded_surname, SURNAME_MAXLEN_WITHOUT_NULL_CHARACTER) == 0) {
+                IntegerArray_append(slots, base + i);
+            }
+        }
+    }
+
+    free(deleted);
+    free(surnames);
+    fclose(deleted_fp);
+    fclose(surnames_fp);
+    return slots;
+}
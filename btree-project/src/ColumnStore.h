@@ -0,0 +1,130 @@
+/**
+ * @file ColumnStore.h
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#ifndef COLUMN_STORE_H
+#define COLUMN_STORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "Array.h"
+#include "DirectoryRecord.h"
+
+#define COLUMN_STORE_FILENAME_MAXLEN 100
+#define COLUMN_STORE_SCAN_BLOCK_SIZE 4096
+
+/**
+ * @brief Data structure that represents records stored column by column. Each field has its own file of fixed-size
+ * values, the record in slot i is made of the i-th value of each file:
+ *   <name>.deleted    : 1 byte per record, 1 = the record is deleted.
+ *   <name>.phone      : the phone number.
+ *   <name>.name       : the name.
+ *   <name>.surname    : the surname.
+ *   <name>.birth_date : the packed birth date, see ColumnStore_pack_birth_date.
+ *
+ */
+typedef struct ColumnStore {
+    char name[COLUMN_STORE_FILENAME_MAXLEN];
+    int size;
+} ColumnStore;
+
+/**
+ * @brief Initializes the "ColumnStore" data structure, the existing column files are reused.
+ *
+ * @param name The name of the store, the column files are named after it.
+ * @return ColumnStore* The initialized store.
+ */
+ColumnStore *ColumnStore_init(char name[COLUMN_STORE_FILENAME_MAXLEN]);
+
+/**
+ * @brief Destroys the store and free its memory, the column files are kept.
+ *
+ * @param store The store to be destroyed.
+ */
+void ColumnStore_destroy(ColumnStore **store);
+
+/**
+ * @brief Removes all the records of the store.
+ *
+ * @param store The store to be cleared.
+ */
+void ColumnStore_clear(ColumnStore *store);
+
+/**
+ * @brief Packs a birth date into an integer, the order of the integers is the chronological order.
+ *
+ * @param year The year.
+ * @param month The month.
+ * @param day The day.
+ * @return uint32_t The packed birth date.
+ */
+uint32_t ColumnStore_pack_birth_date(int year, int month, int day);
+
+/**
+ * @brief Appends a record to the store.
+ *
+ * @param store The store.
+ * @param record The record to be added.
+ * @return int The slot of the record.
+ */
+int ColumnStore_append(ColumnStore *store, DirectoryRecord *record);
+
+/**
+ * @brief Appends many records to the store, each column file is written once.
+ *
+ * @param store The store.
+ * @param records The records to be added, they take the slots following the last one.
+ * @param count The number of records.
+ */
+void ColumnStore_append_batch(ColumnStore *store, DirectoryRecord **records, int count);
+
+/**
+ * @brief Reads the record of a slot, all its columns are read.
+ *
+ * @param store The store.
+ * @param slot The slot of the record.
+ * @return DirectoryRecord* The record.
+ */
+DirectoryRecord *ColumnStore_read(ColumnStore *store, int slot);
+
+/**
+ * @brief Marks the record of a slot as deleted.
+ *
+ * @param store The store.
+ * @param slot The slot of the record.
+ */
+void ColumnStore_delete(ColumnStore *store, int slot);
+
+/**
+ * @brief Counts the records born between two dates, only the "deleted" and "birth_date" columns are read.
+ *
+ * @param store The store.
+ * @param from The first date, included, packed with ColumnStore_pack_birth_date.
+ * @param to The last date, included, packed with ColumnStore_pack_birth_date.
+ * @return int The number of records.
+ */
+int ColumnStore_count_born_between(ColumnStore *store, uint32_t from, uint32_t to);
+
+/**
+ * @brief Finds the slots of the records born between two dates, only the "deleted" and "birth_date" columns are read.
+ *
+ * @param store The store.
+ * @param from The first date, included, packed with ColumnStore_pack_birth_date.
+ * @param to The last date, included, packed with ColumnStore_pack_birth_date.
+ * @return IntegerArray* The slots of the records, in ascending order.
+ */
+IntegerArray *ColumnStore_select_born_between(ColumnStore *store, uint32_t from, uint32_t to);
+
+/**
+ * @brief Finds the slots of the records with the given surname, only the "deleted" and "surname" columns are read.
+ *
+ * @param store The store.
+ * @param surname The surname.
+ * @return IntegerArray* The slots of the records, in ascending order.
+ */
+IntegerArray *ColumnStore_select_by_surname(ColumnStore *store, char surname[SURNAME_MAXLEN]);
+
+#endif
@@ -0,0 +1,114 @@
+/**
+ * @file Crc32c.c
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#include "Crc32c.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+// The reversed Castagnoli polynomial.
+#define CRC32C_POLYNOMIAL 0x82F63B78
+
+static uint32_t table[256];
+static bool has_sse4_2;
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Fills the lookup table and finds out whether the processor has the crc32 instruction.
+ *
+ */
+static void setup() {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+
+        for (int j = 0; j < 8; j++) {
+            crc = (crc >> 1) ^ (crc & 1 ? CRC32C_POLYNOMIAL : 0);
+        }
+
+        table[i] = crc;
+    }
+
+#if defined(__x86_64__)
+    has_sse4_2 = __builtin_cpu_supports("sse4.2");
+#else
+    has_sse4_2 = false;
+#endif
+}
+
+/**
+ * @brief Computes the checksum one byte at a time with the lookup table.
+ *
+ * @param crc The checksum of the previous bytes.
+ * @param bytes The array of bytes.
+ * @param size The number of bytes.
+ * @return uint32_t The updated checksum.
+ */
+static uint32_t update_with_table(uint32_t crc, const uint8_t *bytes, int size) {
+    for (int i = 0; i < size; i++) {
+        crc = (crc >> 8) ^ table[(crc ^ bytes[i]) & 0xFF];
+    }
+
+    return crc;
+}
+
+#if defined(__x86_64__)
+/**
+ * @brief Computes the checksum 8 bytes at a time with the crc32 instruction.
+ *
+ * @param crc The checksum of the previous bytes.
+ * @param bytes The array of bytes.
+ * @param size The number of bytes.
+ * @return uint32_t The updated checksum.
+ */
+__attribute__((target("sse4.2"))) static uint32_t update_with_sse4_2(uint32_t crc, const uint8_t *bytes, int size) {
+    uint64_t crc64 = crc;
+    int i = 0;
+
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        // The records are not aligned, memcpy avoids unaligned accesses.
+        memcpy(&word, bytes + i, sizeof(uint64_t));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+
+    crc = (uint32_t)crc64;
+
+    for (; i < size; i++) {
+        crc = _mm_crc32_u8(crc, bytes[i]);
+    }
+
+    return crc;
+}
+#endif
+
+uint32_t Crc32c_compute(const uint8_t *bytes, int size) {
+    return Crc32c_update(0, bytes, size);
+}
+
+uint32_t Crc32c_update(uint32_t checksum, const uint8_t *bytes, int size) {
+    pthread_once(&once, setup);
+    // The checksum is kept inverted between the calls.
+    uint32_t crc = ~checksum;
+
+#if defined(__x86_64__)
+    if (has_sse4_2) {
+        return ~update_with_sse4_2(crc, bytes, size);
+    }
+#endif
+
+    return ~update_with_table(crc, bytes, size);
+}
+
+uint32_t Crc32c_update_with_table(uint32_t checksum, const uint8_t *bytes, int size) {
+    pthread_once(&once, setup);
+    return ~update_with_table(~checksum, bytes, size);
+}
@@ -0,0 +1,43 @@
+/**
+ * @file Crc32c.h
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <stdint.h>
+
+/**
+ * @brief Computes the CRC-32C (Castagnoli) of an array of bytes. The crc32 instruction of SSE4.2 is used when the
+ * processor has it, otherwise the checksum is computed with a lookup table.
+ *
+ * @param bytes The array of bytes.
+ * @param size The number of bytes.
+ * @return uint32_t The checksum.
+ */
+uint32_t Crc32c_compute(const uint8_t *bytes, int size);
+
+/**
+ * @brief Continues a checksum with the bytes that follow, for data that is not in a single array.
+ *
+ * @param checksum The checksum of the previous bytes, 0 for the first ones.
+ * @param bytes The array of bytes.
+ * @param size The number of bytes.
+ * @return uint32_t The checksum of all the bytes so far.
+ */
+uint32_t Crc32c_update(uint32_t checksum, const uint8_t *bytes, int size);
+
+/**
+ * @brief Continues a checksum like Crc32c_update but always with the lookup table, so that the result of the crc32
+ * instruction can be checked against it.
+ *
+ * @param checksum The checksum of the previous bytes, 0 for the first ones.
+ * @param bytes The array of bytes.
+ * @param size The number of bytes.
+ * @return uint32_t The checksum of all the bytes so far.
+ */
+uint32_t Crc32c_update_with_table(uint32_t checksum, const uint8_t *bytes, int size);
+
+#endif
@@ -6,15 +6,29 @@
  */
 #include "Directory.h"
 
+#include <fcntl.h>
 #include <openssl/sha.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "Array.h"
-#include "BPTree.h"
+#include "AsyncReader.h"
+#include "Bitmap.h"
+#include "BloomFilter.h"
+#include "ColumnStore.h"
+#include "Crc32c.h"
+#include "DirectoryIndex.h"
 #include "DirectoryRecord.h"
+#include "DirectoryStats.h"
+#include "RecordCache.h"
+#include "StaticIndex.h"
 
 /**
  * @brief Hashes a string with the SHA-256 algorithm and keeps the first 64 bits.
@@ -55,175 +69,2083 @@ static long get_file_size(FILE *fp) {
     return file_size;
 }
 
+/**
+ * @brief Gets the size of a slot of the database file, that is a record followed by its checksum.
+ *
+ * @return int The size of a slot in bytes.
+ */
+static int get_slot_size() {
+    return DirectoryRecord_size_on_disk() + CHECKSUM_SIZE_IN_BYTES;
+}
+
+/**
+ * @brief Gets the position in the database file of the record of a slot.
+ *
+ * @param slot The slot.
+ * @return uint64_t The position of the record.
+ */
+static uint64_t get_data_ptr(int slot) {
+    return DIRECTORY_HEADER_SIZE_IN_BYTES + (uint64_t)slot * get_slot_size();
+}
+
+/**
+ * @brief Gets the slot of the record at a position of the database file.
+ *
+ * @param data_ptr The position of the record.
+ * @return int The slot.
+ */
+static int get_slot(uint64_t data_ptr) {
+    return (data_ptr - DIRECTORY_HEADER_SIZE_IN_BYTES) / get_slot_size();
+}
+
+/**
+ * @brief Writes a 32-bit integer in big endian.
+ *
+ * @param bytes Where the integer is written.
+ * @param value The integer.
+ */
+static void write_uint32(uint8_t *bytes, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        bytes[i] = (uint8_t)(value >> (24 - 8 * i));
+    }
+}
+
+/**
+ * @brief Reads a 32-bit integer written in big endian.
+ *
+ * @param bytes Where the integer is read.
+ * @return uint32_t The integer.
+ */
+static uint32_t read_uint32(uint8_t *bytes) {
+    return (uint32_t)bytes[0] << 24 | (uint32_t)bytes[1] << 16 | (uint32_t)bytes[2] << 8 | (uint32_t)bytes[3];
+}
+
+/**
+ * @brief Writes a 64-bit integer in big endian.
+ *
+ * @param bytes Where the integer is written.
+ * @param value The integer.
+ */
+static void write_uint64(uint8_t *bytes, uint64_t value) {
+    write_uint32(bytes, (uint32_t)(value >> 32));
+    write_uint32(bytes + 4, (uint32_t)value);
+}
+
+/**
+ * @brief Reads a 64-bit integer written in big endian.
+ *
+ * @param bytes Where the integer is read.
+ * @return uint64_t The integer.
+ */
+static uint64_t read_uint64(uint8_t *bytes) {
+    return (uint64_t)read_uint32(bytes) << 32 | read_uint32(bytes + 4);
+}
+
+/**
+ * @brief Writes the checksum of a record after the record.
+ *
+ * @param slot_bytes The slot, the checksum is written in its last bytes.
+ */
+static void seal_record(uint8_t *slot_bytes) {
+    int record_size = DirectoryRecord_size_on_disk();
+    write_uint32(slot_bytes + record_size, Crc32c_compute(slot_bytes, record_size));
+}
+
+/**
+ * @brief Checks that a record matches its checksum.
+ *
+ * @param slot_bytes The slot.
+ * @return true The record is intact.
+ * @return false The record is corrupted, for example by a write that was interrupted.
+ */
+static bool is_record_intact(uint8_t *slot_bytes) {
+    int record_size = DirectoryRecord_size_on_disk();
+    return read_uint32(slot_bytes + record_size) == Crc32c_compute(slot_bytes, record_size);
+}
+
+/**
+ * @brief Builds the header of the database file.
+ *
+ * @param header The header will be written in this array.
+ */
+static void encode_header(uint8_t header[DIRECTORY_HEADER_SIZE_IN_BYTES]) {
+    memset(header, 0, DIRECTORY_HEADER_SIZE_IN_BYTES);
+    memcpy(header, DIRECTORY_MAGIC, DIRECTORY_MAGIC_SIZE_IN_BYTES);
+    write_uint32(header + DIRECTORY_MAGIC_SIZE_IN_BYTES, DIRECTORY_FORMAT_VERSION);
+    write_uint32(header + DIRECTORY_MAGIC_SIZE_IN_BYTES + 4, DirectoryRecord_size_on_disk());
+    // The checksum of the header is in its last bytes, the bytes in between are reserved.
+    int checksum_position = DIRECTORY_HEADER_SIZE_IN_BYTES - CHECKSUM_SIZE_IN_BYTES;
+    write_uint32(header + checksum_position, Crc32c_compute(header, checksum_position));
+}
+
+/**
+ * @brief Reads and checks the header of the database file. The program stops if the header is corrupted or if the
+ * file has been written by a version of the format that is not supported.
+ *
+ * @param fp The database file.
+ * @return true The file has a valid header.
+ * @return false The file has no header, it comes from a version that only wrote the records.
+ */
+static bool read_header(FILE *fp) {
+    uint8_t header[DIRECTORY_HEADER_SIZE_IN_BYTES];
+    fseek(fp, 0, SEEK_SET);
+    int size = fread(header, 1, DIRECTORY_HEADER_SIZE_IN_BYTES, fp);
+
+    // The first byte of a file without header is the deletion flag of a record, so it is never the magic number.
+    if (size < DIRECTORY_MAGIC_SIZE_IN_BYTES || memcmp(header, DIRECTORY_MAGIC, DIRECTORY_MAGIC_SIZE_IN_BYTES) != 0) {
+        return false;
+    }
+
+    int checksum_position = DIRECTORY_HEADER_SIZE_IN_BYTES - CHECKSUM_SIZE_IN_BYTES;
+    if (size < DIRECTORY_HEADER_SIZE_IN_BYTES || read_uint32(header + checksum_position) != Crc32c_compute(header, checksum_position)) {
+        fprintf(stderr, "The header of the database file is corrupted.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    uint32_t version = read_uint32(header + DIRECTORY_MAGIC_SIZE_IN_BYTES);
+    uint32_t record_size = read_uint32(header + DIRECTORY_MAGIC_SIZE_IN_BYTES + 4);
+    if (version != DIRECTORY_FORMAT_VERSION || record_size != (uint32_t)DirectoryRecord_size_on_disk()) {
+        fprintf(stderr, "The database file has been written with version %u of the format, which is not supported.\n", version);
+        exit(EXIT_FAILURE);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Rewrites a database file without header in the current format: the header is added and each record is
+ * followed by its checksum. The slots keep their order, so the tombstones remain valid.
+ *
+ * @param directory The directory.
+ */
+static void migrate_database(Directory *directory) {
+    char filename[FILENAME_MAXLEN + 16];
+    snprintf(filename, FILENAME_MAXLEN + 16, "%s.migrating", directory->database_filename);
+    FILE *legacy_fp = fopen(directory->database_filename, "rb");
+    FILE *fp = fopen(filename, "wb");
+
+    if (legacy_fp == NULL || fp == NULL) {
+        exit(EXIT_FAILURE);
+    }
+
+    uint8_t header[DIRECTORY_HEADER_SIZE_IN_BYTES];
+    encode_header(header);
+    fwrite(header, 1, DIRECTORY_HEADER_SIZE_IN_BYTES, fp);
+
+    uint8_t *slot_bytes = (uint8_t *)malloc(get_slot_size());
+    // An incomplete record at the end of the file is dropped.
+    while (fread(slot_bytes, DirectoryRecord_size_on_disk(), 1, legacy_fp) == 1) {
+        seal_record(slot_bytes);
+        fwrite(slot_bytes, get_slot_size(), 1, fp);
+    }
+
+    free(slot_bytes);
+    fclose(legacy_fp);
+    fclose(fp);
+
+    // The old file is only replaced once the new one is complete.
+    if (rename(filename, directory->database_filename) != 0) {
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * @brief Computes the key of a phone number in the index of a shard. It is the hash of the phone number, unless the
+ * backend of the index makes its own keys.
+ *
+ * @param directory The shard.
+ * @param phone_number The phone number.
+ * @param hash The hash of the phone number.
+ * @param key The key will be assigned to this variable.
+ * @return true The key has been computed.
+ * @return false The index cannot hold this phone number.
+ */
+static bool compute_key(Directory *directory, char *phone_number, uint64_t hash, uint64_t *key) {
+    if (directory->index->backend->encode_key == NULL) {
+        *key = hash;
+        return true;
+    }
+
+    return directory->index->backend->encode_key(phone_number, key);
+}
+
+/**
+ * @brief Adds a key of the index to the Bloom filter.
+ *
+ * @param key The key of the phone number.
+ * @param data_ptr The position of the record in the database file.
+ * @param context The filter.
+ */
+static void add_to_filter(uint64_t key, uint64_t data_ptr, void *context) {
+    (void)data_ptr;
+    BloomFilter_add((BloomFilter *)context, key);
+}
+
+/**
+ * @brief Rebuilds the Bloom filter from the keys of the index, the keys of the deleted records are thus forgotten.
+ *
+ * @param directory The directory.
+ */
+static void rebuild_filter(Directory *directory) {
+    int key_count = DirectoryIndex_count(directory->index);
+
+    if (directory->filter != NULL) {
+        BloomFilter_destroy(&directory->filter);
+    }
+
+    // Leaves room for as many appends as there are records before the next rebuild.
+    directory->filter = BloomFilter_init(2 * key_count);
+    directory->filter_stale_count = 0;
+    DirectoryIndex_for_each(directory->index, add_to_filter, directory->filter);
+}
+
+/**
+ * @brief Searches for a key in the index, the Bloom filter is consulted first if it is enabled.
+ *
+ * @param directory The directory.
+ * @param key The key of the phone number.
+ * @param data_ptr The position of the record in the database file will be assigned to this variable.
+ * @return true The key exists in the index.
+ * @return false The key does not exist in the index.
+ */
+static bool index_search(Directory *directory, uint64_t key, uint64_t *data_ptr) {
+    if (directory->filter != NULL && !BloomFilter_may_contain(directory->filter, key)) {
+        // The key has never been inserted, there is no need to traverse the index.
+        return false;
+    }
+
+    if (directory->frozen_index != NULL) {
+        return StaticIndex_search(directory->frozen_index, key, data_ptr);
+    }
+
+    return DirectoryIndex_search(directory->index, key, data_ptr);
+}
+
+/**
+ * @brief Drops the frozen index before the index is modified.
+ *
+ * @param directory The directory.
+ */
+static void thaw(Directory *directory) {
+    if (directory->frozen_index != NULL) {
+        StaticIndex_destroy(&directory->frozen_index);
+    }
+}
+
+/**
+ * @brief Builds the name of the file of the tombstone bitmap.
+ *
+ * @param directory The directory.
+ * @param filename The name of the file will be assigned to this variable.
+ */
+static void get_tombstones_filename(Directory *directory, char filename[FILENAME_MAXLEN + 16]) {
+    snprintf(filename, FILENAME_MAXLEN + 16, "%s.tombstones", directory->database_filename);
+}
+
+/**
+ * @brief Writes the byte of the tombstone bitmap that contains the bit of a slot.
+ *
+ * @param directory The directory.
+ * @param slot The slot of the record.
+ */
+static void save_tombstone(Directory *directory, int slot) {
+    char filename[FILENAME_MAXLEN + 16];
+    get_tombstones_filename(directory, filename);
+    int fd = open(filename, O_WRONLY | O_CREAT, 0644);
+
+    if (fd < 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    uint8_t byte = Bitmap_get_byte(directory->tombstones, slot / 8);
+    pwrite(fd, &byte, 1, slot / 8);
+    close(fd);
+}
+
+/**
+ * @brief Loads the tombstone bitmap. The first byte of each record also tells whether it is deleted, so a database
+ * without a bitmap file, one that comes from a version that had none or whose bitmap has been lost, gets its bitmap
+ * built from these bytes and saved.
+ *
+ * @param directory The directory.
+ * @param fp The database file.
+ */
+static void load_tombstones(Directory *directory, FILE *fp) {
+    char filename[FILENAME_MAXLEN + 16];
+    get_tombstones_filename(directory, filename);
+    FILE *tombstones_fp = fopen(filename, "rb");
+
+    if (tombstones_fp != NULL) {
+        int byte;
+        for (int i = 0; (byte = fgetc(tombstones_fp)) != EOF; i++) {
+            Bitmap_set_byte(directory->tombstones, i, (uint8_t)byte);
+        }
+
+        fclose(tombstones_fp);
+        // The slots beyond the end of the file are alive, the bits beyond the last slot are dropped.
+        Bitmap_resize(directory->tombstones, directory->slot_count);
+        return;
+    }
+
+    Bitmap_resize(directory->tombstones, directory->slot_count);
+
+    for (int slot = 0; slot < directory->slot_count; slot++) {
+        uint8_t is_deleted;
+        fseek(fp, get_data_ptr(slot), SEEK_SET);
+        fread(&is_deleted, 1, 1, fp);
+
+        if ((bool)is_deleted) {
+            Bitmap_set(directory->tombstones, slot);
+        }
+    }
+
+    tombstones_fp = fopen(filename, "wb");
+
+    if (tombstones_fp == NULL) {
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < (directory->slot_count + 7) / 8; i++) {
+        fputc(Bitmap_get_byte(directory->tombstones, i), tombstones_fp);
+    }
+
+    fclose(tombstones_fp);
+}
+
+/**
+ * @brief Function called for each record that is not deleted.
+ *
+ * @param data_ptr The position of the record in the database file.
+ * @param bytes The record as stored on disk.
+ * @param is_intact false = the record does not match its checksum.
+ * @param context The context given to for_each_live_record.
+ */
+typedef void (*LiveRecordVisitor)(uint64_t data_ptr, uint8_t *bytes, bool is_intact, void *context);
+
+/**
+ * @brief Reads the database file block by block and visits the records that are not deleted. The blocks whose
+ * records are all deleted are not read, the tombstone bitmap is enough to skip them. The checksum of each record
+ * visited is verified.
+ *
+ * @param directory The directory.
+ * @param visit The function called for each record.
+ * @param context Passed as is to the function.
+ */
+static void for_each_live_record(Directory *directory, LiveRecordVisitor visit, void *context) {
+    FILE *fp;
+    fp = fopen(directory->database_filename, "rb");
+
+    if (fp == NULL) {
+        return;
+    }
+
+    int slot_size = get_slot_size();
+    uint8_t *block = (uint8_t *)malloc(slot_size * DIRECTORY_SCAN_BLOCK_SIZE);
+    int slot = Bitmap_find_next_clear(directory->tombstones, 0);
+
+    while (slot != -1) {
+        // The block starts at the first record that is alive.
+        int block_size = directory->slot_count - slot < DIRECTORY_SCAN_BLOCK_SIZE ? directory->slot_count - slot : DIRECTORY_SCAN_BLOCK_SIZE;
+        DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_IO);
+        fseek(fp, get_data_ptr(slot), SEEK_SET);
+        block_size = fread(block, slot_size, block_size, fp);
+        DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_DECODE);
+
+        for (int i = 0; i < block_size; i++) {
+            if (!Bitmap_get(directory->tombstones, slot + i)) {
+                uint8_t *slot_bytes = block + i * slot_size;
+                visit(get_data_ptr(slot + i), slot_bytes, is_record_intact(slot_bytes), context);
+            }
+        }
+
+        slot = block_size > 0 ? Bitmap_find_next_clear(directory->tombstones, slot + block_size) : -1;
+    }
+
+    free(block);
+    fclose(fp);
+}
+
+/**
+ * @brief Data structure that represents the keys collected while the index is rebuilt, they are inserted into the
+ * index at once.
+ *
+ */
+typedef struct IndexBuilder {
+    Directory *directory;
+    uint64_t *keys;
+    uint64_t *data_ptrs;
+    int count;
+} IndexBuilder;
+
+/**
+ * @brief Collects the key of a record while the index is rebuilt. A corrupted record cannot be trusted, not even its
+ * phone number, so its slot is marked as deleted and will be reused.
+ *
+ * @param data_ptr The position of the record in the database file.
+ * @param bytes The record as stored on disk.
+ * @param is_intact false = the record does not match its checksum.
+ * @param context The index builder.
+ */
+static void index_record(uint64_t data_ptr, uint8_t *bytes, bool is_intact, void *context) {
+    IndexBuilder *builder = (IndexBuilder *)context;
+    Directory *directory = builder->directory;
+
+    if (!is_intact) {
+        int slot = get_slot(data_ptr);
+        fprintf(stderr, "The record of slot %d of \"%s\" is corrupted, it is skipped.\n", slot, directory->database_filename);
+        Bitmap_set(directory->tombstones, slot);
+        save_tombstone(directory, slot);
+        return;
+    }
+
+    char phone_number[PHONE_NUMBER_MAXLEN];
+    phone_number[PHONE_NUMBER_MAXLEN - 1] = '\0';
+    memcpy(phone_number, bytes + IS_DELETED_SIZE_IN_BYTES, PHONE_NUMBER_MAXLEN_WITHOUT_NULL_CHARACTER);
+
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_HASH);
+    bool is_key_computed = compute_key(directory, phone_number, hash_string(phone_number), &builder->keys[builder->count]);
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_DECODE);
+
+    if (!is_key_computed) {
+        // The record was written with another kind of index, it remains in the file but cannot be found.
+        fprintf(stderr, "The phone number of slot %d of \"%s\" cannot be indexed, it is skipped.\n", get_slot(data_ptr), directory->database_filename);
+        return;
+    }
+
+    builder->data_ptrs[builder->count] = data_ptr;
+    builder->count++;
+}
+
+// BEGIN : Snapshot of the index
+
+/**
+ * @brief Builds the name of a file of the snapshot of the index.
+ *
+ * @param directory The directory.
+ * @param extension ".index" or ".journal", followed by ".saving" while the snapshot is being saved.
+ * @param filename The name of the file will be assigned to this variable.
+ */
+static void get_snapshot_filename(Directory *directory, const char *extension, char filename[FILENAME_MAXLEN + 16]) {
+    snprintf(filename, FILENAME_MAXLEN + 16, "%s%s", directory->database_filename, extension);
+}
+
+/**
+ * @brief Builds the header of a snapshot of the index.
+ *
+ * @param header The header will be written in this array.
+ * @param backend_name The name of the kind of index.
+ * @param count The number of keys.
+ * @param snapshot_id The identifier of the snapshot, its journal starts with it.
+ * @param entries_checksum The checksum of the entries.
+ */
+static void encode_snapshot_header(uint8_t header[INDEX_SNAPSHOT_HEADER_SIZE_IN_BYTES], const char *backend_name, int count, uint64_t snapshot_id, uint32_t entries_checksum) {
+    memset(header, 0, INDEX_SNAPSHOT_HEADER_SIZE_IN_BYTES);
+    memcpy(header, INDEX_SNAPSHOT_MAGIC, DIRECTORY_MAGIC_SIZE_IN_BYTES);
+    write_uint32(header + 8, INDEX_SNAPSHOT_FORMAT_VERSION);
+    write_uint32(header + 12, (uint32_t)count);
+    write_uint64(header + 16, snapshot_id);
+    strncpy((char *)header + 24, backend_name, INDEX_SNAPSHOT_BACKEND_NAME_SIZE_IN_BYTES - 1);
+    write_uint32(header + 40, entries_checksum);
+    int checksum_position = INDEX_SNAPSHOT_HEADER_SIZE_IN_BYTES - CHECKSUM_SIZE_IN_BYTES;
+    write_uint32(header + checksum_position, Crc32c_compute(header, checksum_position));
+}
+
+/**
+ * @brief Creates a journal, empty apart from its header.
+ *
+ * @param directory The directory.
+ * @param extension ".journal" or ".journal.saving".
+ * @param snapshot_id The identifier of the snapshot that the journal follows.
+ * @return int The file descriptor of the journal, opened for appending.
+ */
+static int create_journal(Directory *directory, const char *extension, uint64_t snapshot_id) {
+    char filename[FILENAME_MAXLEN + 16];
+    get_snapshot_filename(directory, extension, filename);
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+
+    if (fd < 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    uint8_t header[JOURNAL_HEADER_SIZE_IN_BYTES];
+    write_uint64(header, snapshot_id);
+    write(fd, header, JOURNAL_HEADER_SIZE_IN_BYTES);
+    return fd;
+}
+
+/**
+ * @brief Writes the slot of a record that is about to be appended or deleted to the journals. It is written before the
+ * database file is modified, so that no modification is missing from the journal if the program stops in between.
+ *
+ * @param directory The directory.
+ * @param slot The slot of the record.
+ */
+static void journal_slot(Directory *directory, int slot) {
+    uint8_t entry[JOURNAL_ENTRY_SIZE_IN_BYTES];
+    write_uint32(entry, (uint32_t)slot);
+
+    if (directory->journal_fd >= 0) {
+        write(directory->journal_fd, entry, JOURNAL_ENTRY_SIZE_IN_BYTES);
+    }
+
+    if (directory->next_journal_fd >= 0) {
+        write(directory->next_journal_fd, entry, JOURNAL_ENTRY_SIZE_IN_BYTES);
+    }
+}
+
+/**
+ * @brief Removes the snapshot of the index and its journal.
+ *
+ * @param directory The directory.
+ */
+static void discard_snapshot(Directory *directory) {
+    char filename[FILENAME_MAXLEN + 16];
+    get_snapshot_filename(directory, ".index", filename);
+    unlink(filename);
+    get_snapshot_filename(directory, ".journal", filename);
+    unlink(filename);
+}
+
+/**
+ * @brief Reads the journal of a snapshot.
+ *
+ * @param directory The directory, its slots must be counted.
+ * @param snapshot_id The identifier of the snapshot.
+ * @return Bitmap* One bit per slot, 1 = the slot has been modified since the snapshot. NULL if the journal does not
+ * follow the snapshot, or if its last entry is incomplete.
+ */
+static Bitmap *load_journal(Directory *directory, uint64_t snapshot_id) {
+    char filename[FILENAME_MAXLEN + 16];
+    get_snapshot_filename(directory, ".journal", filename);
+    FILE *fp = fopen(filename, "rb");
+
+    if (fp == NULL) {
+        return NULL;
+    }
+
+    uint8_t header[JOURNAL_HEADER_SIZE_IN_BYTES];
+    if (fread(header, 1, JOURNAL_HEADER_SIZE_IN_BYTES, fp) != JOURNAL_HEADER_SIZE_IN_BYTES || read_uint64(header) != snapshot_id) {
+        fclose(fp);
+        return NULL;
+    }
+
+    Bitmap *changed_slots = Bitmap_init(directory->slot_count);
+    uint8_t entry[JOURNAL_ENTRY_SIZE_IN_BYTES];
+    int size;
+
+    while ((size = fread(entry, 1, JOURNAL_ENTRY_SIZE_IN_BYTES, fp)) == JOURNAL_ENTRY_SIZE_IN_BYTES) {
+        uint32_t slot = read_uint32(entry);
+
+        // A record appended at the end whose slot is incomplete is not in the database.
+        if (slot < (uint32_t)directory->slot_count) {
+            Bitmap_set(changed_slots, slot);
+        }
+    }
+
+    fclose(fp);
+
+    if (size != 0) {
+        // The entries that would be added after an incomplete one could not be read.
+        Bitmap_destroy(&changed_slots);
+    }
+
+    return changed_slots;
+}
+
+/**
+ * @brief Indexes the records of the slots modified since the snapshot, those that are not deleted.
+ *
+ * @param directory The directory.
+ * @param changed_slots The slots modified since the snapshot.
+ */
+static void index_changed_records(Directory *directory, Bitmap *changed_slots) {
+    FILE *fp;
+    fp = fopen(directory->database_filename, "rb");
+
+    if (fp == NULL) {
+        exit(EXIT_FAILURE);
+    }
+
+    int changed_count = Bitmap_count(changed_slots);
+    IndexBuilder builder = {directory, NULL, NULL, 0};
+    builder.keys = (uint64_t *)malloc(sizeof(uint64_t) * (changed_count > 0 ? changed_count : 1));
+    builder.data_ptrs = (uint64_t *)malloc(sizeof(uint64_t) * (changed_count > 0 ? changed_count : 1));
+    uint8_t *slot_bytes = (uint8_t *)malloc(get_slot_size());
+
+    for (int slot = Bitmap_find_next_set(changed_slots, 0); slot != -1; slot = Bitmap_find_next_set(changed_slots, slot + 1)) {
+        if (Bitmap_get(directory->tombstones, slot)) {
+            continue;
+        }
+
+        DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_IO);
+        fseek(fp, get_data_ptr(slot), SEEK_SET);
+        bool is_read = fread(slot_bytes, get_slot_size(), 1, fp) == 1;
+        DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_DECODE);
+        index_record(get_data_ptr(slot), slot_bytes, is_read && is_record_intact(slot_bytes), &builder);
+    }
+
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_INDEX);
+    DirectoryIndex_insert_batch(directory->index, builder.keys, builder.data_ptrs, builder.count);
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_IO);
+    free(slot_bytes);
+    free(builder.keys);
+    free(builder.data_ptrs);
+    fclose(fp);
+}
+
+/**
+ * @brief Loads the index from its snapshot, then indexes again the records of the slots modified since the snapshot.
+ * The slots and the tombstones must already be loaded.
+ *
+ * @param directory The directory, its index is empty.
+ * @return true The index has been loaded, the modifications are written to the journal of the snapshot from now on.
+ * @return false There is no snapshot, or it is damaged, or it has been saved with another kind of index, or it does
+ * not match its journal. The index is left empty.
+ */
+static bool load_snapshot(Directory *directory) {
+    char filename[FILENAME_MAXLEN + 16];
+    get_snapshot_filename(directory, ".index", filename);
+    FILE *fp = fopen(filename, "rb");
+
+    if (fp == NULL) {
+        return false;
+    }
+
+    uint8_t header[INDEX_SNAPSHOT_HEADER_SIZE_IN_BYTES];
+    if (fread(header, 1, INDEX_SNAPSHOT_HEADER_SIZE_IN_BYTES, fp) != INDEX_SNAPSHOT_HEADER_SIZE_IN_BYTES) {
+        fclose(fp);
+        return false;
+    }
+
+    // The header is valid if it is the one this version would write for the same values.
+    int count = (int)read_uint32(header + 12);
+    uint64_t snapshot_id = read_uint64(header + 16);
+    uint32_t entries_checksum = read_uint32(header + 40);
+    uint8_t expected_header[INDEX_SNAPSHOT_HEADER_SIZE_IN_BYTES];
+    encode_snapshot_header(expected_header, directory->index->backend->name, count, snapshot_id, entries_checksum);
+
+    Bitmap *changed_slots = NULL;
+    if (count < 0 || memcmp(header, expected_header, INDEX_SNAPSHOT_HEADER_SIZE_IN_BYTES) != 0 || (changed_slots = load_journal(directory, snapshot_id)) == NULL) {
+        fclose(fp);
+        return false;
+    }
+
+    // All the entries are checked before the index is filled, a damaged snapshot is not loaded at all.
+    uint64_t *keys = (uint64_t *)malloc(sizeof(uint64_t) * (count > 0 ? count : 1));
+    uint64_t *data_ptrs = (uint64_t *)malloc(sizeof(uint64_t) * (count > 0 ? count : 1));
+    uint8_t *block = (uint8_t *)malloc(INDEX_SNAPSHOT_ENTRY_SIZE_IN_BYTES * INDEX_SNAPSHOT_BLOCK_SIZE);
+    uint32_t checksum = 0;
+    int read_count = 0;
+    int kept_count = 0;
+
+    while (read_count < count) {
+        int block_size = count - read_count < INDEX_SNAPSHOT_BLOCK_SIZE ? count - read_count : INDEX_SNAPSHOT_BLOCK_SIZE;
+        if ((int)fread(block, INDEX_SNAPSHOT_ENTRY_SIZE_IN_BYTES, block_size, fp) != block_size) {
+            break;
+        }
+
+        checksum = Crc32c_update(checksum, block, INDEX_SNAPSHOT_ENTRY_SIZE_IN_BYTES * block_size);
+
+        for (int i = 0; i < block_size; i++) {
+            uint8_t *entry = block + i * INDEX_SNAPSHOT_ENTRY_SIZE_IN_BYTES;
+            uint32_t slot = read_uint32(entry + 8);
+
+            // The key of a modified slot is replaced by the one of the record now in the slot, if it is alive.
+            if (slot < (uint32_t)directory->slot_count && !Bitmap_get(changed_slots, slot) && !Bitmap_get(directory->tombstones, slot)) {
+                keys[kept_count] = read_uint64(entry);
+                data_ptrs[kept_count] = get_data_ptr(slot);
+                kept_count++;
+            }
+        }
+
+        read_count += block_size;
+    }
+
+    fclose(fp);
+    bool is_loaded = read_count == count && checksum == entries_checksum;
+
+    if (is_loaded) {
+        // The entries were written in the order in which the index visits its keys.
+        DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_INDEX);
+        DirectoryIndex_load(directory->index, keys, data_ptrs, kept_count);
+        index_changed_records(directory, changed_slots);
+        DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_IO);
+
+        directory->snapshot_id = snapshot_id;
+        get_snapshot_filename(directory, ".journal", filename);
+        directory->journal_fd = open(filename, O_WRONLY | O_APPEND);
+
+        if (directory->journal_fd < 0) {
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    free(block);
+    free(keys);
+    free(data_ptrs);
+    Bitmap_destroy(&changed_slots);
+    return is_loaded;
+}
+
+// END : Snapshot of the index
+
 /**
  * @brief Rebuilds the database index.
  *
- * @param directory The directory.
+ * @param directory The directory.
+ */
+static void rebuild_index(Directory *directory) {
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_IO);
+    FILE *fp;
+    fp = fopen(directory->database_filename, "rb");
+
+    if (fp == NULL) {
+        // A snapshot or tombstones left without their database would describe records that no longer exist, the
+        // tombstones would then delete the records appended to a new database.
+        discard_snapshot(directory);
+        char filename[FILENAME_MAXLEN + 16];
+        get_tombstones_filename(directory, filename);
+        unlink(filename);
+        return;
+    }
+
+    if (!read_header(fp)) {
+        fclose(fp);
+        migrate_database(directory);
+        fp = fopen(directory->database_filename, "rb");
+
+        if (fp == NULL) {
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // An incomplete slot at the end of the file is ignored, it will be overwritten by the next append.
+    directory->slot_count = (get_file_size(fp) - DIRECTORY_HEADER_SIZE_IN_BYTES) / get_slot_size();
+    load_tombstones(directory, fp);
+    fclose(fp);
+
+    if (!load_snapshot(directory)) {
+        // The modifications would not be written to the journal of the snapshot from now on, so it is removed.
+        discard_snapshot(directory);
+
+        // At most one key per slot, the keys are sorted and inserted together instead of descending the index for each one.
+        IndexBuilder builder = {directory, NULL, NULL, 0};
+        builder.keys = (uint64_t *)malloc(sizeof(uint64_t) * (directory->slot_count > 0 ? directory->slot_count : 1));
+        builder.data_ptrs = (uint64_t *)malloc(sizeof(uint64_t) * (directory->slot_count > 0 ? directory->slot_count : 1));
+        for_each_live_record(directory, index_record, &builder);
+        DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_INDEX);
+        DirectoryIndex_insert_batch(directory->index, builder.keys, builder.data_ptrs, builder.count);
+        free(builder.keys);
+        free(builder.data_ptrs);
+    }
+
+    // The deleted records, and the corrupted ones, are the free slots, the first one is where the next append goes.
+    int first_free_slot = Bitmap_find_next_set(directory->tombstones, 0);
+    directory->free_slot_cursor = first_free_slot != -1 ? first_free_slot : directory->slot_count;
+}
+
+/**
+ * @brief Writes a record and its checksum at a position of the database file, the file is created with its header
+ * if it does not exist.
+ *
+ * @param directory The directory.
+ * @param data_ptr The position of the record.
+ * @param record The record.
+ */
+static void write_record(Directory *directory, uint64_t data_ptr, DirectoryRecord *record) {
+    int fd = open(directory->database_filename, O_WRONLY | O_CREAT, 0644);
+
+    if (fd < 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == 0 && file_stat.st_size == 0) {
+        uint8_t header[DIRECTORY_HEADER_SIZE_IN_BYTES];
+        encode_header(header);
+        pwrite(fd, header, DIRECTORY_HEADER_SIZE_IN_BYTES, 0);
+    }
+
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_DECODE);
+    ByteArray *byte_array = DirectoryRecord_to_ByteArray(record);
+    uint8_t *slot_bytes = (uint8_t *)malloc(get_slot_size());
+    memcpy(slot_bytes, byte_array->items, byte_array->size);
+    // A record written is alive, only delete_record marks it as deleted.
+    slot_bytes[0] = (uint8_t) false;
+    seal_record(slot_bytes);
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_IO);
+    // The record and its checksum are written at once, a write that is interrupted leaves a record that does not match its checksum.
+    pwrite(fd, slot_bytes, get_slot_size(), data_ptr);
+    free(slot_bytes);
+    ByteArray_destroy(&byte_array);
+    close(fd);
+}
+
+/**
+ * @brief Marks a record of the database file as deleted with its first byte and seals it again. The tombstone bitmap
+ * is what the directory reads, but the database file is enough to rebuild it if it is lost.
+ *
+ * @param directory The directory.
+ * @param slot The slot of the record.
+ */
+static void write_deletion_flag(Directory *directory, int slot) {
+    int fd = open(directory->database_filename, O_RDWR);
+
+    if (fd < 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    uint8_t *slot_bytes = (uint8_t *)malloc(get_slot_size());
+
+    if (pread(fd, slot_bytes, get_slot_size(), get_data_ptr(slot)) == get_slot_size()) {
+        slot_bytes[0] = (uint8_t) true;
+        seal_record(slot_bytes);
+        pwrite(fd, slot_bytes, get_slot_size(), get_data_ptr(slot));
+    }
+
+    free(slot_bytes);
+    close(fd);
+}
+
+/**
+ * @brief Finds out which shard holds a key. The high bits of the key are used to pick the shard.
+ *
+ * @param directory The directory.
+ * @param key The hash of the phone number.
+ * @return Directory* The shard, or the directory itself if it is not sharded.
+ */
+static Directory *find_shard(Directory *directory, uint64_t key) {
+    if (directory->shard_count == 0) {
+        return directory;
+    }
+
+    if (directory->shard_bits == 0) {
+        return directory->shards[0];
+    }
+
+    return directory->shards[key >> (64 - directory->shard_bits)];
+}
+
+/**
+ * @brief Gets the shard at the given position, a directory that is not sharded is its only shard.
+ *
+ * @param directory The directory.
+ * @param index The position of the shard.
+ * @return Directory* The shard.
+ */
+static Directory *get_shard(Directory *directory, int index) {
+    return directory->shard_count == 0 ? directory : directory->shards[index];
+}
+
+/**
+ * @brief Counts the shards, a directory that is not sharded is its only shard.
+ *
+ * @param directory The directory.
+ * @return int The number of shards.
+ */
+static int count_shards(Directory *directory) {
+    return directory->shard_count == 0 ? 1 : directory->shard_count;
+}
+
+/**
+ * @brief Allocates a directory with an empty index.
+ *
+ * @param database_filename The name of the database file.
+ * @param backend The kind of index.
+ * @return Directory* The allocated directory.
+ */
+static Directory *Directory_alloc(char database_filename[FILENAME_MAXLEN], const DirectoryIndexBackend *backend) {
+    Directory *directory = (Directory *)malloc(sizeof(Directory));
+    strcpy(directory->database_filename, database_filename);
+    directory->index = DirectoryIndex_init(backend);
+    directory->filter = NULL;
+    directory->filter_stale_count = 0;
+    directory->frozen_index = NULL;
+    directory->cache = NULL;
+    directory->reader = NULL;
+    pthread_rwlock_init(&directory->lock, NULL);
+    directory->shards = NULL;
+    directory->shard_count = 0;
+    directory->shard_bits = 0;
+    directory->tombstones = Bitmap_init(0);
+    directory->slot_count = 0;
+    directory->free_slot_cursor = 0;
+    directory->journal_fd = -1;
+    directory->snapshot_id = 0;
+    directory->next_journal_fd = -1;
+    directory->snapshot_pid = -1;
+    return directory;
+}
+
+Directory *Directory_init(char database_filename[FILENAME_MAXLEN]) {
+    return Directory_init_with_index(database_filename, 0, &DIRECTORY_INDEX_BPTREE);
+}
+
+Directory *Directory_init_sharded(char database_filename[FILENAME_MAXLEN], int shard_count) {
+    return Directory_init_with_index(database_filename, shard_count, &DIRECTORY_INDEX_BPTREE);
+}
+
+/**
+ * @brief Opens a directory that is not sharded, or a shard, and rebuilds its index.
+ *
+ * @param database_filename The name of the database file.
+ * @param backend The kind of index.
+ * @return Directory* The opened directory.
+ */
+static Directory *open_shard(char database_filename[FILENAME_MAXLEN], const DirectoryIndexBackend *backend) {
+    Directory *directory = Directory_alloc(database_filename, backend);
+    DIRECTORY_TIME_BEGIN(DIRECTORY_OPERATION_REBUILD);
+    rebuild_index(directory);
+    DIRECTORY_TIME_END();
+    return directory;
+}
+
+Directory *Directory_init_with_index(char database_filename[FILENAME_MAXLEN], int shard_count, const DirectoryIndexBackend *backend) {
+    if (shard_count == 0) {
+        Directory *directory = open_shard(database_filename, backend);
+        directory->reader = AsyncReader_init();
+        return directory;
+    }
+
+    Directory *directory = Directory_alloc(database_filename, backend);
+
+    // The records are only in the shards, the database file and the index of the directory itself remain unused.
+
+    // The number of shards is rounded up to a power of 2 so that a shard is picked from the high bits of the key.
+    directory->shard_count = 1;
+    while (directory->shard_count < shard_count) {
+        directory->shard_count *= 2;
+        directory->shard_bits++;
+    }
+
+    directory->shards = (Directory **)malloc(sizeof(Directory *) * directory->shard_count);
+
+    for (int i = 0; i < directory->shard_count; i++) {
+        char shard_filename[FILENAME_MAXLEN];
+        snprintf(shard_filename, FILENAME_MAXLEN, "%s.%d", database_filename, i);
+        directory->shards[i] = open_shard(shard_filename, backend);
+    }
+
+    // The shards are searched one after the other, they share the reader of the directory.
+    directory->reader = AsyncReader_init();
+    return directory;
+}
+
+void Directory_destroy(Directory **directory) {
+    if ((*directory)->snapshot_pid != -1) {
+        Directory_wait_index_save(*directory);
+    }
+
+    for (int i = 0; i < (*directory)->shard_count; i++) {
+        Directory_destroy(&(*directory)->shards[i]);
+    }
+
+    free((*directory)->shards);
+    DirectoryIndex_destroy(&(*directory)->index);
+
+    if ((*directory)->filter != NULL) {
+        BloomFilter_destroy(&(*directory)->filter);
+    }
+
+    if ((*directory)->cache != NULL) {
+        RecordCache_destroy(&(*directory)->cache);
+    }
+
+    if ((*directory)->reader != NULL) {
+        AsyncReader_destroy(&(*directory)->reader);
+    }
+
+    if ((*directory)->journal_fd >= 0) {
+        close((*directory)->journal_fd);
+    }
+
+    thaw(*directory);
+    Bitmap_destroy(&(*directory)->tombstones);
+    pthread_rwlock_destroy(&(*directory)->lock);
+
+    free(*directory);
+    *directory = NULL;
+}
+
+void Directory_enable_cache(Directory *directory, int capacity) {
+    if (directory->cache != NULL) {
+        RecordCache_destroy(&directory->cache);
+    }
+
+    directory->cache = RecordCache_init(capacity);
+}
+
+void Directory_get_cache_counters(Directory *directory, uint64_t *hit_count, uint64_t *miss_count) {
+    if (directory->cache == NULL) {
+        *hit_count = 0;
+        *miss_count = 0;
+        return;
+    }
+
+    RecordCache_get_counters(directory->cache, hit_count, miss_count);
+}
+
+void Directory_enable_filter(Directory *directory) {
+    for (int i = 0; i < count_shards(directory); i++) {
+        Directory *shard = get_shard(directory, i);
+        pthread_rwlock_wrlock(&shard->lock);
+        rebuild_filter(shard);
+        pthread_rwlock_unlock(&shard->lock);
+    }
+}
+
+/**
+ * @brief Data structure that represents the keys collected from an ordered index to freeze it.
+ *
+ */
+typedef struct FrozenIndexBuilder {
+    uint64_t *keys;
+    uint64_t *data_ptrs;
+    int count;
+} FrozenIndexBuilder;
+
+/**
+ * @brief Collects a key of the index, the keys are visited in ascending order.
+ *
+ * @param key The key of the phone number.
+ * @param data_ptr The position of the record in the database file.
+ * @param context The builder.
+ */
+static void collect_key(uint64_t key, uint64_t data_ptr, void *context) {
+    FrozenIndexBuilder *builder = (FrozenIndexBuilder *)context;
+    builder->keys[builder->count] = key;
+    builder->data_ptrs[builder->count] = data_ptr;
+    builder->count++;
+}
+
+void Directory_freeze(Directory *directory) {
+    for (int i = 0; i < count_shards(directory); i++) {
+        Directory *shard = get_shard(directory, i);
+
+        if (!shard->index->backend->is_ordered) {
+            continue;
+        }
+
+        pthread_rwlock_wrlock(&shard->lock);
+        thaw(shard);
+
+        int key_count = DirectoryIndex_count(shard->index);
+        FrozenIndexBuilder builder = {NULL, NULL, 0};
+        builder.keys = (uint64_t *)malloc(sizeof(uint64_t) * (key_count > 0 ? key_count : 1));
+        builder.data_ptrs = (uint64_t *)malloc(sizeof(uint64_t) * (key_count > 0 ? key_count : 1));
+        DirectoryIndex_for_each(shard->index, collect_key, &builder);
+        shard->frozen_index = StaticIndex_init_sorted(builder.keys, builder.data_ptrs, builder.count);
+        free(builder.keys);
+        free(builder.data_ptrs);
+
+        pthread_rwlock_unlock(&shard->lock);
+    }
+}
+
+/**
+ * @brief Data structure that represents a snapshot being written by the child process, the entries are gathered in
+ * blocks written at once.
+ *
+ */
+typedef struct SnapshotWriter {
+    int fd;
+    uint8_t block[INDEX_SNAPSHOT_ENTRY_SIZE_IN_BYTES * INDEX_SNAPSHOT_BLOCK_SIZE];
+    int block_size;
+    int count;
+    uint32_t checksum;
+    bool is_ok;
+} SnapshotWriter;
+
+/**
+ * @brief Writes the entries of the block to the snapshot.
+ *
+ * @param writer The snapshot being written.
+ */
+static void flush_snapshot_block(SnapshotWriter *writer) {
+    int size = INDEX_SNAPSHOT_ENTRY_SIZE_IN_BYTES * writer->block_size;
+    writer->checksum = Crc32c_update(writer->checksum, writer->block, size);
+
+    if (write(writer->fd, writer->block, size) != size) {
+        writer->is_ok = false;
+    }
+
+    writer->block_size = 0;
+}
+
+/**
+ * @brief Adds a key of the index to the snapshot.
+ *
+ * @param key The key of the phone number.
+ * @param data_ptr The position of the record in the database file.
+ * @param context The snapshot being written.
+ */
+static void add_snapshot_entry(uint64_t key, uint64_t data_ptr, void *context) {
+    SnapshotWriter *writer = (SnapshotWriter *)context;
+
+    if (writer->block_size == INDEX_SNAPSHOT_BLOCK_SIZE) {
+        flush_snapshot_block(writer);
+    }
+
+    uint8_t *entry = writer->block + INDEX_SNAPSHOT_ENTRY_SIZE_IN_BYTES * writer->block_size;
+    write_uint64(entry, key);
+    write_uint32(entry + 8, (uint32_t)get_slot(data_ptr));
+    writer->block_size++;
+    writer->count++;
+}
+
+/**
+ * @brief Writes the snapshot of the index of a shard to "<database>.index.saving", in the child process. The entries
+ * are written in the order in which the index visits its keys, which is the order of the leaves for the B+ Tree.
+ *
+ * @param directory The shard.
+ * @return true The snapshot has been written.
+ * @return false The snapshot could not be written.
+ */
+static bool write_snapshot(Directory *directory) {
+    char filename[FILENAME_MAXLEN + 16];
+    get_snapshot_filename(directory, ".index.saving", filename);
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    if (fd < 0) {
+        return false;
+    }
+
+    // The header is written last, once the entries are counted.
+    SnapshotWriter writer;
+    writer.fd = fd;
+    writer.block_size = 0;
+    writer.count = 0;
+    writer.checksum = 0;
+    writer.is_ok = lseek(fd, INDEX_SNAPSHOT_HEADER_SIZE_IN_BYTES, SEEK_SET) == INDEX_SNAPSHOT_HEADER_SIZE_IN_BYTES;
+    DirectoryIndex_for_each(directory->index, add_snapshot_entry, &writer);
+    flush_snapshot_block(&writer);
+
+    uint8_t header[INDEX_SNAPSHOT_HEADER_SIZE_IN_BYTES];
+    encode_snapshot_header(header, directory->index->backend->name, writer.count, directory->snapshot_id + 1, writer.checksum);
+    writer.is_ok = writer.is_ok && pwrite(fd, header, INDEX_SNAPSHOT_HEADER_SIZE_IN_BYTES, 0) == INDEX_SNAPSHOT_HEADER_SIZE_IN_BYTES;
+    // The snapshot must be on the disk before it replaces the previous one.
+    writer.is_ok = writer.is_ok && fsync(fd) == 0;
+    close(fd);
+    return writer.is_ok;
+}
+
+/**
+ * @brief Ends the save of the snapshot of the index. A snapshot that has been saved replaces the previous one along
+ * with its journal, otherwise its files are removed.
+ *
+ * @param directory The directory.
+ * @param is_saved true = the child process has written the snapshot of each shard.
+ */
+static void finish_index_save(Directory *directory, bool is_saved) {
+    for (int i = 0; i < count_shards(directory); i++) {
+        Directory *shard = get_shard(directory, i);
+        char saving_filename[FILENAME_MAXLEN + 16];
+        char filename[FILENAME_MAXLEN + 16];
+
+        // The journals are written with the lock held.
+        pthread_rwlock_wrlock(&shard->lock);
+
+        if (is_saved) {
+            // The snapshot is renamed first, if the program stops before the journal is renamed the new snapshot does
+            // not match the journal and the database is read entirely.
+            get_snapshot_filename(shard, ".index.saving", saving_filename);
+            get_snapshot_filename(shard, ".index", filename);
+            rename(saving_filename, filename);
+            get_snapshot_filename(shard, ".journal.saving", saving_filename);
+            get_snapshot_filename(shard, ".journal", filename);
+            rename(saving_filename, filename);
+
+            if (shard->journal_fd >= 0) {
+                close(shard->journal_fd);
+            }
+
+            shard->journal_fd = shard->next_journal_fd;
+            shard->snapshot_id++;
+        } else {
+            get_snapshot_filename(shard, ".index.saving", saving_filename);
+            unlink(saving_filename);
+            get_snapshot_filename(shard, ".journal.saving", saving_filename);
+            unlink(saving_filename);
+            close(shard->next_journal_fd);
+        }
+
+        shard->next_journal_fd = -1;
+        pthread_rwlock_unlock(&shard->lock);
+    }
+
+    if (!is_saved) {
+        fprintf(stderr, "The snapshot of the index of \"%s\" could not be saved.\n", directory->database_filename);
+    }
+
+    directory->snapshot_pid = -1;
+}
+
+bool Directory_save_index(Directory *directory) {
+    if (Directory_is_saving_index(directory)) {
+        return false;
+    }
+
+    // The modifications are blocked while the process is forked, so that the new journal of each shard starts exactly
+    // where its snapshot ends. The child gets a copy of the memory, so the locks are only held for as long as fork.
+    for (int i = 0; i < count_shards(directory); i++) {
+        Directory *shard = get_shard(directory, i);
+        pthread_rwlock_rdlock(&shard->lock);
+        shard->next_journal_fd = create_journal(shard, ".journal.saving", shard->snapshot_id + 1);
+    }
+
+    pid_t pid = fork();
+
+    if (pid == 0) {
+        // Only the thread that called fork exists in the child, a lock held by another thread at that moment would
+        // never be released. So the child does not allocate memory, it only makes system calls until it exits.
+        bool is_ok = true;
+        for (int i = 0; i < count_shards(directory); i++) {
+            is_ok = write_snapshot(get_shard(directory, i)) && is_ok;
+        }
+
+        _exit(is_ok ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < count_shards(directory); i++) {
+        pthread_rwlock_unlock(&get_shard(directory, i)->lock);
+    }
+
+    if (pid < 0) {
+        finish_index_save(directory, false);
+        return false;
+    }
+
+    directory->snapshot_pid = pid;
+    return true;
+}
+
+bool Directory_is_saving_index(Directory *directory) {
+    if (directory->snapshot_pid == -1) {
+        return false;
+    }
+
+    int status;
+    pid_t pid = waitpid(directory->snapshot_pid, &status, WNOHANG);
+
+    if (pid == 0) {
+        return true;
+    }
+
+    finish_index_save(directory, pid == directory->snapshot_pid && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS);
+    return false;
+}
+
+bool Directory_wait_index_save(Directory *directory) {
+    if (directory->snapshot_pid == -1) {
+        return false;
+    }
+
+    int status;
+    pid_t pid = waitpid(directory->snapshot_pid, &status, 0);
+    bool is_saved = pid == directory->snapshot_pid && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+    finish_index_save(directory, is_saved);
+    return is_saved;
+}
+
+/**
+ * @brief Data structure that represents the state of an export to a column store.
+ *
+ */
+typedef struct ColumnsExport {
+    ColumnStore *store;
+    DirectoryRecord **records;
+    int record_count;
+} ColumnsExport;
+
+/**
+ * @brief Appends the pending records to the column store.
+ *
+ * @param export The export.
+ */
+static void flush_columns_export(ColumnsExport *export) {
+    ColumnStore_append_batch(export->store, export->records, export->record_count);
+
+    for (int i = 0; i < export->record_count; i++) {
+        DirectoryRecord_destroy(&export->records[i]);
+    }
+
+    export->record_count = 0;
+}
+
+/**
+ * @brief Adds a record to the export, the records are appended to the column store by blocks.
+ *
+ * @param data_ptr The position of the record in the database file.
+ * @param bytes The record as stored on disk.
+ * @param is_intact false = the record does not match its checksum.
+ * @param context The export.
+ */
+static void export_record(uint64_t data_ptr, uint8_t *bytes, bool is_intact, void *context) {
+    (void)data_ptr;
+
+    if (!is_intact) {
+        // A corrupted record is left out.
+        return;
+    }
+
+    ColumnsExport *export = (ColumnsExport *)context;
+    ByteArray byte_array = {bytes, DirectoryRecord_size_on_disk()};
+    export->records[export->record_count] = ByteArray_to_DirectoryRecord(&byte_array);
+    export->record_count++;
+
+    if (export->record_count == COLUMN_STORE_SCAN_BLOCK_SIZE) {
+        flush_columns_export(export);
+    }
+}
+
+void Directory_export_columns(Directory *directory, ColumnStore *store) {
+    ColumnStore_clear(store);
+    ColumnsExport export;
+    export.store = store;
+    export.records = (DirectoryRecord **)malloc(sizeof(DirectoryRecord *) * COLUMN_STORE_SCAN_BLOCK_SIZE);
+    export.record_count = 0;
+
+    for (int i = 0; i < count_shards(directory); i++) {
+        Directory *shard = get_shard(directory, i);
+        pthread_rwlock_rdlock(&shard->lock);
+        for_each_live_record(shard, export_record, &export);
+        pthread_rwlock_unlock(&shard->lock);
+    }
+
+    flush_columns_export(&export);
+    free(export.records);
+}
+
+int Directory_count(Directory *directory) {
+    int count = 0;
+
+    for (int i = 0; i < count_shards(directory); i++) {
+        Directory *shard = get_shard(directory, i);
+        pthread_rwlock_rdlock(&shard->lock);
+        count += shard->slot_count - Bitmap_count(shard->tombstones);
+        pthread_rwlock_unlock(&shard->lock);
+    }
+
+    return count;
+}
+
+/**
+ * @brief Displays a record on the console while the directory is displayed.
+ *
+ * @param data_ptr The position of the record in the database file.
+ * @param bytes The record as stored on disk.
+ * @param is_intact false = the record does not match its checksum.
+ * @param context The number of records displayed so far, it is incremented.
+ */
+static void print_record(uint64_t data_ptr, uint8_t *bytes, bool is_intact, void *context) {
+    (void)data_ptr;
+
+    if (!is_intact) {
+        // A corrupted record is left out.
+        return;
+    }
+
+    int *record_count = (int *)context;
+    ByteArray byte_array = {bytes, DirectoryRecord_size_on_disk()};
+    DirectoryRecord *record = ByteArray_to_DirectoryRecord(&byte_array);
+
+    if (*record_count == 0) {
+        printf("========================\n");
+    } else {
+        printf("------------------------\n");
+    }
+
+    DirectoryRecord_print(record);
+    DirectoryRecord_destroy(&record);
+    (*record_count)++;
+}
+
+void Directory_print(Directory *directory) {
+    int record_count = 0;
+
+    for (int i = 0; i < count_shards(directory); i++) {
+        Directory *shard = get_shard(directory, i);
+        pthread_rwlock_rdlock(&shard->lock);
+        for_each_live_record(shard, print_record, &record_count);
+        pthread_rwlock_unlock(&shard->lock);
+    }
+
+    if (record_count == 0) {
+        printf("===>The directory is empty.\n");
+    } else {
+        printf("========================\n");
+    }
+}
+
+/**
+ * @brief Appends a record to a shard.
+ *
+ * @param directory The shard.
+ * @param key The key of the phone number of the record.
+ * @param record The record to be added.
+ * @return true The record could be added.
+ * @return false The record could not be added.
  */
-static void rebuild_index(Directory *directory) {
+static bool append_record(Directory *directory, uint64_t key, DirectoryRecord *record) {
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_INDEX);
+    uint64_t a;
+    if (index_search(directory, key, &a)) {
+        // The phone number is already used in another record.
+        return false;
+    }
+
+    // The slot of a deleted record is reused if there is one, otherwise the record is written after the last slot.
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_IO);
+    int slot = Bitmap_find_next_set(directory->tombstones, directory->free_slot_cursor);
+    uint64_t data_ptr;
+
+    if (slot != -1) {
+        data_ptr = get_data_ptr(slot);
+        journal_slot(directory, slot);
+        write_record(directory, data_ptr, record);
+        // The record is written before its slot is marked as alive, so that a crash in between only loses the record.
+        Bitmap_clear(directory->tombstones, slot);
+        save_tombstone(directory, slot);
+        directory->free_slot_cursor = slot + 1;
+    } else {
+        data_ptr = get_data_ptr(directory->slot_count);
+        journal_slot(directory, directory->slot_count);
+        write_record(directory, data_ptr, record);
+        directory->slot_count++;
+        Bitmap_resize(directory->tombstones, directory->slot_count);
+        directory->free_slot_cursor = directory->slot_count;
+    }
+
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_INDEX);
+    thaw(directory);
+    DirectoryIndex_insert(directory->index, key, data_ptr);
+
+    if (directory->filter != NULL) {
+        if (directory->filter->size >= directory->filter->capacity) {
+            // The filter is saturated, it is rebuilt with a larger capacity.
+            rebuild_filter(directory);
+        } else {
+            BloomFilter_add(directory->filter, key);
+        }
+    }
+
+    return true;
+}
+
+bool Directory_append(Directory *directory, DirectoryRecord *record) {
+    DIRECTORY_TIME_BEGIN(DIRECTORY_OPERATION_APPEND);
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_HASH);
+    uint64_t hash = hash_string(record->phone_number);
+    Directory *shard = find_shard(directory, hash);
+
+    uint64_t key;
+    if (!compute_key(shard, record->phone_number, hash, &key)) {
+        DIRECTORY_TIME_END();
+        return false;
+    }
+
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_OTHER);
+    pthread_rwlock_wrlock(&shard->lock);
+    bool is_appended = append_record(shard, key, record);
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_OTHER);
+    pthread_rwlock_unlock(&shard->lock);
+
+    DIRECTORY_TIME_END();
+    return is_appended;
+}
+
+/**
+ * @brief Reads a record of the database file.
+ *
+ * @param fp The database file.
+ * @param data_ptr The position of the record.
+ * @return DirectoryRecord* The record, NULL if it is corrupted.
+ */
+static DirectoryRecord *read_record(FILE *fp, uint64_t data_ptr) {
+    fseek(fp, data_ptr, SEEK_SET);
+    ByteArray *byte_array = ByteArray_init(get_slot_size());
+    byte_array->size = fread(byte_array->items, 1, get_slot_size(), fp);
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_DECODE);
+
+    if (byte_array->size != get_slot_size() || !is_record_intact(byte_array->items)) {
+        // The record is corrupted, it is not returned.
+        ByteArray_destroy(&byte_array);
+        return NULL;
+    }
+
+    byte_array->size = DirectoryRecord_size_on_disk();
+
+    DirectoryRecord *record = ByteArray_to_DirectoryRecord(byte_array);
+    ByteArray_destroy(&byte_array);
+    return record;
+}
+
+/**
+ * @brief Searches for a record in a shard.
+ *
+ * @param directory The shard.
+ * @param key The key of the phone number of the record.
+ * @return DirectoryRecord* The corresponding record, NULL if not found.
+ */
+static DirectoryRecord *search_record(Directory *directory, uint64_t key) {
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_INDEX);
+    uint64_t data_ptr;
+    if (!index_search(directory, key, &data_ptr)) {
+        // The record was not found.
+        return NULL;
+    }
+
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_IO);
     FILE *fp;
     fp = fopen(directory->database_filename, "rb");
 
     if (fp == NULL) {
-        return;
+        exit(EXIT_FAILURE);
     }
 
-    long file_size = get_file_size(fp);
+    DirectoryRecord *record = read_record(fp, data_ptr);
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_IO);
+    fclose(fp);
+    return record;
+}
 
-    while (true) {
-        uint64_t data_ptr = (uint64_t)ftell(fp);
-        uint8_t is_deleted;
-        fread(&is_deleted, 1, 1, fp);
+DirectoryRecord *Directory_search(Directory *directory, char phone_number[PHONE_NUMBER_MAXLEN]) {
+    DIRECTORY_TIME_BEGIN(DIRECTORY_OPERATION_SEARCH);
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_HASH);
+    uint64_t hash = hash_string(phone_number);
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_OTHER);
 
-        if ((bool)is_deleted) {
-            // This record has been deleted, go to the next one.
-            fseek(fp, DirectoryRecord_size_on_disk() - IS_DELETED_SIZE_IN_BYTES, SEEK_CUR);
-        } else {
-            // The record has not been deleted.
-            char phone_number[PHONE_NUMBER_MAXLEN];
-            phone_number[PHONE_NUMBER_MAXLEN - 1] = '\0';
-            // The phone number is read.
-            fread(phone_number, 1, PHONE_NUMBER_MAXLEN_WITHOUT_NULL_CHARACTER, fp);
-            // The record is indexed.
-            BPTree_insert(directory->index, hash_string(phone_number), data_ptr);
-            fseek(fp, DirectoryRecord_size_on_disk() - IS_DELETED_SIZE_IN_BYTES - PHONE_NUMBER_MAXLEN_WITHOUT_NULL_CHARACTER, SEEK_CUR);
-        }
-
-        if (ftell(fp) == file_size) {
-            // The end of the file has been reached.
-            break;
+    if (directory->cache != NULL) {
+        DirectoryRecord *record = RecordCache_get(directory->cache, hash);
+
+        if (record != NULL) {
+            // Neither the index nor the database file is read.
+            DIRECTORY_TIME_END();
+            return record;
         }
     }
 
-    fclose(fp);
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_HASH);
+    Directory *shard = find_shard(directory, hash);
+
+    uint64_t key;
+    if (!compute_key(shard, phone_number, hash, &key)) {
+        DIRECTORY_TIME_END();
+        return NULL;
+    }
+
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_OTHER);
+    pthread_rwlock_rdlock(&shard->lock);
+    DirectoryRecord *record = search_record(shard, key);
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_OTHER);
+
+    if (record != NULL && directory->cache != NULL) {
+        // The record is cached before the lock is released, so that an update or a deletion of the record, which
+        // takes the lock for writing, cannot invalidate it first and leave a stale copy in the cache.
+        RecordCache_put(directory->cache, hash, record);
+    }
+
+    pthread_rwlock_unlock(&shard->lock);
+
+    DIRECTORY_TIME_END();
+    return record;
 }
 
-Directory *Directory_init(char database_filename[FILENAME_MAXLEN]) {
-    Directory *directory = (Directory *)malloc(sizeof(Directory));
-    strcpy(directory->database_filename, database_filename);
-    directory->index = BPTree_init(DEFAULT_ORDER);
-    rebuild_index(directory);
-    return directory;
+/**
+ * @brief Data structure that represents the results of a batch search, in the order in which they are obtained.
+ *
+ */
+typedef struct SearchResults {
+    int *indexes;
+    DirectoryRecord **records;
+    int count;
+} SearchResults;
+
+/**
+ * @brief Adds a result to the results of a batch search.
+ *
+ * @param results The results.
+ * @param index The index of the phone number in the batch.
+ * @param record The record, NULL if not found.
+ */
+static void add_search_result(SearchResults *results, int index, DirectoryRecord *record) {
+    results->indexes[results->count] = index;
+    results->records[results->count] = record;
+    results->count++;
 }
 
-void Directory_destroy(Directory **directory) {
-    BPTree_destroy(&(*directory)->index);
-    free(*directory);
-    *directory = NULL;
+/**
+ * @brief Data structure that represents the state of a batch search while its reads complete.
+ *
+ */
+typedef struct SearchBatch {
+    AsyncRead *reads;
+    int *indexes;
+    SearchResults *results;
+} SearchBatch;
+
+/**
+ * @brief Decodes the record of a completed read and adds it to the results of the batch.
+ *
+ * @param read_index The index of the read.
+ * @param is_ok true = the record has been read.
+ * @param context The batch.
+ */
+static void complete_search(int read_index, bool is_ok, void *context) {
+    SearchBatch *batch = (SearchBatch *)context;
+    DirectoryRecord *record = NULL;
+
+    // A corrupted record is reported as not found.
+    if (is_ok && is_record_intact(batch->reads[read_index].buffer)) {
+        ByteArray byte_array = {batch->reads[read_index].buffer, DirectoryRecord_size_on_disk()};
+        record = ByteArray_to_DirectoryRecord(&byte_array);
+    }
+
+    add_search_result(batch->results, batch->indexes[read_index], record);
 }
 
-void Directory_print(Directory *directory) {
+/**
+ * @brief Searches for many records of a shard at once.
+ *
+ * @param directory The shard.
+ * @param reader The reader of the directory.
+ * @param keys The keys of the phone numbers.
+ * @param indexes The indexes of the phone numbers in the batch.
+ * @param count The number of phone numbers.
+ * @param results The results are added to these ones.
+ */
+static void search_records(Directory *directory, AsyncReader *reader, uint64_t *keys, int *indexes, int count, SearchResults *results) {
+    SearchBatch batch;
+    batch.reads = (AsyncRead *)malloc(sizeof(AsyncRead) * (count > 0 ? count : 1));
+    batch.indexes = (int *)malloc(sizeof(int) * (count > 0 ? count : 1));
+    batch.results = results;
+
+    // All the records are read into the same buffer.
+    uint8_t *buffer = (uint8_t *)malloc(get_slot_size() * (count > 0 ? count : 1));
+    int read_count = 0;
+
+    for (int i = 0; i < count; i++) {
+        uint64_t data_ptr;
+
+        if (!index_search(directory, keys[i], &data_ptr)) {
+            // The record was not found, there is nothing to read.
+            add_search_result(results, indexes[i], NULL);
+            continue;
+        }
+
+        batch.reads[read_count].offset = data_ptr;
+        batch.reads[read_count].buffer = buffer + read_count * get_slot_size();
+        batch.reads[read_count].size = get_slot_size();
+        batch.indexes[read_count] = indexes[i];
+        read_count++;
+    }
+
+    if (read_count > 0) {
+        int fd = open(directory->database_filename, O_RDONLY);
+
+        if (fd < 0) {
+            exit(EXIT_FAILURE);
+        }
+
+        AsyncReader_read_all(reader, fd, batch.reads, read_count, complete_search, &batch);
+        close(fd);
+    }
+
+    free(buffer);
+    free(batch.reads);
+    free(batch.indexes);
+}
+
+void Directory_search_batch(Directory *directory, char phone_numbers[][PHONE_NUMBER_MAXLEN], int count, DirectorySearchCallback callback, void *context) {
+    uint64_t *hashes = (uint64_t *)malloc(sizeof(uint64_t) * (count > 0 ? count : 1));
+    uint64_t *keys = (uint64_t *)malloc(sizeof(uint64_t) * (count > 0 ? count : 1));
+    int *indexes = (int *)malloc(sizeof(int) * (count > 0 ? count : 1));
+    SearchResults results;
+    results.indexes = (int *)malloc(sizeof(int) * (count > 0 ? count : 1));
+    results.records = (DirectoryRecord **)malloc(sizeof(DirectoryRecord *) * (count > 0 ? count : 1));
+
+    for (int i = 0; i < count; i++) {
+        hashes[i] = hash_string(phone_numbers[i]);
+    }
+
+    // The phone numbers are grouped by shard, each shard reads its own database file.
+    for (int i = 0; i < count_shards(directory); i++) {
+        Directory *shard = get_shard(directory, i);
+        int shard_batch_count = 0;
+
+        for (int j = 0; j < count; j++) {
+            if (find_shard(directory, hashes[j]) != shard) {
+                continue;
+            }
+
+            if (!compute_key(shard, phone_numbers[j], hashes[j], &keys[shard_batch_count])) {
+                callback(j, NULL, context);
+            } else {
+                indexes[shard_batch_count] = j;
+                shard_batch_count++;
+            }
+        }
+
+        results.count = 0;
+        pthread_rwlock_rdlock(&shard->lock);
+        search_records(shard, directory->reader, keys, indexes, shard_batch_count, &results);
+        pthread_rwlock_unlock(&shard->lock);
+
+        // The results are delivered once the lock of the shard and the reader are released, so the callback may
+        // modify the directory and the other batches are not held up by it.
+        for (int j = 0; j < results.count; j++) {
+            callback(results.indexes[j], results.records[j], context);
+        }
+    }
+
+    free(hashes);
+    free(keys);
+    free(indexes);
+    free(results.indexes);
+    free(results.records);
+}
+
+/**
+ * @brief Data structure that represents the state of a search by prefix.
+ *
+ */
+typedef struct PrefixSearch {
     FILE *fp;
-    fp = fopen(directory->database_filename, "rb");
+    DirectorySearchCallback callback;
+    void *context;
+    int count;
+} PrefixSearch;
 
-    if (fp == NULL) {
-        printf("===>The directory is empty.\n");
-        return;
+/**
+ * @brief Reads a record found by a search by prefix and passes it to the callback.
+ *
+ * @param key The key of the phone number.
+ * @param data_ptr The position of the record in the database file.
+ * @param context The search.
+ */
+static void deliver_record(uint64_t key, uint64_t data_ptr, void *context) {
+    (void)key;
+    PrefixSearch *search = (PrefixSearch *)context;
+    DirectoryRecord *record = read_record(search->fp, data_ptr);
+
+    if (record != NULL) {
+        search->callback(search->count, record, search->context);
+        search->count++;
+    }
+}
+
+int Directory_search_prefix(Directory *directory, char prefix[PHONE_NUMBER_MAXLEN], DirectorySearchCallback callback, void *context) {
+    if (directory->index->backend->for_each_prefix == NULL) {
+        return -1;
+    }
+
+    PrefixSearch search = {NULL, callback, context, 0};
+
+    for (int i = 0; i < count_shards(directory); i++) {
+        Directory *shard = get_shard(directory, i);
+        pthread_rwlock_rdlock(&shard->lock);
+        search.fp = fopen(shard->database_filename, "rb");
+
+        // Without a database file, the shard has no records.
+        if (search.fp != NULL) {
+            DirectoryIndex_for_each_prefix(shard->index, prefix, deliver_record, &search);
+            fclose(search.fp);
+        }
+
+        pthread_rwlock_unlock(&shard->lock);
     }
 
-    long file_size = get_file_size(fp);
-    printf("========================\n");
-    int i = 0;
+    return search.count;
+}
+
+/**
+ * @brief Data structure that represents the state of a scan shared by its threads.
+ *
+ */
+typedef struct DirectoryScan {
+    Directory *directory;
+    DirectoryScanPredicate predicate;
+    DirectorySearchCallback callback;
+    void *context;
+    // The blocks are numbered over all the shards, first_blocks[i] is the number of the first block of shard i.
+    int *first_blocks;
+    int block_count;
+    // The number of the next block to be read, each thread takes the next one once it is done with its block.
+    int next_block;
+    // The callback is called by one thread at a time.
+    pthread_mutex_t callback_lock;
+    int match_count;
+} DirectoryScan;
+
+/**
+ * @brief Data structure that represents what a thread of a scan uses while it reads its blocks.
+ *
+ */
+typedef struct DirectoryScanThread {
+    DirectoryScan *scan;
+    // One file descriptor per shard, opened when a block of the shard is first read, -1 = not opened.
+    int *fds;
+    uint8_t *block;
+    DirectoryRecord **matches;
+} DirectoryScanThread;
+
+/**
+ * @brief Reads a block of records of a shard, tests the records alive and decodes those selected. The records are
+ * tested with the lock of the shard held, but the callback is called once the lock is released, so that it can use
+ * the directory.
+ *
+ * @param thread The thread.
+ * @param shard_index The position of the shard.
+ * @param first_slot The first slot of the block.
+ */
+static void scan_block(DirectoryScanThread *thread, int shard_index, int first_slot) {
+    DirectoryScan *scan = thread->scan;
+    Directory *shard = get_shard(scan->directory, shard_index);
+    int slot_size = get_slot_size();
+    int match_count = 0;
+
+    pthread_rwlock_rdlock(&shard->lock);
+    int block_size = shard->slot_count - first_slot < DIRECTORY_SCAN_BLOCK_SIZE ? shard->slot_count - first_slot : DIRECTORY_SCAN_BLOCK_SIZE;
+    int first_alive = Bitmap_find_next_clear(shard->tombstones, first_slot);
+
+    // The block is not read if its records are all deleted.
+    if (block_size > 0 && first_alive != -1 && first_alive < first_slot + block_size) {
+        if (thread->fds[shard_index] == -1) {
+            thread->fds[shard_index] = open(shard->database_filename, O_RDONLY);
+        }
 
-    while (true) {
-        // Reads and displays all records.
-        ByteArray *byte_array = ByteArray_init(DirectoryRecord_size_on_disk());
+        ssize_t size = thread->fds[shard_index] >= 0 ? pread(thread->fds[shard_index], thread->block, (size_t)slot_size * block_size, get_data_ptr(first_slot)) : 0;
+        block_size = size > 0 ? size / slot_size : 0;
 
-        fread(byte_array->items, 1, DirectoryRecord_size_on_disk(), fp);
-        byte_array->size = DirectoryRecord_size_on_disk();
-        bool is_deleted = (bool)byte_array->items[0];
+        for (int i = 0; i < block_size; i++) {
+            uint8_t *bytes = thread->block + i * slot_size;
 
-        if (!is_deleted) {
-            DirectoryRecord *record = ByteArray_to_DirectoryRecord(byte_array);
-            if (i != 0) {
-                printf("------------------------\n");
+            // A corrupted record is left out, like a deleted one.
+            if (!Bitmap_get(shard->tombstones, first_slot + i) && is_record_intact(bytes) && scan->predicate(bytes, scan->context)) {
+                ByteArray byte_array = {bytes, DirectoryRecord_size_on_disk()};
+                thread->matches[match_count++] = ByteArray_to_DirectoryRecord(&byte_array);
             }
-            DirectoryRecord_print(record);
-            DirectoryRecord_destroy(&record);
-            i++;
         }
+    }
 
-        ByteArray_destroy(&byte_array);
+    pthread_rwlock_unlock(&shard->lock);
 
-        if (ftell(fp) == file_size) {
-            break;
+    if (match_count == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&scan->callback_lock);
+    for (int i = 0; i < match_count; i++) {
+        scan->callback(scan->match_count++, thread->matches[i], scan->context);
+    }
+    pthread_mutex_unlock(&scan->callback_lock);
+}
+
+/**
+ * @brief Work of a thread of a scan, it reads blocks until there are none left.
+ *
+ * @param arg The scan.
+ * @return void* Always NULL.
+ */
+static void *scan_blocks(void *arg) {
+    DirectoryScan *scan = (DirectoryScan *)arg;
+    int shard_count = count_shards(scan->directory);
+
+    DirectoryScanThread thread;
+    thread.scan = scan;
+    thread.fds = (int *)malloc(sizeof(int) * shard_count);
+    thread.block = (uint8_t *)malloc(get_slot_size() * DIRECTORY_SCAN_BLOCK_SIZE);
+    thread.matches = (DirectoryRecord **)malloc(sizeof(DirectoryRecord *) * DIRECTORY_SCAN_BLOCK_SIZE);
+
+    for (int i = 0; i < shard_count; i++) {
+        thread.fds[i] = -1;
+    }
+
+    int shard_index = 0;
+    int block_number;
+
+    while ((block_number = __atomic_fetch_add(&scan->next_block, 1, __ATOMIC_RELAXED)) < scan->block_count) {
+        // The blocks taken by a thread are increasing, so the shard is searched from the previous one.
+        while (scan->first_blocks[shard_index + 1] <= block_number) {
+            shard_index++;
         }
+
+        scan_block(&thread, shard_index, (block_number - scan->first_blocks[shard_index]) * DIRECTORY_SCAN_BLOCK_SIZE);
     }
 
-    printf("========================\n");
-    fclose(fp);
+    for (int i = 0; i < shard_count; i++) {
+        if (thread.fds[i] >= 0) {
+            close(thread.fds[i]);
+        }
+    }
+
+    free(thread.fds);
+    free(thread.block);
+    free(thread.matches);
+    return NULL;
 }
 
-bool Directory_append(Directory *directory, DirectoryRecord *record) {
-    uint64_t a;
-    if (BPTree_search(directory->index, hash_string(record->phone_number), &a)) {
-        // The phone number is already used in another record.
-        return false;
+int Directory_scan(Directory *directory, DirectoryScanPredicate predicate, DirectorySearchCallback callback, void *context, int thread_count) {
+    int shard_count = count_shards(directory);
+    DirectoryScan scan;
+    scan.directory = directory;
+    scan.predicate = predicate;
+    scan.callback = callback;
+    scan.context = context;
+    scan.first_blocks = (int *)malloc(sizeof(int) * (shard_count + 1));
+    scan.next_block = 0;
+    pthread_mutex_init(&scan.callback_lock, NULL);
+    scan.match_count = 0;
+
+    // The blocks are those of the slots that exist when the scan starts.
+    scan.first_blocks[0] = 0;
+    for (int i = 0; i < shard_count; i++) {
+        Directory *shard = get_shard(directory, i);
+        pthread_rwlock_rdlock(&shard->lock);
+        scan.first_blocks[i + 1] = scan.first_blocks[i] + (shard->slot_count + DIRECTORY_SCAN_BLOCK_SIZE - 1) / DIRECTORY_SCAN_BLOCK_SIZE;
+        pthread_rwlock_unlock(&shard->lock);
     }
+    scan.block_count = scan.first_blocks[shard_count];
 
-    // Writes the record to the file.
-    FILE *fp;
-    fp = fopen(directory->database_filename, "ab");
+    // There is no use for more threads than blocks.
+    if (thread_count > scan.block_count) {
+        thread_count = scan.block_count;
+    }
 
-    if (fp == NULL) {
-        exit(EXIT_FAILURE);
+    pthread_t *threads = (pthread_t *)malloc(sizeof(pthread_t) * (thread_count > 1 ? thread_count - 1 : 1));
+    for (int i = 0; i < thread_count - 1; i++) {
+        pthread_create(&threads[i], NULL, scan_blocks, &scan);
     }
 
-    ByteArray *byte_array = DirectoryRecord_to_ByteArray(record);
-    fwrite(byte_array->items, 1, byte_array->size, fp);
-    ByteArray_destroy(&byte_array);
+    scan_blocks(&scan);
 
-    uint64_t data_ptr = (uint64_t)ftell(fp) - DirectoryRecord_size_on_disk();
-    fclose(fp);
+    for (int i = 0; i < thread_count - 1; i++) {
+        pthread_join(threads[i], NULL);
+    }
 
-    BPTree_insert(directory->index, hash_string(record->phone_number), data_ptr);
-    return true;
+    free(threads);
+    free(scan.first_blocks);
+    pthread_mutex_destroy(&scan.callback_lock);
+    return scan.match_count;
 }
 
-DirectoryRecord *Directory_search(Directory *directory, char phone_number[PHONE_NUMBER_MAXLEN]) {
+/**
+ * @brief Updates a record of a shard.
+ *
+ * @param directory The shard.
+ * @param key The key of the phone number of the record.
+ * @param record The new content of the record.
+ * @return true The record could be updated.
+ * @return false The record could not be updated.
+ */
+static bool update_record(Directory *directory, uint64_t key, DirectoryRecord *record) {
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_INDEX);
     uint64_t data_ptr;
-    if (!BPTree_search(directory->index, hash_string(phone_number), &data_ptr)) {
-        // The record was not found.
-        return NULL;
+    if (!index_search(directory, key, &data_ptr)) {
+        // There is no record to update for this phone number.
+        return false;
     }
 
-    FILE *fp;
-    fp = fopen(directory->database_filename, "rb");
+    // The record has a fixed size, so it is overwritten in place and the index remains valid.
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_IO);
+    write_record(directory, data_ptr, record);
+    return true;
+}
 
-    if (fp == NULL) {
-        exit(EXIT_FAILURE);
+bool Directory_update(Directory *directory, DirectoryRecord *record) {
+    DIRECTORY_TIME_BEGIN(DIRECTORY_OPERATION_UPDATE);
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_HASH);
+    uint64_t hash = hash_string(record->phone_number);
+    Directory *shard = find_shard(directory, hash);
+
+    uint64_t key;
+    if (!compute_key(shard, record->phone_number, hash, &key)) {
+        DIRECTORY_TIME_END();
+        return false;
     }
 
-    fseek(fp, data_ptr, SEEK_SET);
-    ByteArray *byte_array = ByteArray_init(DirectoryRecord_size_on_disk());
-    fread(byte_array->items, 1, DirectoryRecord_size_on_disk(), fp);
-    byte_array->size = DirectoryRecord_size_on_disk();
-    fclose(fp);
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_OTHER);
+    pthread_rwlock_wrlock(&shard->lock);
+    bool is_updated = update_record(shard, key, record);
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_OTHER);
 
-    DirectoryRecord *record = ByteArray_to_DirectoryRecord(byte_array);
-    ByteArray_destroy(&byte_array);
-    return record;
+    if (is_updated && directory->cache != NULL) {
+        RecordCache_invalidate(directory->cache, hash);
+    }
+
+    pthread_rwlock_unlock(&shard->lock);
+
+    DIRECTORY_TIME_END();
+    return is_updated;
 }
 
-bool Directory_delete(Directory *directory, char phone_number[PHONE_NUMBER_MAXLEN]) {
+/**
+ * @brief Deletes a record from a shard.
+ *
+ * @param directory The shard.
+ * @param key The key of the phone number of the record.
+ * @return true The record could be deleted.
+ * @return false The record could not be deleted.
+ */
+static bool delete_record(Directory *directory, uint64_t key) {
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_INDEX);
     uint64_t data_ptr;
-    if (!BPTree_search(directory->index, hash_string(phone_number), &data_ptr)) {
+    if (!index_search(directory, key, &data_ptr)) {
         // The record to be deleted does not exist.
         return false;
     }
 
-    FILE *fp;
-    fp = fopen(directory->database_filename, "r+b");
+    // The bitmap is saved first, it is what the directory reads when it is opened again.
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_IO);
+    int slot = get_slot(data_ptr);
+    journal_slot(directory, slot);
+    Bitmap_set(directory->tombstones, slot);
+    save_tombstone(directory, slot);
+    write_deletion_flag(directory, slot);
 
-    if (fp == NULL) {
-        exit(EXIT_FAILURE);
+    if (slot < directory->free_slot_cursor) {
+        directory->free_slot_cursor = slot;
     }
 
-    fseek(fp, data_ptr, SEEK_SET);
-    uint8_t is_deleted = (uint8_t) true;
-    fwrite(&is_deleted, 1, 1, fp);
-    fclose(fp);
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_INDEX);
+    thaw(directory);
+    DirectoryIndex_delete(directory->index, key);
+
+    if (directory->filter != NULL) {
+        // A Bloom filter cannot forget a key, it is rebuilt once too many of its keys have been deleted.
+        directory->filter_stale_count++;
+
+        if (2 * directory->filter_stale_count > directory->filter->size) {
+            rebuild_filter(directory);
+        }
+    }
 
-    BPTree_delete(directory->index, hash_string(phone_number));
     return true;
 }
+
+bool Directory_delete(Directory *directory, char phone_number[PHONE_NUMBER_MAXLEN]) {
+    DIRECTORY_TIME_BEGIN(DIRECTORY_OPERATION_DELETE);
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_HASH);
+    uint64_t hash = hash_string(phone_number);
+    Directory *shard = find_shard(directory, hash);
+
+    uint64_t key;
+    if (!compute_key(shard, phone_number, hash, &key)) {
+        DIRECTORY_TIME_END();
+        return false;
+    }
+
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_OTHER);
+    pthread_rwlock_wrlock(&shard->lock);
+    bool is_deleted = delete_record(shard, key);
+    DIRECTORY_TIME_PHASE(DIRECTORY_PHASE_OTHER);
+
+    if (is_deleted && directory->cache != NULL) {
+        RecordCache_invalidate(directory->cache, hash);
+    }
+
+    pthread_rwlock_unlock(&shard->lock);
+
+    DIRECTORY_TIME_END();
+    return is_deleted;
+}
@@ -7,13 +7,45 @@
 #ifndef DIRECTORY_H
 #define DIRECTORY_H
 
+#include <pthread.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
 
-#include "BPTree.h"
+#include "AsyncReader.h"
+#include "Bitmap.h"
+#include "BloomFilter.h"
+#include "ColumnStore.h"
+#include "DirectoryIndex.h"
 #include "DirectoryRecord.h"
+#include "RecordCache.h"
+#include "StaticIndex.h"
 
-#define DEFAULT_ORDER 2
 #define FILENAME_MAXLEN 100
+#define DEFAULT_CACHE_CAPACITY 65536
+#define DIRECTORY_SCAN_BLOCK_SIZE 4096
+
+// The database file starts with a header: the magic number, the version of the format, the size of a record and
+// the checksum of the header. Each record is followed by its checksum.
+#define DIRECTORY_MAGIC "BPTREEDB"
+#define DIRECTORY_MAGIC_SIZE_IN_BYTES 8
+#define DIRECTORY_FORMAT_VERSION 1
+#define DIRECTORY_HEADER_SIZE_IN_BYTES 32
+#define CHECKSUM_SIZE_IN_BYTES 4
+
+// The snapshot of the index starts with a header: the magic number, the version of the format, the number of keys,
+// the identifier of the snapshot, the name of the kind of index, the checksum of the entries and the checksum of the
+// header. Each entry is a key followed by the slot of its record.
+#define INDEX_SNAPSHOT_MAGIC "BPTREEIX"
+#define INDEX_SNAPSHOT_FORMAT_VERSION 1
+#define INDEX_SNAPSHOT_HEADER_SIZE_IN_BYTES 48
+#define INDEX_SNAPSHOT_BACKEND_NAME_SIZE_IN_BYTES 16
+#define INDEX_SNAPSHOT_ENTRY_SIZE_IN_BYTES 12
+#define INDEX_SNAPSHOT_BLOCK_SIZE 4096
+// The journal starts with the identifier of the snapshot it follows, then holds the slot of each record appended or
+// deleted since that snapshot.
+#define JOURNAL_HEADER_SIZE_IN_BYTES 8
+#define JOURNAL_ENTRY_SIZE_IN_BYTES 4
 
 /**
  * @brief Data structure that represents a directory database.
@@ -21,7 +53,31 @@
  */
 typedef struct Directory {
     char database_filename[FILENAME_MAXLEN];
-    BPTreeNode *index;
+    DirectoryIndex *index;
+    BloomFilter *filter;
+    int filter_stale_count;
+    StaticIndex *frozen_index;
+    // The decoded records recently searched, NULL = disabled. Only the directory itself has one, not its shards.
+    RecordCache *cache;
+    // Performs the reads of the batch searches of all the shards. Only the directory itself has one, not its shards.
+    AsyncReader *reader;
+    // Taken for reading by the searches and for writing by the modifications.
+    pthread_rwlock_t lock;
+    struct Directory **shards;
+    int shard_count;
+    int shard_bits;
+    // One bit per slot of the database file, 1 = the record of the slot is deleted. Saved in "<database>.tombstones".
+    Bitmap *tombstones;
+    int slot_count;
+    // There is no free slot, that is a deleted record, before this slot.
+    int free_slot_cursor;
+    // The journal of the last snapshot of the index, saved in "<database>.journal", -1 = there is no snapshot.
+    int journal_fd;
+    uint64_t snapshot_id;
+    // The journal of the snapshot being saved, written along with the other one until the snapshot is complete.
+    int next_journal_fd;
+    // The process that saves the snapshot, -1 = none. Only the directory itself has one, not its shards.
+    pid_t snapshot_pid;
 } Directory;
 
 /**
@@ -32,6 +88,28 @@ typedef struct Directory {
  */
 Directory *Directory_init(char database_filename[FILENAME_MAXLEN]);
 
+/**
+ * @brief Initializes a directory whose records are partitioned into independent shards according to the hash of their
+ * phone number. Each shard has its own database file, named after the database file followed by the number of the shard,
+ * its own index and its own lock. The operations of the directory are routed to the right shard.
+ *
+ * @param database_filename The name of the database file.
+ * @param shard_count The number of shards, rounded up to a power of 2.
+ * @return Directory* The initialized directory.
+ */
+Directory *Directory_init_sharded(char database_filename[FILENAME_MAXLEN], int shard_count);
+
+/**
+ * @brief Initializes a directory whose index is of the given kind, Directory_init and Directory_init_sharded use the
+ * B+ Tree.
+ *
+ * @param database_filename The name of the database file.
+ * @param shard_count The number of shards, 0 = the directory is not sharded.
+ * @param backend The kind of index of the directory and of its shards.
+ * @return Directory* The initialized directory.
+ */
+Directory *Directory_init_with_index(char database_filename[FILENAME_MAXLEN], int shard_count, const DirectoryIndexBackend *backend);
+
 /**
  * @brief Destroys the directory and free its memory.
  *
@@ -39,6 +117,89 @@ Directory *Directory_init(char database_filename[FILENAME_MAXLEN]);
  */
 void Directory_destroy(Directory **directory);
 
+/**
+ * @brief Enables the cache of decoded records in front of the directory, a search of a cached record then reads
+ * neither the index nor the database file. The records updated or deleted are removed from the cache. It must be
+ * enabled before the directory is shared between threads.
+ *
+ * @param directory The directory.
+ * @param capacity The maximum number of records in the cache.
+ */
+void Directory_enable_cache(Directory *directory, int capacity);
+
+/**
+ * @brief Gets the number of searches answered by the cache and of those that were not.
+ *
+ * @param directory The directory.
+ * @param hit_count The number of hits will be assigned to this variable.
+ * @param miss_count The number of misses will be assigned to this variable.
+ */
+void Directory_get_cache_counters(Directory *directory, uint64_t *hit_count, uint64_t *miss_count);
+
+/**
+ * @brief Enables the Bloom filter in front of the index, lookups of missing phone numbers then usually don't traverse the index.
+ *
+ * @param directory The directory.
+ */
+void Directory_enable_filter(Directory *directory);
+
+/**
+ * @brief Freezes the index into a read-only layout that is faster to search. The frozen index is dropped by the next
+ * append or deletion, and the directory goes back to its index. Only an ordered index is frozen, a hash table is
+ * already searched in constant time.
+ *
+ * @param directory The directory.
+ */
+void Directory_freeze(Directory *directory);
+
+/**
+ * @brief Starts saving a snapshot of the index in the background, the directory can still be used in the meantime.
+ * The process is forked and the child writes the keys of the index of each shard into "<database>.index", while the
+ * memory it reads is shared with the parent until the parent modifies it. From then on, the slots of the records
+ * appended or deleted are written to the journal of the snapshot. The next time the directory is opened, the index
+ * is loaded from the snapshot and the records of the journal are read again, instead of reading the whole database.
+ *
+ * @param directory The directory.
+ * @return true The snapshot is being saved.
+ * @return false A snapshot is already being saved, or the process could not be forked.
+ */
+bool Directory_save_index(Directory *directory);
+
+/**
+ * @brief Finds out whether a snapshot of the index is still being saved, without waiting. A snapshot that has been
+ * saved replaces the previous one.
+ *
+ * @param directory The directory.
+ * @return true The snapshot is still being saved.
+ * @return false No snapshot is being saved.
+ */
+bool Directory_is_saving_index(Directory *directory);
+
+/**
+ * @brief Waits until the snapshot of the index being saved is complete.
+ *
+ * @param directory The directory.
+ * @return true The snapshot has been saved.
+ * @return false No snapshot was being saved, or it could not be saved.
+ */
+bool Directory_wait_index_save(Directory *directory);
+
+/**
+ * @brief Copies the records of the directory into a column store, the previous content of the store is removed.
+ *
+ * @param directory The directory.
+ * @param store The column store.
+ */
+void Directory_export_columns(Directory *directory, ColumnStore *store);
+
+/**
+ * @brief Counts the records of the directory that are not deleted.
+ *
+ * @param directory The directory.
+ * @return int The number of records.
+ */
+int Directory_count(Directory *directory);
+
 /**
  * @brief Displays the directory on the console.
  *
@@ -65,6 +226,76 @@ bool Directory_append(Directory *directory, DirectoryRecord *record);
  */
 DirectoryRecord *Directory_search(Directory *directory, char phone_number[PHONE_NUMBER_MAXLEN]);
 
+/**
+ * @brief Updates a record of the directory, the record is identified by its phone number.
+ *
+ * @param directory The directory in which the record must be updated.
+ * @param record The new content of the record.
+ * @return true The record could be updated.
+ * @return false The record could not be updated.
+ */
+bool Directory_update(Directory *directory, DirectoryRecord *record);
+
+/**
+ * @brief Function called for each result of a batch search.
+ *
+ * @param index The index of the phone number in the batch.
+ * @param record The corresponding record, NULL if not found. The callback becomes the owner of the record.
+ * @param context The context given to Directory_search_batch.
+ */
+typedef void (*DirectorySearchCallback)(int index, DirectoryRecord *record, void *context);
+
+/**
+ * @brief Function that tells whether a record is selected by a scan.
+ *
+ * @param bytes The record as written on disk, the position of each field is given in DirectoryRecord.h.
+ * @param context The context given to Directory_scan.
+ * @return true The record is selected.
+ * @return false The record is not selected.
+ */
+typedef bool (*DirectoryScanPredicate)(const uint8_t *bytes, void *context);
+
+/**
+ * @brief Searches for many records at once. The records are read from the database file concurrently,
+ * so the results are delivered in the order in which the reads complete and not in the order of the batch. The
+ * callback is called without any lock held, it may modify the directory.
+ *
+ * @param directory The directory in which to search.
+ * @param phone_numbers The telephone numbers of the records.
+ * @param count The number of telephone numbers.
+ * @param callback The function called for each result.
+ * @param context Passed as is to the callback.
+ */
+void Directory_search_batch(Directory *directory, char phone_numbers[][PHONE_NUMBER_MAXLEN], int count, DirectorySearchCallback callback, void *context);
+
+/**
+ * @brief Searches for the records whose phone number starts with a prefix, the index must keep the order of the phone
+ * numbers (the radix tree). The records of a shard are delivered in the order of their phone numbers, one shard after
+ * the other.
+ *
+ * @param directory The directory in which to search.
+ * @param prefix The first digits of the phone numbers.
+ * @param callback The function called for each record found, the index passed to it is the rank of the record.
+ * @param context Passed as is to the callback.
+ * @return int The number of records found, -1 if the index does not keep the order of the phone numbers.
+ */
+int Directory_search_prefix(Directory *directory, char prefix[PHONE_NUMBER_MAXLEN], DirectorySearchCallback callback, void *context);
+
+/**
+ * @brief Reads all the records of the directory with several threads and selects some of them. The database files are
+ * split into blocks of records that the threads take in turn, the records are tested without being decoded and only
+ * those selected are decoded. The records appended during the scan may be left out.
+ *
+ * @param directory The directory.
+ * @param predicate The function that selects the records, it is called by several threads at once.
+ * @param callback The function called for each record selected, by one thread at a time and in no particular order.
+ * The index passed to it is the rank of the record.
+ * @param context Passed as is to the predicate and to the callback.
+ * @param thread_count The number of threads, the calling thread is one of them.
+ * @return int The number of records selected.
+ */
+int Directory_scan(Directory *directory, DirectoryScanPredicate predicate, DirectorySearchCallback callback, void *context, int thread_count);
+
 /**
  * @brief Deletes a record from the directory.
  *
@@ -0,0 +1,341 @@
+/**
+ * @file DirectoryIndex.c
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#include "DirectoryIndex.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "BPTree.h"
+#include "DirectoryRecord.h"
+#include "HashIndex.h"
+#include "RadixTree.h"
+
+// A digit of a phone number takes 4 bits of the key of the radix tree.
+#define PHONE_DIGIT_SIZE_IN_BITS 4
+
+// BEGIN : B+ Tree
+
+// The functions of the backend forward the calls to the B+ Tree.
+
+static void *bptree_init(void) {
+    return BPTree_init(DEFAULT_ORDER);
+}
+
+static void bptree_destroy(void *index) {
+    BPTreeNode *root = (BPTreeNode *)index;
+    BPTree_destroy(&root);
+}
+
+static bool bptree_search(void *index, uint64_t key, uint64_t *data_ptr) {
+    return BPTree_search((BPTreeNode *)index, key, data_ptr);
+}
+
+static bool bptree_insert(void *index, uint64_t key, uint64_t data_ptr) {
+    return BPTree_insert((BPTreeNode *)index, key, data_ptr);
+}
+
+static int bptree_insert_batch(void *index, uint64_t *keys, uint64_t *data_ptrs, int count) {
+    return BPTree_insert_batch((BPTreeNode *)index, keys, data_ptrs, count);
+}
+
+static void bptree_load(void *index, uint64_t *keys, uint64_t *data_ptrs, int count) {
+    BPTree_bulk_load((BPTreeNode *)index, keys, data_ptrs, count);
+}
+
+static bool bptree_delete(void *index, uint64_t key) {
+    return BPTree_delete((BPTreeNode *)index, key);
+}
+
+static int bptree_count(void *index) {
+    int count = 0;
+    for (BPTreeNode *leaf = BPTree_find_first_leaf((BPTreeNode *)index); leaf != NULL; leaf = leaf->next) {
+        count += leaf->keys->size;
+    }
+    return count;
+}
+
+static void bptree_for_each(void *index, DirectoryIndexVisitor visitor, void *context) {
+    // The leaf nodes are chained in ascending order.
+    for (BPTreeNode *leaf = BPTree_find_first_leaf((BPTreeNode *)index); leaf != NULL; leaf = leaf->next) {
+        for (int i = 0; i < leaf->keys->size; i++) {
+            visitor(leaf->keys->items[i], leaf->data->items[i], context);
+        }
+    }
+}
+
+const DirectoryIndexBackend DIRECTORY_INDEX_BPTREE = {
+    "bptree",
+    true,
+    bptree_init,
+    bptree_destroy,
+    bptree_search,
+    bptree_insert,
+    bptree_insert_batch,
+    bptree_load,
+    bptree_delete,
+    bptree_count,
+    bptree_for_each,
+    NULL,
+    NULL,
+};
+
+// The same B+ Tree, with its nodes in an arena of huge pages.
+
+static void *bptree_huge_pages_init(void) {
+    return BPTree_init_in_arena(DEFAULT_ORDER, NODE_ARENA_EXPLICIT_HUGE_PAGES);
+}
+
+const DirectoryIndexBackend DIRECTORY_INDEX_BPTREE_HUGE_PAGES = {
+    "bptree-huge",
+    true,
+    bptree_huge_pages_init,
+    bptree_destroy,
+    bptree_search,
+    bptree_insert,
+    bptree_insert_batch,
+    bptree_load,
+    bptree_delete,
+    bptree_count,
+    bptree_for_each,
+    NULL,
+    NULL,
+};
+
+// END : B+ Tree
+
+// BEGIN : Hash table
+
+// The functions of the backend forward the calls to the hash table.
+
+static void *hash_init(void) {
+    return HashIndex_init(0);
+}
+
+static void hash_destroy(void *index) {
+    HashIndex *table = (HashIndex *)index;
+    HashIndex_destroy(&table);
+}
+
+static bool hash_search(void *index, uint64_t key, uint64_t *data_ptr) {
+    return HashIndex_search((HashIndex *)index, key, data_ptr);
+}
+
+static bool hash_insert(void *index, uint64_t key, uint64_t data_ptr) {
+    return HashIndex_insert((HashIndex *)index, key, data_ptr);
+}
+
+static int hash_insert_batch(void *index, uint64_t *keys, uint64_t *data_ptrs, int count) {
+    HashIndex *table = (HashIndex *)index;
+    // There is no order to take advantage of, the table only grows once.
+    HashIndex_reserve(table, table->size + count);
+
+    int inserted_count = 0;
+    for (int i = 0; i < count; i++) {
+        inserted_count += HashIndex_insert(table, keys[i], data_ptrs[i]);
+    }
+    return inserted_count;
+}
+
+static void hash_load(void *index, uint64_t *keys, uint64_t *data_ptrs, int count) {
+    hash_insert_batch(index, keys, data_ptrs, count);
+}
+
+static bool hash_delete(void *index, uint64_t key) {
+    return HashIndex_delete((HashIndex *)index, key);
+}
+
+static int hash_count(void *index) {
+    return ((HashIndex *)index)->size;
+}
+
+static void hash_for_each(void *index, DirectoryIndexVisitor visitor, void *context) {
+    HashIndex *table = (HashIndex *)index;
+
+    for (int i = 0; i < table->slot_count; i++) {
+        if (table->controls[i] >= 0) {
+            visitor(table->entries[i].key, table->entries[i].data, context);
+        }
+    }
+}
+
+const DirectoryIndexBackend DIRECTORY_INDEX_HASH = {
+    "hash",
+    false,
+    hash_init,
+    hash_destroy,
+    hash_search,
+    hash_insert,
+    hash_insert_batch,
+    hash_load,
+    hash_delete,
+    hash_count,
+    hash_for_each,
+    NULL,
+    NULL,
+};
+
+// END : Hash table
+
+// BEGIN : Radix tree
+
+// The functions of the backend forward the calls to the radix tree.
+
+static void *radix_init(void) {
+    return RadixTree_init();
+}
+
+static void radix_destroy(void *index) {
+    RadixTree *tree = (RadixTree *)index;
+    RadixTree_destroy(&tree);
+}
+
+static bool radix_search(void *index, uint64_t key, uint64_t *data_ptr) {
+    return RadixTree_search((RadixTree *)index, key, data_ptr);
+}
+
+static bool radix_insert(void *index, uint64_t key, uint64_t data_ptr) {
+    return RadixTree_insert((RadixTree *)index, key, data_ptr);
+}
+
+static int radix_insert_batch(void *index, uint64_t *keys, uint64_t *data_ptrs, int count) {
+    int inserted_count = 0;
+    for (int i = 0; i < count; i++) {
+        inserted_count += RadixTree_insert((RadixTree *)index, keys[i], data_ptrs[i]);
+    }
+    return inserted_count;
+}
+
+static void radix_load(void *index, uint64_t *keys, uint64_t *data_ptrs, int count) {
+    // In ascending order, each key ends up in the last nodes visited, which are still in the cache.
+    radix_insert_batch(index, keys, data_ptrs, count);
+}
+
+static bool radix_delete(void *index, uint64_t key) {
+    return RadixTree_delete((RadixTree *)index, key);
+}
+
+static int radix_count(void *index) {
+    return ((RadixTree *)index)->size;
+}
+
+static void radix_for_each(void *index, DirectoryIndexVisitor visitor, void *context) {
+    RadixTree_for_each_range((RadixTree *)index, 0, UINT64_MAX, visitor, context);
+}
+
+/**
+ * @brief Encodes a phone number into a key that keeps the order of the phone numbers. The digits are placed from the
+ * most significant bits of the key, 4 bits each: 1 to 10 for the digits 0 to 9, and 0 after the last digit, so that a
+ * phone number comes before the longer ones that start with it.
+ *
+ * @param phone_number The phone number.
+ * @param key The key will be assigned to this variable.
+ * @return true The phone number has been encoded.
+ * @return false The phone number has a character that is not a digit.
+ */
+static bool radix_encode_key(const char *phone_number, uint64_t *key) {
+    *key = 0;
+
+    for (int i = 0; i < PHONE_NUMBER_MAXLEN_WITHOUT_NULL_CHARACTER && phone_number[i] != '\0'; i++) {
+        if (phone_number[i] < '0' || phone_number[i] > '9') {
+            return false;
+        }
+
+        *key |= (uint64_t)(phone_number[i] - '0' + 1) << (64 - PHONE_DIGIT_SIZE_IN_BITS * (i + 1));
+    }
+
+    return true;
+}
+
+static bool radix_for_each_prefix(void *index, const char *prefix, DirectoryIndexVisitor visitor, void *context) {
+    uint64_t from;
+    if (!radix_encode_key(prefix, &from)) {
+        return false;
+    }
+
+    // The digits that follow the prefix can be anything, they are the bits after those of the prefix.
+    int length = strnlen(prefix, PHONE_NUMBER_MAXLEN_WITHOUT_NULL_CHARACTER);
+    uint64_t to = from | (UINT64_MAX >> (PHONE_DIGIT_SIZE_IN_BITS * length));
+    RadixTree_for_each_range((RadixTree *)index, from, to, visitor, context);
+    return true;
+}
+
+const DirectoryIndexBackend DIRECTORY_INDEX_RADIX = {
+    "radix",
+    true,
+    radix_init,
+    radix_destroy,
+    radix_search,
+    radix_insert,
+    radix_insert_batch,
+    radix_load,
+    radix_delete,
+    radix_count,
+    radix_for_each,
+    radix_encode_key,
+    radix_for_each_prefix,
+};
+
+// END : Radix tree
+
+const DirectoryIndexBackend *DirectoryIndexBackend_find(const char *name) {
+    const DirectoryIndexBackend *backends[] = {&DIRECTORY_INDEX_BPTREE, &DIRECTORY_INDEX_BPTREE_HUGE_PAGES, &DIRECTORY_INDEX_HASH, &DIRECTORY_INDEX_RADIX};
+
+    for (int i = 0; i < (int)(sizeof(backends) / sizeof(backends[0])); i++) {
+        if (strcmp(backends[i]->name, name) == 0) {
+            return backends[i];
+        }
+    }
+
+    return NULL;
+}
+
+DirectoryIndex *DirectoryIndex_init(const DirectoryIndexBackend *backend) {
+    DirectoryIndex *index = (DirectoryIndex *)malloc(sizeof(DirectoryIndex));
+    index->backend = backend;
+    index->impl = backend->init();
+    return index;
+}
+
+void DirectoryIndex_destroy(DirectoryIndex **index) {
+    (*index)->backend->destroy((*index)->impl);
+    free(*index);
+    *index = NULL;
+}
+
+bool DirectoryIndex_search(DirectoryIndex *index, uint64_t key, uint64_t *data_ptr) {
+    return index->backend->search(index->impl, key, data_ptr);
+}
+
+bool DirectoryIndex_insert(DirectoryIndex *index, uint64_t key, uint64_t data_ptr) {
+    return index->backend->insert(index->impl, key, data_ptr);
+}
+
+int DirectoryIndex_insert_batch(DirectoryIndex *index, uint64_t *keys, uint64_t *data_ptrs, int count) {
+    return index->backend->insert_batch(index->impl, keys, data_ptrs, count);
+}
+
+void DirectoryIndex_load(DirectoryIndex *index, uint64_t *keys, uint64_t *data_ptrs, int count) {
+    index->backend->load(index->impl, keys, data_ptrs, count);
+}
+
+bool DirectoryIndex_delete(DirectoryIndex *index, uint64_t key) {
+    return index->backend->delete(index->impl, key);
+}
+
+int DirectoryIndex_count(DirectoryIndex *index) {
+    return index->backend->count(index->impl);
+}
+
+void DirectoryIndex_for_each(DirectoryIndex *index, DirectoryIndexVisitor visitor, void *context) {
+    index->backend->for_each(index->impl, visitor, context);
+}
+
+bool DirectoryIndex_for_each_prefix(DirectoryIndex *index, const char *prefix, DirectoryIndexVisitor visitor, void *context) {
+    return index->backend->for_each_prefix(index->impl, prefix, visitor, context);
+}
@@ -0,0 +1,179 @@
+/**
+ * @file DirectoryIndex.h
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#ifndef DIRECTORY_INDEX_H
+#define DIRECTORY_INDEX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define DEFAULT_ORDER 2
+
+/**
+ * @brief Function called for each key of an index.
+ *
+ * @param key The key of the phone number.
+ * @param data_ptr The position of the record in the database file.
+ * @param context The context given to the iteration.
+ */
+typedef void (*DirectoryIndexVisitor)(uint64_t key, uint64_t data_ptr, void *context);
+
+/**
+ * @brief Data structure that represents the operations of a kind of index, the directory only uses its index through
+ * them.
+ *
+ */
+typedef struct DirectoryIndexBackend {
+    const char *name;
+    // true = the keys are visited in ascending order, the index can then be frozen.
+    bool is_ordered;
+    void *(*init)(void);
+    void (*destroy)(void *index);
+    bool (*search)(void *index, uint64_t key, uint64_t *data_ptr);
+    bool (*insert)(void *index, uint64_t key, uint64_t data_ptr);
+    int (*insert_batch)(void *index, uint64_t *keys, uint64_t *data_ptrs, int count);
+    // Fills an empty index with keys given in the order in which for_each visits them.
+    void (*load)(void *index, uint64_t *keys, uint64_t *data_ptrs, int count);
+    bool (*delete)(void *index, uint64_t key);
+    int (*count)(void *index);
+    void (*for_each)(void *index, DirectoryIndexVisitor visitor, void *context);
+    // Makes the key of a phone number, NULL = the key is the hash of the phone number. It returns false if the
+    // phone number cannot be encoded.
+    bool (*encode_key)(const char *phone_number, uint64_t *key);
+    // Visits the keys of the phone numbers that start with a prefix in ascending order, NULL = not supported. It
+    // returns false if the prefix cannot be encoded.
+    bool (*for_each_prefix)(void *index, const char *prefix, DirectoryIndexVisitor visitor, void *context);
+} DirectoryIndexBackend;
+
+// The B+ Tree, the keys are ordered.
+extern const DirectoryIndexBackend DIRECTORY_INDEX_BPTREE;
+// The B+ Tree with its nodes in huge pages, explicit ones if the administrator has reserved some, otherwise
+// transparent ones.
+extern const DirectoryIndexBackend DIRECTORY_INDEX_BPTREE_HUGE_PAGES;
+// The hash table, for the directories that are only searched by phone number.
+extern const DirectoryIndexBackend DIRECTORY_INDEX_HASH;
+// The radix tree, keyed by the digits of the phone numbers rather than by their hash, the keys are in the order of
+// the phone numbers.
+extern const DirectoryIndexBackend DIRECTORY_INDEX_RADIX;
+
+/**
+ * @brief Data structure that represents the index of a directory, it maps the key of a phone number to the position
+ * of its record in the database file.
+ *
+ */
+typedef struct DirectoryIndex {
+    const DirectoryIndexBackend *backend;
+    void *impl;
+} DirectoryIndex;
+
+/**
+ * @brief Finds a backend by its name.
+ *
+ * @param name "bptree", "hash" or "radix".
+ * @return const DirectoryIndexBackend* The backend, NULL if there is none with this name.
+ */
+const DirectoryIndexBackend *DirectoryIndexBackend_find(const char *name);
+
+/**
+ * @brief Initializes an empty index.
+ *
+ * @param backend The kind of index.
+ * @return DirectoryIndex* The empty index.
+ */
+DirectoryIndex *DirectoryIndex_init(const DirectoryIndexBackend *backend);
+
+/**
+ * @brief Destroys the index and free its memory.
+ *
+ * @param index The index to be destroyed.
+ */
+void DirectoryIndex_destroy(DirectoryIndex **index);
+
+/**
+ * @brief Searches for a key in the index.
+ *
+ * @param index The index in which to search.
+ * @param key The key to search.
+ * @param data_ptr The position of the record will be assigned to this variable.
+ * @return true The key exists in the index.
+ * @return false The key does not exist in the index.
+ */
+bool DirectoryIndex_search(DirectoryIndex *index, uint64_t key, uint64_t *data_ptr);
+
+/**
+ * @brief Inserts a key in the index.
+ *
+ * @param index The index in which the key is inserted.
+ * @param key The key to be inserted.
+ * @param data_ptr The position of the record.
+ * @return true The key has been inserted.
+ * @return false The key already exists, the index is not modified.
+ */
+bool DirectoryIndex_insert(DirectoryIndex *index, uint64_t key, uint64_t data_ptr);
+
+/**
+ * @brief Inserts many keys at once, for example when the index is rebuilt. The arrays are not modified.
+ *
+ * @param index The index in which the keys are inserted.
+ * @param keys The keys to be inserted.
+ * @param data_ptrs The positions of the records, in the order of the keys.
+ * @param count The number of keys.
+ * @return int The number of keys inserted, a key that already exists is skipped.
+ */
+int DirectoryIndex_insert_batch(DirectoryIndex *index, uint64_t *keys, uint64_t *data_ptrs, int count);
+
+/**
+ * @brief Fills an empty index with the keys of another index of the same kind, in the order in which they were
+ * visited. The B+ Tree is then built from its leaves instead of by insertions.
+ *
+ * @param index The empty index.
+ * @param keys The keys, without duplicates.
+ * @param data_ptrs The positions of the records, in the order of the keys.
+ * @param count The number of keys.
+ */
+void DirectoryIndex_load(DirectoryIndex *index, uint64_t *keys, uint64_t *data_ptrs, int count);
+
+/**
+ * @brief Deletes a key from the index.
+ *
+ * @param index The index in which the key is deleted.
+ * @param key The key to be deleted.
+ * @return true The key has been deleted.
+ * @return false The key does not exist.
+ */
+bool DirectoryIndex_delete(DirectoryIndex *index, uint64_t key);
+
+/**
+ * @brief Counts the keys of the index.
+ *
+ * @param index The index.
+ * @return int The number of keys.
+ */
+int DirectoryIndex_count(DirectoryIndex *index);
+
+/**
+ * @brief Calls a function for each key of the index, in ascending order if the backend is ordered.
+ *
+ * @param index The index.
+ * @param visitor The function called for each key.
+ * @param context Passed as is to the visitor.
+ */
+void DirectoryIndex_for_each(DirectoryIndex *index, DirectoryIndexVisitor visitor, void *context);
+
+/**
+ * @brief Calls a function for each phone number of the index that starts with a prefix, in the order of the phone
+ * numbers. The backend must support it.
+ *
+ * @param index The index.
+ * @param prefix The prefix.
+ * @param visitor The function called for each key.
+ * @param context Passed as is to the visitor.
+ * @return true The keys have been visited.
+ * @return false The prefix cannot be encoded, no phone number of the index starts with it.
+ */
+bool DirectoryIndex_for_each_prefix(DirectoryIndex *index, const char *prefix, DirectoryIndexVisitor visitor, void *context);
+
+#endif
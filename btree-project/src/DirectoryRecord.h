@@ -24,6 +24,13 @@
 
 #define BIRTH_DATE_SIZE_IN_BYTES 4
 
+// The position of each field in a record written on disk. The strings are padded with zeros, the year of birth takes
+// 2 bytes in big endian, followed by the month and the day.
+#define PHONE_NUMBER_OFFSET IS_DELETED_SIZE_IN_BYTES
+#define NAME_OFFSET (PHONE_NUMBER_OFFSET + PHONE_NUMBER_MAXLEN_WITHOUT_NULL_CHARACTER)
+#define SURNAME_OFFSET (NAME_OFFSET + NAME_MAXLEN_WITHOUT_NULL_CHARACTER)
+#define BIRTH_DATE_OFFSET (SURNAME_OFFSET + SURNAME_MAXLEN_WITHOUT_NULL_CHARACTER)
+
 /**
  * @brief Data structure that represents a record.
  *
@@ -0,0 +1,292 @@
+/**
+ * @file DirectoryStats.c
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#include "DirectoryStats.h"
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SUB_BUCKET_COUNT (1 << LATENCY_HISTOGRAM_SUB_BUCKET_BITS)
+
+static const char *OPERATION_NAMES[DIRECTORY_OPERATION_COUNT] = {"append", "search", "update", "delete", "rebuild"};
+static const char *PHASE_NAMES[DIRECTORY_PHASE_COUNT] = {"hash", "index", "I/O", "decode", "other"};
+
+// The latencies of each thread are chained together, they are never freed so that the latencies of the finished threads remain.
+static DirectoryLatencies *registered_latencies = NULL;
+static pthread_mutex_t registered_latencies_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Gets the largest duration that falls in a bucket.
+ *
+ * @param index The index of the bucket.
+ * @return uint64_t The duration in nanoseconds.
+ */
+static uint64_t get_bucket_highest_value(int index) {
+    int shift = (index >> LATENCY_HISTOGRAM_SUB_BUCKET_BITS) - 1;
+
+    if (shift < 0) {
+        return (uint64_t)index;
+    }
+
+    uint64_t significant_bits = (uint64_t)(index & (SUB_BUCKET_COUNT - 1)) + SUB_BUCKET_COUNT;
+    return ((significant_bits + 1) << shift) - 1;
+}
+
+uint64_t LatencyHistogram_value_at_percentile(LatencyHistogram *histogram, double percentile) {
+    if (histogram->count == 0) {
+        return 0;
+    }
+
+    // The rank of the duration among the sorted durations, the first one has the rank 1.
+    uint64_t rank = (uint64_t)(percentile / 100 * histogram->count + 0.5);
+    rank = rank < 1 ? 1 : rank;
+    uint64_t seen_count = 0;
+
+    for (int i = 0; i < LATENCY_HISTOGRAM_BUCKET_COUNT; i++) {
+        seen_count += histogram->buckets[i];
+
+        if (seen_count >= rank) {
+            uint64_t value = get_bucket_highest_value(i);
+            return value < histogram->max_ns ? value : histogram->max_ns;
+        }
+    }
+
+    return histogram->max_ns;
+}
+
+#ifdef DIRECTORY_STATS
+
+/**
+ * @brief Data structure that represents the operation measured on a thread.
+ *
+ */
+typedef struct DirectoryTimer {
+    // -1 = no operation is measured.
+    int operation;
+    DirectoryPhase phase;
+    uint64_t start_ns;
+    uint64_t phase_start_ns;
+    uint64_t phase_ns[DIRECTORY_PHASE_COUNT];
+    // One bit per phase the operation went through.
+    int visited_phases;
+} DirectoryTimer;
+
+static _Thread_local DirectoryTimer local_timer = {-1, DIRECTORY_PHASE_OTHER, 0, 0, {0}, 0};
+static _Thread_local DirectoryLatencies *local_latencies = NULL;
+
+/**
+ * @brief Finds out in which bucket of a histogram a duration falls.
+ *
+ * @param value The duration in nanoseconds.
+ * @return int The index of the bucket.
+ */
+static int get_bucket_index(uint64_t value) {
+    if (value < SUB_BUCKET_COUNT) {
+        return (int)value;
+    }
+
+    int exponent = 63 - __builtin_clzll(value);
+    if (exponent >= LATENCY_HISTOGRAM_MAX_EXPONENT) {
+        return LATENCY_HISTOGRAM_BUCKET_COUNT - 1;
+    }
+
+    // The value is shifted so that its most significant bit and the LATENCY_HISTOGRAM_SUB_BUCKET_BITS bits that
+    // follow are kept, the shift tells the power of 2 and the bits kept the bucket within it.
+    int shift = exponent - LATENCY_HISTOGRAM_SUB_BUCKET_BITS;
+    return (shift << LATENCY_HISTOGRAM_SUB_BUCKET_BITS) + (int)(value >> shift);
+}
+
+/**
+ * @brief Gets the current time of the monotonic clock.
+ *
+ * @return uint64_t The time in nanoseconds.
+ */
+static uint64_t get_time_ns() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000 + (uint64_t)time.tv_nsec;
+}
+
+/**
+ * @brief Allocates the latencies of the calling thread and registers them for the aggregation.
+ *
+ * @return DirectoryLatencies* The latencies of the calling thread.
+ */
+static DirectoryLatencies *register_latencies() {
+    DirectoryLatencies *latencies = (DirectoryLatencies *)calloc(1, sizeof(DirectoryLatencies));
+
+    pthread_mutex_lock(&registered_latencies_mutex);
+    latencies->next = registered_latencies;
+    registered_latencies = latencies;
+    pthread_mutex_unlock(&registered_latencies_mutex);
+
+    local_latencies = latencies;
+    return latencies;
+}
+
+/**
+ * @brief Records a duration in a histogram of the calling thread.
+ *
+ * @param histogram The histogram.
+ * @param value The duration in nanoseconds.
+ */
+static void record_value(LatencyHistogram *histogram, uint64_t value) {
+    // Only the owner thread writes its histograms, the stores are atomic so that the aggregation can read them at any time.
+    int index = get_bucket_index(value);
+    __atomic_store_n(&histogram->buckets[index], histogram->buckets[index] + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&histogram->count, histogram->count + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&histogram->total_ns, histogram->total_ns + value, __ATOMIC_RELAXED);
+
+    if (value > histogram->max_ns) {
+        __atomic_store_n(&histogram->max_ns, value, __ATOMIC_RELAXED);
+    }
+}
+
+void DirectoryLatencies_begin(DirectoryOperation operation) {
+    if (local_timer.operation != -1) {
+        return;
+    }
+
+    local_timer.operation = operation;
+    local_timer.phase = DIRECTORY_PHASE_OTHER;
+    local_timer.start_ns = get_time_ns();
+    local_timer.phase_start_ns = local_timer.start_ns;
+    memset(local_timer.phase_ns, 0, sizeof(local_timer.phase_ns));
+    local_timer.visited_phases = 1 << DIRECTORY_PHASE_OTHER;
+}
+
+void DirectoryLatencies_switch_phase(DirectoryPhase phase) {
+    if (local_timer.operation == -1 || local_timer.phase == phase) {
+        return;
+    }
+
+    uint64_t now = get_time_ns();
+    local_timer.phase_ns[local_timer.phase] += now - local_timer.phase_start_ns;
+    local_timer.phase = phase;
+    local_timer.phase_start_ns = now;
+    local_timer.visited_phases |= 1 << phase;
+}
+
+void DirectoryLatencies_end() {
+    if (local_timer.operation == -1) {
+        return;
+    }
+
+    uint64_t now = get_time_ns();
+    local_timer.phase_ns[local_timer.phase] += now - local_timer.phase_start_ns;
+
+    DirectoryLatencies *latencies = local_latencies;
+    if (latencies == NULL) {
+        latencies = register_latencies();
+    }
+
+    record_value(&latencies->operations[local_timer.operation], now - local_timer.start_ns);
+
+    for (int i = 0; i < DIRECTORY_PHASE_COUNT; i++) {
+        if (local_timer.visited_phases & (1 << i)) {
+            record_value(&latencies->phases[local_timer.operation][i], local_timer.phase_ns[i]);
+        }
+    }
+
+    local_timer.operation = -1;
+}
+
+#endif
+
+/**
+ * @brief Adds a histogram of one thread to the sum.
+ *
+ * @param src The histogram of the thread.
+ * @param dest The sum.
+ */
+static void accumulate_histogram(LatencyHistogram *src, LatencyHistogram *dest) {
+    dest->count += __atomic_load_n(&src->count, __ATOMIC_RELAXED);
+    dest->total_ns += __atomic_load_n(&src->total_ns, __ATOMIC_RELAXED);
+
+    uint64_t max_ns = __atomic_load_n(&src->max_ns, __ATOMIC_RELAXED);
+    if (max_ns > dest->max_ns) {
+        dest->max_ns = max_ns;
+    }
+
+    for (int i = 0; i < LATENCY_HISTOGRAM_BUCKET_COUNT; i++) {
+        dest->buckets[i] += __atomic_load_n(&src->buckets[i], __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief Adds the latencies of one thread to the sum.
+ *
+ * @param src The latencies of the thread.
+ * @param dest The sum.
+ */
+static void accumulate_latencies(DirectoryLatencies *src, DirectoryLatencies *dest) {
+    for (int i = 0; i < DIRECTORY_OPERATION_COUNT; i++) {
+        accumulate_histogram(&src->operations[i], &dest->operations[i]);
+
+        for (int j = 0; j < DIRECTORY_PHASE_COUNT; j++) {
+            accumulate_histogram(&src->phases[i][j], &dest->phases[i][j]);
+        }
+    }
+}
+
+void Directory_collect_latencies(DirectoryLatencies *latencies) {
+    memset(latencies, 0, sizeof(DirectoryLatencies));
+
+    pthread_mutex_lock(&registered_latencies_mutex);
+    for (DirectoryLatencies *current = registered_latencies; current != NULL; current = current->next) {
+        accumulate_latencies(current, latencies);
+    }
+    pthread_mutex_unlock(&registered_latencies_mutex);
+}
+
+/**
+ * @brief Displays one line of the latencies.
+ *
+ * @param fp The file in which the line is written.
+ * @param name The name of the operation or of the phase.
+ * @param histogram The histogram.
+ */
+static void print_histogram(FILE *fp, const char *name, LatencyHistogram *histogram) {
+    double percentiles[] = {50, 90, 99, 99.9};
+
+    fprintf(fp, "%-12s %10" PRIu64 " %10.2f", name, histogram->count, (double)histogram->total_ns / histogram->count / 1000);
+    for (int i = 0; i < (int)(sizeof(percentiles) / sizeof(percentiles[0])); i++) {
+        fprintf(fp, " %10.2f", LatencyHistogram_value_at_percentile(histogram, percentiles[i]) / 1000.0);
+    }
+    fprintf(fp, " %10.2f\n", histogram->max_ns / 1000.0);
+}
+
+void Directory_print_latencies(FILE *fp) {
+    // Too large for the stack of a thread.
+    DirectoryLatencies *latencies = (DirectoryLatencies *)malloc(sizeof(DirectoryLatencies));
+    Directory_collect_latencies(latencies);
+
+    fprintf(fp, "Latencies (us)    count       mean        p50        p90        p99      p99.9        max\n");
+
+    for (int i = 0; i < DIRECTORY_OPERATION_COUNT; i++) {
+        if (latencies->operations[i].count == 0) {
+            continue;
+        }
+
+        print_histogram(fp, OPERATION_NAMES[i], &latencies->operations[i]);
+
+        for (int j = 0; j < DIRECTORY_PHASE_COUNT; j++) {
+            if (latencies->phases[i][j].count > 0) {
+                char name[16];
+                snprintf(name, sizeof(name), "  %s", PHASE_NAMES[j]);
+                print_histogram(fp, name, &latencies->phases[i][j]);
+            }
+        }
+    }
+
+    fflush(fp);
+    free(latencies);
+}
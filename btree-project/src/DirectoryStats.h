@@ -0,0 +1,134 @@
+/**
+ * @file DirectoryStats.h
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#ifndef DIRECTORY_STATS_H
+#define DIRECTORY_STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// The durations are recorded in nanoseconds. Below 2^LATENCY_HISTOGRAM_SUB_BUCKET_BITS each value has its own bucket,
+// above each power of 2 is split into 2^LATENCY_HISTOGRAM_SUB_BUCKET_BITS buckets, so a duration is known to within
+// about 3%, from a few nanoseconds up to the largest one recorded (about 18 minutes).
+#define LATENCY_HISTOGRAM_SUB_BUCKET_BITS 5
+#define LATENCY_HISTOGRAM_MAX_EXPONENT 40
+#define LATENCY_HISTOGRAM_BUCKET_COUNT ((LATENCY_HISTOGRAM_MAX_EXPONENT - LATENCY_HISTOGRAM_SUB_BUCKET_BITS + 1) << LATENCY_HISTOGRAM_SUB_BUCKET_BITS)
+
+/**
+ * @brief The operations of the directory whose latency is measured.
+ *
+ */
+typedef enum DirectoryOperation {
+    DIRECTORY_OPERATION_APPEND,
+    DIRECTORY_OPERATION_SEARCH,
+    DIRECTORY_OPERATION_UPDATE,
+    DIRECTORY_OPERATION_DELETE,
+    // The index of a directory, or of one of its shards, is rebuilt when it is opened.
+    DIRECTORY_OPERATION_REBUILD,
+    DIRECTORY_OPERATION_COUNT,
+} DirectoryOperation;
+
+/**
+ * @brief The phases of an operation, the duration of an operation is the sum of the time spent in each phase.
+ *
+ */
+typedef enum DirectoryPhase {
+    // The phone number is hashed, or encoded into a key.
+    DIRECTORY_PHASE_HASH,
+    // The Bloom filter and the index are searched or modified.
+    DIRECTORY_PHASE_INDEX,
+    // The database file, the tombstones, the journal and the snapshot are read or written.
+    DIRECTORY_PHASE_IO,
+    // The records are decoded, or encoded, and their checksum is computed.
+    DIRECTORY_PHASE_DECODE,
+    // Everything else: the locks, the cache, the allocations.
+    DIRECTORY_PHASE_OTHER,
+    DIRECTORY_PHASE_COUNT,
+} DirectoryPhase;
+
+/**
+ * @brief Data structure that represents the distribution of durations.
+ *
+ */
+typedef struct LatencyHistogram {
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t buckets[LATENCY_HISTOGRAM_BUCKET_COUNT];
+} LatencyHistogram;
+
+/**
+ * @brief Data structure that represents the latencies of the operations performed on directories.
+ *
+ */
+typedef struct DirectoryLatencies {
+    LatencyHistogram operations[DIRECTORY_OPERATION_COUNT];
+    // The time spent in each phase by each operation, an operation that does not go through a phase is not counted.
+    LatencyHistogram phases[DIRECTORY_OPERATION_COUNT][DIRECTORY_PHASE_COUNT];
+    struct DirectoryLatencies *next;
+} DirectoryLatencies;
+
+#ifdef DIRECTORY_STATS
+
+/**
+ * @brief Starts measuring an operation on the calling thread, in the phase DIRECTORY_PHASE_OTHER. The operations are
+ * not nested, an operation started while another is measured is ignored.
+ *
+ * @param operation The operation.
+ */
+void DirectoryLatencies_begin(DirectoryOperation operation);
+
+/**
+ * @brief Ends the current phase of the operation measured on the calling thread and starts another one. Nothing is
+ * done if no operation is measured.
+ *
+ * @param phase The new phase.
+ */
+void DirectoryLatencies_switch_phase(DirectoryPhase phase);
+
+/**
+ * @brief Ends the operation measured on the calling thread and records its duration and its phases.
+ *
+ */
+void DirectoryLatencies_end();
+
+#define DIRECTORY_TIME_BEGIN(operation) DirectoryLatencies_begin(operation)
+#define DIRECTORY_TIME_PHASE(phase) DirectoryLatencies_switch_phase(phase)
+#define DIRECTORY_TIME_END() DirectoryLatencies_end()
+
+#else
+
+#define DIRECTORY_TIME_BEGIN(operation) ((void)0)
+#define DIRECTORY_TIME_PHASE(phase) ((void)0)
+#define DIRECTORY_TIME_END() ((void)0)
+
+#endif
+
+/**
+ * @brief Finds the duration below which a given share of the recorded durations fall.
+ *
+ * @param histogram The histogram.
+ * @param percentile The share of the durations, from 0 to 100.
+ * @return uint64_t The largest duration of the bucket of the percentile in nanoseconds, 0 if the histogram is empty.
+ */
+uint64_t LatencyHistogram_value_at_percentile(LatencyHistogram *histogram, double percentile);
+
+/**
+ * @brief Sums the latencies of all the threads. Everything is zero when compiled without DIRECTORY_STATS.
+ *
+ * @param latencies The sum of the latencies will be assigned to this variable.
+ */
+void Directory_collect_latencies(DirectoryLatencies *latencies);
+
+/**
+ * @brief Displays the count, the mean, the percentiles and the maximum of the latency of each operation and of each of
+ * its phases. It can be called at any time, even while other threads perform operations.
+ *
+ * @param fp The file in which the latencies are written.
+ */
+void Directory_print_latencies(FILE *fp);
+
+#endif
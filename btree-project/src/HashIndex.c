@@ -0,0 +1,266 @@
+/**
+ * @file HashIndex.c
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#include "HashIndex.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * @brief Mixes the bits of a key (finalizer of MurmurHash3), the low bits of the hash pick the control byte and the
+ * others the group.
+ *
+ * @param key The key.
+ * @return uint64_t The hash of the key.
+ */
+static uint64_t hash_key(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCD;
+    key ^= key >> 33;
+    key *= 0xC4CEB9FE1A85EC53;
+    key ^= key >> 33;
+    return key;
+}
+
+/**
+ * @brief Finds the control bytes of a group that are equal to a byte.
+ *
+ * @param controls The control bytes of the group.
+ * @param byte The byte.
+ * @return uint32_t Bit i is set if the control byte of slot i of the group is equal to the byte.
+ */
+static uint32_t match_byte(int8_t *controls, int8_t byte) {
+#ifdef __SSE2__
+    __m128i group = _mm_load_si128((__m128i *)controls);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(byte)));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < HASH_INDEX_GROUP_SIZE; i++) {
+        mask |= (uint32_t)(controls[i] == byte) << i;
+    }
+    return mask;
+#endif
+}
+
+/**
+ * @brief Finds the slots of a group that are empty or deleted.
+ *
+ * @param controls The control bytes of the group.
+ * @return uint32_t Bit i is set if slot i of the group is free.
+ */
+static uint32_t match_free(int8_t *controls) {
+#ifdef __SSE2__
+    // Both the empty and the deleted control bytes are negative, the mask is made of the sign bits.
+    return _mm_movemask_epi8(_mm_load_si128((__m128i *)controls));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < HASH_INDEX_GROUP_SIZE; i++) {
+        mask |= (uint32_t)(controls[i] < 0) << i;
+    }
+    return mask;
+#endif
+}
+
+/**
+ * @brief Finds the slot of a key.
+ *
+ * @param index The table.
+ * @param key The key.
+ * @param hash The hash of the key.
+ * @return int The slot of the key, -1 if the key does not exist.
+ */
+static int find_slot(HashIndex *index, uint64_t key, uint64_t hash) {
+    int group_mask = index->slot_count / HASH_INDEX_GROUP_SIZE - 1;
+    int group = (hash >> 7) & group_mask;
+
+    // Triangular probing, it visits every group because the number of groups is a power of 2.
+    for (int step = 1;; step++) {
+        int8_t *controls = index->controls + group * HASH_INDEX_GROUP_SIZE;
+        uint32_t matches = match_byte(controls, hash & 0x7F);
+
+        while (matches != 0) {
+            int slot = group * HASH_INDEX_GROUP_SIZE + __builtin_ctz(matches);
+
+            if (index->entries[slot].key == key) {
+                return slot;
+            }
+
+            matches &= matches - 1;
+        }
+
+        if (match_byte(controls, HASH_INDEX_CONTROL_EMPTY) != 0) {
+            // The key would have been inserted in this group.
+            return -1;
+        }
+
+        group = (group + step) & group_mask;
+    }
+}
+
+/**
+ * @brief Finds the first free slot along the probe sequence of a hash.
+ *
+ * @param index The table.
+ * @param hash The hash of the key.
+ * @return int The free slot.
+ */
+static int find_free_slot(HashIndex *index, uint64_t hash) {
+    int group_mask = index->slot_count / HASH_INDEX_GROUP_SIZE - 1;
+    int group = (hash >> 7) & group_mask;
+
+    for (int step = 1;; step++) {
+        uint32_t mask = match_free(index->controls + group * HASH_INDEX_GROUP_SIZE);
+
+        if (mask != 0) {
+            return group * HASH_INDEX_GROUP_SIZE + __builtin_ctz(mask);
+        }
+
+        group = (group + step) & group_mask;
+    }
+}
+
+/**
+ * @brief Computes the number of slots needed for a number of keys, at most 7/8 of the slots are used.
+ *
+ * @param capacity The number of keys.
+ * @return int The number of slots.
+ */
+static int compute_slot_count(int capacity) {
+    int slot_count = HASH_INDEX_GROUP_SIZE;
+
+    while (slot_count / 8 * 7 < capacity) {
+        slot_count *= 2;
+    }
+
+    return slot_count;
+}
+
+/**
+ * @brief Allocates empty slots.
+ *
+ * @param index The table.
+ * @param slot_count The number of slots.
+ */
+static void alloc_slots(HashIndex *index, int slot_count) {
+    // The control bytes of a group are loaded at once, with an aligned load.
+    index->controls = (int8_t *)aligned_alloc(HASH_INDEX_GROUP_SIZE, slot_count);
+    memset(index->controls, HASH_INDEX_CONTROL_EMPTY, slot_count);
+    index->entries = (HashIndexEntry *)malloc(sizeof(HashIndexEntry) * slot_count);
+    index->slot_count = slot_count;
+    index->used_count = 0;
+}
+
+/**
+ * @brief Moves the keys into a new set of slots, the deleted slots are thus freed.
+ *
+ * @param index The table.
+ * @param slot_count The new number of slots.
+ */
+static void rehash(HashIndex *index, int slot_count) {
+    int8_t *old_controls = index->controls;
+    HashIndexEntry *old_entries = index->entries;
+    int old_slot_count = index->slot_count;
+    alloc_slots(index, slot_count);
+
+    for (int i = 0; i < old_slot_count; i++) {
+        if (old_controls[i] >= 0) {
+            uint64_t hash = hash_key(old_entries[i].key);
+            int slot = find_free_slot(index, hash);
+            index->controls[slot] = hash & 0x7F;
+            index->entries[slot] = old_entries[i];
+        }
+    }
+
+    index->used_count = index->size;
+    free(old_controls);
+    free(old_entries);
+}
+
+HashIndex *HashIndex_init(int capacity) {
+    HashIndex *index = (HashIndex *)malloc(sizeof(HashIndex));
+    alloc_slots(index, compute_slot_count(capacity));
+    index->size = 0;
+    return index;
+}
+
+void HashIndex_destroy(HashIndex **index) {
+    free((*index)->controls);
+    free((*index)->entries);
+    free(*index);
+    *index = NULL;
+}
+
+void HashIndex_reserve(HashIndex *index, int capacity) {
+    int slot_count = compute_slot_count(capacity);
+
+    if (slot_count > index->slot_count) {
+        rehash(index, slot_count);
+    }
+}
+
+bool HashIndex_search(HashIndex *index, uint64_t key, uint64_t *data) {
+    int slot = find_slot(index, key, hash_key(key));
+
+    if (slot == -1) {
+        return false;
+    }
+
+    *data = index->entries[slot].data;
+    return true;
+}
+
+bool HashIndex_insert(HashIndex *index, uint64_t key, uint64_t data) {
+    uint64_t hash = hash_key(key);
+
+    if (find_slot(index, key, hash) != -1) {
+        return false;
+    }
+
+    if (index->used_count + 1 > index->slot_count / 8 * 7) {
+        // The table doubles if it is more than half full, otherwise there are enough deleted slots to be freed.
+        rehash(index, index->size + 1 > index->slot_count / 2 ? 2 * index->slot_count : index->slot_count);
+    }
+
+    int slot = find_free_slot(index, hash);
+
+    if (index->controls[slot] == HASH_INDEX_CONTROL_EMPTY) {
+        index->used_count++;
+    }
+
+    index->controls[slot] = hash & 0x7F;
+    index->entries[slot].key = key;
+    index->entries[slot].data = data;
+    index->size++;
+    return true;
+}
+
+bool HashIndex_delete(HashIndex *index, uint64_t key) {
+    int slot = find_slot(index, key, hash_key(key));
+
+    if (slot == -1) {
+        return false;
+    }
+
+    // A search stops at the first group that has an empty slot, so the slot can only become empty if its group
+    // already has one, otherwise it is marked as deleted so that the searches keep probing past it.
+    int8_t *controls = index->controls + slot / HASH_INDEX_GROUP_SIZE * HASH_INDEX_GROUP_SIZE;
+
+    if (match_byte(controls, HASH_INDEX_CONTROL_EMPTY) != 0) {
+        index->controls[slot] = HASH_INDEX_CONTROL_EMPTY;
+        index->used_count--;
+    } else {
+        index->controls[slot] = HASH_INDEX_CONTROL_DELETED;
+    }
+
+    index->size--;
+    return true;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file HashIndex.h
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#ifndef HASH_INDEX_H
+#define HASH_INDEX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// The slots are probed by groups of 16, the control bytes of a group are compared at once.
+#define HASH_INDEX_GROUP_SIZE 16
+#define HASH_INDEX_CONTROL_EMPTY ((int8_t)-128)
+#define HASH_INDEX_CONTROL_DELETED ((int8_t)-2)
+
+/**
+ * @brief Data structure that represents a key and its data in a slot of the hash table.
+ *
+ */
+typedef struct HashIndexEntry {
+    uint64_t key;
+    uint64_t data;
+} HashIndexEntry;
+
+/**
+ * @brief Data structure that represents an open addressing hash table (Swiss table). Each slot has a control byte:
+ * empty, deleted, or the 7 low bits of the hash of its key when it is full. A search compares the control bytes of a
+ * whole group with these 7 bits and only reads the keys of the slots that match.
+ *
+ */
+typedef struct HashIndex {
+    // A full slot has a non-negative control byte.
+    int8_t *controls;
+    HashIndexEntry *entries;
+    // A power of 2, at least one group.
+    int slot_count;
+    int size;
+    // The full and the deleted slots, a search only stops at a group that has an empty slot.
+    int used_count;
+} HashIndex;
+
+/**
+ * @brief Initializes the "HashIndex" data structure.
+ *
+ * @param capacity The number of keys the table can hold before it grows.
+ * @return HashIndex* An empty "HashIndex".
+ */
+HashIndex *HashIndex_init(int capacity);
+
+/**
+ * @brief Destroys the table and free its memory.
+ *
+ * @param index The table to be destroyed.
+ */
+void HashIndex_destroy(HashIndex **index);
+
+/**
+ * @brief Grows the table so that it holds the given number of keys without growing again.
+ *
+ * @param index The table.
+ * @param capacity The number of keys.
+ */
+void HashIndex_reserve(HashIndex *index, int capacity);
+
+/**
+ * @brief Searches for a key in the table.
+ *
+ * @param index The table in which to search.
+ * @param key The key to search.
+ * @param data The data found will be assigned to this variable.
+ * @return true The key exists in the table.
+ * @return false The key does not exist in the table.
+ */
+bool HashIndex_search(HashIndex *index, uint64_t key, uint64_t *data);
+
+/**
+ * @brief Inserts a key and its data in the table.
+ *
+ * @param index The table in which the key is inserted.
+ * @param key The key to be inserted.
+ * @param data The data to be associated with the key.
+ * @return true The key has been inserted.
+ * @return false The key already exists, the table is not modified.
+ */
+bool HashIndex_insert(HashIndex *index, uint64_t key, uint64_t data);
+
+/**
+ * @brief Deletes a key from the table.
+ *
+ * @param index The table in which the key is deleted.
+ * @param key The key to be deleted.
+ * @return true The key has been deleted.
+ * @return false The key does not exist.
+ */
+bool HashIndex_delete(HashIndex *index, uint64_t key);
+
+#endif
@@ -0,0 +1,143 @@
+/**
+ * @file NodeArena.c
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#include "NodeArena.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+// The first bytes of a chunk chain it to the previous one and give its size.
+typedef struct NodeArenaChunk {
+    void *next;
+    size_t size;
+} NodeArenaChunk;
+
+NodeArena *NodeArena_init(int block_size, NodeArenaPages pages) {
+    NodeArena *arena = (NodeArena *)malloc(sizeof(NodeArena));
+    // A block starts on a cache line so that a small node is read with as few lines as possible.
+    arena->block_size = (block_size + NODE_ARENA_BLOCK_ALIGNMENT - 1) / NODE_ARENA_BLOCK_ALIGNMENT * NODE_ARENA_BLOCK_ALIGNMENT;
+    arena->pages = pages;
+    arena->free_blocks = NULL;
+    arena->cursor = NULL;
+    arena->end = NULL;
+    arena->chunks = NULL;
+    arena->next_chunk_size = HUGE_PAGE_SIZE_IN_BYTES;
+    arena->mapped_size = 0;
+    return arena;
+}
+
+void NodeArena_destroy(NodeArena **arena) {
+    void *chunk = (*arena)->chunks;
+
+    while (chunk != NULL) {
+        NodeArenaChunk *header = (NodeArenaChunk *)chunk;
+        void *next = header->next;
+        munmap(chunk, header->size);
+        chunk = next;
+    }
+
+    free(*arena);
+    *arena = NULL;
+}
+
+/**
+ * @brief Maps a chunk with the kind of pages of the arena, and falls back to smaller pages for this chunk and the
+ * next ones if the kernel does not provide them.
+ *
+ * @param arena The arena.
+ * @param size The size of the chunk, a multiple of the size of a huge page.
+ * @return uint8_t* The chunk.
+ */
+static uint8_t *map_chunk(NodeArena *arena, size_t size) {
+    if (arena->pages == NODE_ARENA_EXPLICIT_HUGE_PAGES) {
+        // The huge pages are reserved when the chunk is mapped, so the mapping fails if there are not enough of them.
+        void *chunk = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+        if (chunk != MAP_FAILED) {
+            return (uint8_t *)chunk;
+        }
+
+        arena->pages = NODE_ARENA_TRANSPARENT_HUGE_PAGES;
+    }
+
+    // A huge page more is mapped so that the chunk can start on a huge page, only aligned ranges get huge pages.
+    size_t alignment = arena->pages == NODE_ARENA_SMALL_PAGES ? 0 : HUGE_PAGE_SIZE_IN_BYTES;
+    uint8_t *mapping = (uint8_t *)mmap(NULL, size + alignment, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "The memory of the nodes could not be mapped.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (arena->pages == NODE_ARENA_SMALL_PAGES) {
+        return mapping;
+    }
+
+    uint8_t *chunk = (uint8_t *)(((uintptr_t)mapping + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    // The parts of the mapping before and after the chunk are unmapped.
+    if (chunk > mapping) {
+        munmap(mapping, chunk - mapping);
+    }
+    if (mapping + size + alignment > chunk + size) {
+        munmap(chunk + size, mapping + size + alignment - (chunk + size));
+    }
+
+    if (madvise(chunk, size, MADV_HUGEPAGE) != 0) {
+        // The kernel does not support transparent huge pages.
+        arena->pages = NODE_ARENA_SMALL_PAGES;
+    }
+
+    return chunk;
+}
+
+void *NodeArena_alloc(NodeArena *arena) {
+    if (arena->free_blocks != NULL) {
+        void *block = arena->free_blocks;
+        arena->free_blocks = *(void **)block;
+        return block;
+    }
+
+    if (arena->cursor == NULL || arena->cursor + arena->block_size > arena->end) {
+        size_t size = arena->next_chunk_size;
+        uint8_t *chunk = map_chunk(arena, size);
+        NodeArenaChunk *header = (NodeArenaChunk *)chunk;
+        header->next = arena->chunks;
+        header->size = size;
+        arena->chunks = chunk;
+        arena->mapped_size += size;
+
+        // The header takes the place of a block so that the blocks stay aligned.
+        arena->cursor = chunk + NODE_ARENA_BLOCK_ALIGNMENT;
+        arena->end = chunk + size;
+
+        if (arena->next_chunk_size < NODE_ARENA_MAX_CHUNK_SIZE_IN_BYTES) {
+            arena->next_chunk_size *= 2;
+        }
+    }
+
+    void *block = arena->cursor;
+    arena->cursor += arena->block_size;
+    return block;
+}
+
+void NodeArena_free(NodeArena *arena, void *block) {
+    *(void **)block = arena->free_blocks;
+    arena->free_blocks = block;
+}
+
+const char *NodeArenaPages_name(NodeArenaPages pages) {
+    switch (pages) {
+        case NODE_ARENA_TRANSPARENT_HUGE_PAGES:
+            return "transparent huge pages";
+        case NODE_ARENA_EXPLICIT_HUGE_PAGES:
+            return "explicit huge pages";
+        default:
+            return "small pages";
+    }
+}
@@ -0,0 +1,92 @@
+/**
+ * @file NodeArena.h
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#ifndef NODE_ARENA_H
+#define NODE_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HUGE_PAGE_SIZE_IN_BYTES (2 * 1024 * 1024)
+// The first chunk of an arena is a single huge page, each next chunk is twice as large up to this size.
+#define NODE_ARENA_MAX_CHUNK_SIZE_IN_BYTES (64 * 1024 * 1024)
+#define NODE_ARENA_BLOCK_ALIGNMENT 64
+
+/**
+ * @brief The kind of pages that back the memory of an arena.
+ *
+ */
+typedef enum NodeArenaPages {
+    // The pages of the default size, usually 4 KiB.
+    NODE_ARENA_SMALL_PAGES,
+    // The chunks are aligned on huge pages and the kernel is asked with madvise to back them with huge pages.
+    NODE_ARENA_TRANSPARENT_HUGE_PAGES,
+    // The huge pages reserved by the administrator (vm.nr_hugepages), then transparent huge pages once there are none left.
+    NODE_ARENA_EXPLICIT_HUGE_PAGES,
+} NodeArenaPages;
+
+/**
+ * @brief Data structure that represents an allocator of blocks of the same size, carved from large chunks of memory
+ * mapped outside the heap. The blocks that are freed are reused by the next allocations and the chunks are only
+ * unmapped when the arena is destroyed.
+ *
+ */
+typedef struct NodeArena {
+    int block_size;
+    // The pages actually used, the arena falls back to smaller pages when the kernel does not provide the requested ones.
+    NodeArenaPages pages;
+    // The freed blocks, chained through their first bytes.
+    void *free_blocks;
+    // The part of the last chunk that has never been allocated.
+    uint8_t *cursor;
+    uint8_t *end;
+    // The chunks, chained through their first bytes.
+    void *chunks;
+    size_t next_chunk_size;
+    size_t mapped_size;
+} NodeArena;
+
+/**
+ * @brief Initializes the "NodeArena" data structure, no memory is mapped until the first allocation.
+ *
+ * @param block_size The size of the blocks, rounded up to a multiple of the size of a cache line.
+ * @param pages The kind of pages requested.
+ * @return NodeArena* The initialized arena.
+ */
+NodeArena *NodeArena_init(int block_size, NodeArenaPages pages);
+
+/**
+ * @brief Destroys the arena and unmaps its memory, along with all the blocks still allocated.
+ *
+ * @param arena The arena to be destroyed.
+ */
+void NodeArena_destroy(NodeArena **arena);
+
+/**
+ * @brief Allocates a block.
+ *
+ * @param arena The arena.
+ * @return void* The block, its content is undefined.
+ */
+void *NodeArena_alloc(NodeArena *arena);
+
+/**
+ * @brief Gives a block back to the arena.
+ *
+ * @param arena The arena.
+ * @param block The block, allocated by this arena.
+ */
+void NodeArena_free(NodeArena *arena, void *block);
+
+/**
+ * @brief Gets the name of a kind of pages.
+ *
+ * @param pages The kind of pages.
+ * @return const char* The name.
+ */
+const char *NodeArenaPages_name(NodeArenaPages pages);
+
+#endif
@@ -0,0 +1,675 @@
+/**
+ * @file RadixTree.c
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#include "RadixTree.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * @brief Gets a byte of a key, byte 0 is the most significant one.
+ *
+ * @param key The key.
+ * @param depth The position of the byte.
+ * @return uint8_t The byte.
+ */
+static uint8_t get_key_byte(uint64_t key, int depth) {
+    return key >> (8 * (RADIX_TREE_KEY_SIZE_IN_BYTES - 1 - depth));
+}
+
+/**
+ * @brief Checks if a child is a leaf.
+ *
+ * @param child The child.
+ * @return true The child is a leaf.
+ * @return false The child is an inner node.
+ */
+static bool is_leaf(void *child) {
+    return (uintptr_t)child & 1;
+}
+
+/**
+ * @brief Gets the leaf of a child.
+ *
+ * @param child The child, it must be a leaf.
+ * @return RadixTreeLeaf* The leaf.
+ */
+static RadixTreeLeaf *get_leaf(void *child) {
+    return (RadixTreeLeaf *)((uintptr_t)child - 1);
+}
+
+/**
+ * @brief Allocates a leaf.
+ *
+ * @param key The key.
+ * @param data The data of the key.
+ * @return void* The leaf, as a child.
+ */
+static void *create_leaf(uint64_t key, uint64_t data) {
+    RadixTreeLeaf *leaf = (RadixTreeLeaf *)malloc(sizeof(RadixTreeLeaf));
+    leaf->key = key;
+    leaf->data = data;
+    // malloc aligns the leaf, its lowest bit is free for the tag.
+    return (void *)((uintptr_t)leaf + 1);
+}
+
+/**
+ * @brief Allocates an inner node without children.
+ *
+ * @param type The type of node.
+ * @return RadixTreeNode* The node.
+ */
+static RadixTreeNode *create_node(int type) {
+    size_t size;
+
+    switch (type) {
+        case RADIX_TREE_NODE4:
+            size = sizeof(RadixTreeNode4);
+            break;
+        case RADIX_TREE_NODE16:
+            size = sizeof(RadixTreeNode16);
+            break;
+        case RADIX_TREE_NODE48:
+            size = sizeof(RadixTreeNode48);
+            break;
+        default:
+            size = sizeof(RadixTreeNode256);
+            break;
+    }
+
+    RadixTreeNode *node = (RadixTreeNode *)calloc(1, size);
+    node->type = type;
+    return node;
+}
+
+/**
+ * @brief Finds the position of a byte among the sorted bytes of a Node4 or a Node16.
+ *
+ * @param bytes The bytes of the children.
+ * @param count The number of children.
+ * @param byte The byte.
+ * @return int The position of the byte, -1 if the byte has no child.
+ */
+static int find_byte(uint8_t *bytes, int count, uint8_t byte) {
+#ifdef __SSE2__
+    if (count > 4) {
+        // The 16 bytes of a Node16 are compared at once, the bytes beyond the children are masked out.
+        __m128i matches = _mm_cmpeq_epi8(_mm_set1_epi8(byte), _mm_loadu_si128((__m128i *)bytes));
+        int mask = _mm_movemask_epi8(matches) & ((1 << count) - 1);
+        return mask != 0 ? __builtin_ctz(mask) : -1;
+    }
+#endif
+
+    for (int i = 0; i < count; i++) {
+        if (bytes[i] == byte) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Finds the child of a byte.
+ *
+ * @param node The inner node.
+ * @param byte The byte.
+ * @return void** The reference to the child, NULL if the byte has no child.
+ */
+static void **find_child(RadixTreeNode *node, uint8_t byte) {
+    switch (node->type) {
+        case RADIX_TREE_NODE4: {
+            RadixTreeNode4 *node4 = (RadixTreeNode4 *)node;
+            int i = find_byte(node4->bytes, node->child_count, byte);
+            return i != -1 ? &node4->children[i] : NULL;
+        }
+        case RADIX_TREE_NODE16: {
+            RadixTreeNode16 *node16 = (RadixTreeNode16 *)node;
+            int i = find_byte(node16->bytes, node->child_count, byte);
+            return i != -1 ? &node16->children[i] : NULL;
+        }
+        case RADIX_TREE_NODE48: {
+            RadixTreeNode48 *node48 = (RadixTreeNode48 *)node;
+            int i = node48->child_indexes[byte];
+            return i != 0 ? &node48->children[i - 1] : NULL;
+        }
+        default: {
+            RadixTreeNode256 *node256 = (RadixTreeNode256 *)node;
+            return node256->children[byte] != NULL ? &node256->children[byte] : NULL;
+        }
+    }
+}
+
+/**
+ * @brief Inserts a byte and its child in sorted bytes, the array has room for it.
+ *
+ * @param bytes The bytes of the children.
+ * @param children The children.
+ * @param count The number of children.
+ * @param byte The byte.
+ * @param child The child.
+ */
+static void insert_sorted_child(uint8_t *bytes, void **children, int count, uint8_t byte, void *child) {
+    int i = 0;
+    while (i < count && bytes[i] < byte) {
+        i++;
+    }
+
+    memmove(bytes + i + 1, bytes + i, count - i);
+    memmove(children + i + 1, children + i, sizeof(void *) * (count - i));
+    bytes[i] = byte;
+    children[i] = child;
+}
+
+/**
+ * @brief Adds a child to an inner node that has room for it.
+ *
+ * @param node The inner node.
+ * @param byte The byte of the child.
+ * @param child The child.
+ */
+static void add_child(RadixTreeNode *node, uint8_t byte, void *child) {
+    switch (node->type) {
+        case RADIX_TREE_NODE4: {
+            RadixTreeNode4 *node4 = (RadixTreeNode4 *)node;
+            insert_sorted_child(node4->bytes, node4->children, node->child_count, byte, child);
+            break;
+        }
+        case RADIX_TREE_NODE16: {
+            RadixTreeNode16 *node16 = (RadixTreeNode16 *)node;
+            insert_sorted_child(node16->bytes, node16->children, node->child_count, byte, child);
+            break;
+        }
+        case RADIX_TREE_NODE48: {
+            // The children of a Node48 are kept packed, the new one goes at the end.
+            RadixTreeNode48 *node48 = (RadixTreeNode48 *)node;
+            node48->children[node->child_count] = child;
+            node48->child_indexes[byte] = node->child_count + 1;
+            break;
+        }
+        default:
+            ((RadixTreeNode256 *)node)->children[byte] = child;
+            break;
+    }
+
+    node->child_count++;
+}
+
+/**
+ * @brief Removes the child of a byte from an inner node.
+ *
+ * @param node The inner node.
+ * @param byte The byte of the child.
+ */
+static void remove_child(RadixTreeNode *node, uint8_t byte) {
+    switch (node->type) {
+        case RADIX_TREE_NODE4:
+        case RADIX_TREE_NODE16: {
+            // A Node4 and a Node16 only differ by the size of their arrays.
+            uint8_t *bytes = node->type == RADIX_TREE_NODE4 ? ((RadixTreeNode4 *)node)->bytes : ((RadixTreeNode16 *)node)->bytes;
+            void **children = node->type == RADIX_TREE_NODE4 ? ((RadixTreeNode4 *)node)->children : ((RadixTreeNode16 *)node)->children;
+            int i = find_byte(bytes, node->child_count, byte);
+            memmove(bytes + i, bytes + i + 1, node->child_count - i - 1);
+            memmove(children + i, children + i + 1, sizeof(void *) * (node->child_count - i - 1));
+            break;
+        }
+        case RADIX_TREE_NODE48: {
+            // The last child fills the hole so that the children remain packed.
+            RadixTreeNode48 *node48 = (RadixTreeNode48 *)node;
+            int i = node48->child_indexes[byte] - 1;
+            int last = node->child_count - 1;
+            node48->child_indexes[byte] = 0;
+
+            if (i != last) {
+                node48->children[i] = node48->children[last];
+
+                for (int b = 0; b < 256; b++) {
+                    if (node48->child_indexes[b] == last + 1) {
+                        node48->child_indexes[b] = i + 1;
+                        break;
+                    }
+                }
+            }
+            break;
+        }
+        default:
+            ((RadixTreeNode256 *)node)->children[byte] = NULL;
+            break;
+    }
+
+    node->child_count--;
+}
+
+/**
+ * @brief Calls a function for each child of an inner node, in the order of the bytes.
+ *
+ * @param node The inner node.
+ * @param visitor The function called with the byte and the child.
+ * @param context Passed as is to the visitor.
+ */
+static void for_each_child(RadixTreeNode *node, void (*visitor)(uint8_t byte, void *child, void *context), void *context) {
+    switch (node->type) {
+        case RADIX_TREE_NODE4: {
+            RadixTreeNode4 *node4 = (RadixTreeNode4 *)node;
+            for (int i = 0; i < node->child_count; i++) {
+                visitor(node4->bytes[i], node4->children[i], context);
+            }
+            break;
+        }
+        case RADIX_TREE_NODE16: {
+            RadixTreeNode16 *node16 = (RadixTreeNode16 *)node;
+            for (int i = 0; i < node->child_count; i++) {
+                visitor(node16->bytes[i], node16->children[i], context);
+            }
+            break;
+        }
+        case RADIX_TREE_NODE48: {
+            RadixTreeNode48 *node48 = (RadixTreeNode48 *)node;
+            for (int b = 0; b < 256; b++) {
+                if (node48->child_indexes[b] != 0) {
+                    visitor(b, node48->children[node48->child_indexes[b] - 1], context);
+                }
+            }
+            break;
+        }
+        default: {
+            RadixTreeNode256 *node256 = (RadixTreeNode256 *)node;
+            for (int b = 0; b < 256; b++) {
+                if (node256->children[b] != NULL) {
+                    visitor(b, node256->children[b], context);
+                }
+            }
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Adds a child to a new inner node.
+ *
+ * @param byte The byte of the child.
+ * @param child The child.
+ * @param context The new inner node.
+ */
+static void move_child(uint8_t byte, void *child, void *context) {
+    add_child((RadixTreeNode *)context, byte, child);
+}
+
+/**
+ * @brief Replaces an inner node by a node of another type that holds the same prefix and children.
+ *
+ * @param ref The reference to the inner node, the new node is assigned to it.
+ * @param type The type of the new node.
+ */
+static void change_node_type(void **ref, int type) {
+    RadixTreeNode *node = (RadixTreeNode *)*ref;
+    RadixTreeNode *new_node = create_node(type);
+    new_node->prefix_length = node->prefix_length;
+    memcpy(new_node->prefix, node->prefix, node->prefix_length);
+    for_each_child(node, move_child, new_node);
+    free(node);
+    *ref = new_node;
+}
+
+/**
+ * @brief Checks if an inner node has no room for another child.
+ *
+ * @param node The inner node.
+ * @return true The node is full.
+ * @return false The node has room for another child.
+ */
+static bool is_full(RadixTreeNode *node) {
+    return node->type != RADIX_TREE_NODE256 && node->child_count == node->type;
+}
+
+/**
+ * @brief Inserts a key in a subtree.
+ *
+ * @param ref The reference to the root of the subtree, it is replaced if the subtree changes shape.
+ * @param key The key.
+ * @param data The data of the key.
+ * @param depth The number of bytes of the key above the subtree.
+ * @return true The key has been inserted.
+ * @return false The key already exists.
+ */
+static bool insert(void **ref, uint64_t key, uint64_t data, int depth) {
+    if (*ref == NULL) {
+        *ref = create_leaf(key, data);
+        return true;
+    }
+
+    if (is_leaf(*ref)) {
+        uint64_t leaf_key = get_leaf(*ref)->key;
+
+        if (leaf_key == key) {
+            return false;
+        }
+
+        // The leaf becomes a Node4 whose prefix is the bytes that the two keys share.
+        RadixTreeNode *node = create_node(RADIX_TREE_NODE4);
+        while (get_key_byte(leaf_key, depth + node->prefix_length) == get_key_byte(key, depth + node->prefix_length)) {
+            node->prefix[node->prefix_length] = get_key_byte(key, depth + node->prefix_length);
+            node->prefix_length++;
+        }
+
+        add_child(node, get_key_byte(leaf_key, depth + node->prefix_length), *ref);
+        add_child(node, get_key_byte(key, depth + node->prefix_length), create_leaf(key, data));
+        *ref = node;
+        return true;
+    }
+
+    RadixTreeNode *node = (RadixTreeNode *)*ref;
+    int matched_length = 0;
+
+    while (matched_length < node->prefix_length && node->prefix[matched_length] == get_key_byte(key, depth + matched_length)) {
+        matched_length++;
+    }
+
+    if (matched_length < node->prefix_length) {
+        // The key leaves the prefix, a Node4 takes the matched part of the prefix and the node keeps the rest.
+        RadixTreeNode *parent = create_node(RADIX_TREE_NODE4);
+        parent->prefix_length = matched_length;
+        memcpy(parent->prefix, node->prefix, matched_length);
+        add_child(parent, node->prefix[matched_length], node);
+        add_child(parent, get_key_byte(key, depth + matched_length), create_leaf(key, data));
+
+        node->prefix_length -= matched_length + 1;
+        memmove(node->prefix, node->prefix + matched_length + 1, node->prefix_length);
+        *ref = parent;
+        return true;
+    }
+
+    depth += node->prefix_length;
+    void **child = find_child(node, get_key_byte(key, depth));
+
+    if (child != NULL) {
+        return insert(child, key, data, depth + 1);
+    }
+
+    if (is_full(node)) {
+        change_node_type(ref, node->type == RADIX_TREE_NODE48 ? RADIX_TREE_NODE256 : (node->type == RADIX_TREE_NODE16 ? RADIX_TREE_NODE48 : RADIX_TREE_NODE16));
+        node = (RadixTreeNode *)*ref;
+    }
+
+    add_child(node, get_key_byte(key, depth), create_leaf(key, data));
+    return true;
+}
+
+/**
+ * @brief Replaces an inner node that has lost a child by a smaller one if it has few enough children. A Node4 with a
+ * single child is replaced by the child, the prefix of the node is then added in front of the prefix of the child.
+ *
+ * @param ref The reference to the inner node.
+ */
+static void shrink(void **ref) {
+    RadixTreeNode *node = (RadixTreeNode *)*ref;
+
+    // The thresholds are below the sizes at which the nodes grow, so that a node does not change type back and forth.
+    if (node->type == RADIX_TREE_NODE256 && node->child_count <= 37) {
+        change_node_type(ref, RADIX_TREE_NODE48);
+    } else if (node->type == RADIX_TREE_NODE48 && node->child_count <= 12) {
+        change_node_type(ref, RADIX_TREE_NODE16);
+    } else if (node->type == RADIX_TREE_NODE16 && node->child_count <= 3) {
+        change_node_type(ref, RADIX_TREE_NODE4);
+    } else if (node->type == RADIX_TREE_NODE4 && node->child_count == 1) {
+        RadixTreeNode4 *node4 = (RadixTreeNode4 *)node;
+        void *child = node4->children[0];
+
+        if (!is_leaf(child)) {
+            RadixTreeNode *child_node = (RadixTreeNode *)child;
+            uint8_t prefix[RADIX_TREE_KEY_SIZE_IN_BYTES - 1];
+            int prefix_length = node->prefix_length;
+            memcpy(prefix, node->prefix, prefix_length);
+            prefix[prefix_length++] = node4->bytes[0];
+            memcpy(prefix + prefix_length, child_node->prefix, child_node->prefix_length);
+            prefix_length += child_node->prefix_length;
+            memcpy(child_node->prefix, prefix, prefix_length);
+            child_node->prefix_length = prefix_length;
+        }
+
+        free(node);
+        *ref = child;
+    }
+}
+
+/**
+ * @brief Deletes a key from a subtree.
+ *
+ * @param ref The reference to the root of the subtree, it is replaced if the subtree changes shape.
+ * @param key The key.
+ * @param depth The number of bytes of the key above the subtree.
+ * @return true The key has been deleted.
+ * @return false The key does not exist.
+ */
+static bool delete(void **ref, uint64_t key, int depth) {
+    if (*ref == NULL) {
+        return false;
+    }
+
+    if (is_leaf(*ref)) {
+        // Only the root can be a leaf that is reached directly.
+        if (get_leaf(*ref)->key != key) {
+            return false;
+        }
+
+        free(get_leaf(*ref));
+        *ref = NULL;
+        return true;
+    }
+
+    RadixTreeNode *node = (RadixTreeNode *)*ref;
+
+    for (int i = 0; i < node->prefix_length; i++) {
+        if (node->prefix[i] != get_key_byte(key, depth + i)) {
+            return false;
+        }
+    }
+
+    depth += node->prefix_length;
+    uint8_t byte = get_key_byte(key, depth);
+    void **child = find_child(node, byte);
+
+    if (child == NULL) {
+        return false;
+    }
+
+    if (!is_leaf(*child)) {
+        return delete(child, key, depth + 1);
+    }
+
+    if (get_leaf(*child)->key != key) {
+        return false;
+    }
+
+    free(get_leaf(*child));
+    remove_child(node, byte);
+    shrink(ref);
+    return true;
+}
+
+/**
+ * @brief Frees a subtree.
+ *
+ * @param child The root of the subtree.
+ */
+static void destroy_subtree(void *child);
+
+/**
+ * @brief Frees a child of an inner node.
+ *
+ * @param byte The byte of the child.
+ * @param child The child.
+ * @param context Unused.
+ */
+static void destroy_child(uint8_t byte, void *child, void *context) {
+    (void)byte;
+    (void)context;
+    destroy_subtree(child);
+}
+
+static void destroy_subtree(void *child) {
+    if (child == NULL) {
+        return;
+    }
+
+    if (is_leaf(child)) {
+        free(get_leaf(child));
+        return;
+    }
+
+    for_each_child((RadixTreeNode *)child, destroy_child, NULL);
+    free(child);
+}
+
+/**
+ * @brief Data structure that represents the state of an iteration over a range of keys.
+ *
+ */
+typedef struct RangeIteration {
+    uint64_t from;
+    uint64_t to;
+    RadixTreeVisitor visitor;
+    void *context;
+    // The bytes of the keys above the current subtree, the other bytes are 0.
+    uint64_t path;
+    int depth;
+} RangeIteration;
+
+/**
+ * @brief Visits the keys of a subtree that are in the range.
+ *
+ * @param child The root of the subtree.
+ * @param iteration The iteration.
+ */
+static void visit_range(void *child, RangeIteration *iteration);
+
+/**
+ * @brief Visits a child of an inner node, the byte of the child is added to the path.
+ *
+ * @param byte The byte of the child.
+ * @param child The child.
+ * @param context The iteration.
+ */
+static void visit_child_range(uint8_t byte, void *child, void *context) {
+    RangeIteration *iteration = (RangeIteration *)context;
+    uint64_t path = iteration->path;
+    int depth = iteration->depth;
+
+    iteration->path |= (uint64_t)byte << (8 * (RADIX_TREE_KEY_SIZE_IN_BYTES - 1 - depth));
+    iteration->depth++;
+    visit_range(child, iteration);
+
+    iteration->path = path;
+    iteration->depth = depth;
+}
+
+static void visit_range(void *child, RangeIteration *iteration) {
+    if (is_leaf(child)) {
+        RadixTreeLeaf *leaf = get_leaf(child);
+
+        if (leaf->key >= iteration->from && leaf->key <= iteration->to) {
+            iteration->visitor(leaf->key, leaf->data, iteration->context);
+        }
+        return;
+    }
+
+    RadixTreeNode *node = (RadixTreeNode *)child;
+    uint64_t path = iteration->path;
+    int depth = iteration->depth;
+
+    for (int i = 0; i < node->prefix_length; i++) {
+        iteration->path |= (uint64_t)node->prefix[i] << (8 * (RADIX_TREE_KEY_SIZE_IN_BYTES - 1 - iteration->depth));
+        iteration->depth++;
+    }
+
+    // The keys of the subtree all start with the path, they lie between the path followed by 0s and by 1s.
+    uint64_t free_bits = ~(uint64_t)0 >> (8 * iteration->depth);
+
+    if ((iteration->path | free_bits) >= iteration->from && iteration->path <= iteration->to) {
+        for_each_child(node, visit_child_range, iteration);
+    }
+
+    iteration->path = path;
+    iteration->depth = depth;
+}
+
+RadixTree *RadixTree_init() {
+    RadixTree *tree = (RadixTree *)malloc(sizeof(RadixTree));
+    tree->root = NULL;
+    tree->size = 0;
+    return tree;
+}
+
+void RadixTree_destroy(RadixTree **tree) {
+    destroy_subtree((*tree)->root);
+    free(*tree);
+    *tree = NULL;
+}
+
+bool RadixTree_search(RadixTree *tree, uint64_t key, uint64_t *data) {
+    void *child = tree->root;
+    int depth = 0;
+
+    while (child != NULL && !is_leaf(child)) {
+        RadixTreeNode *node = (RadixTreeNode *)child;
+
+        for (int i = 0; i < node->prefix_length; i++) {
+            if (node->prefix[i] != get_key_byte(key, depth + i)) {
+                return false;
+            }
+        }
+
+        depth += node->prefix_length;
+        void **ref = find_child(node, get_key_byte(key, depth));
+
+        if (ref == NULL) {
+            return false;
+        }
+
+        child = *ref;
+        depth++;
+    }
+
+    if (child == NULL || get_leaf(child)->key != key) {
+        return false;
+    }
+
+    *data = get_leaf(child)->data;
+    return true;
+}
+
+bool RadixTree_insert(RadixTree *tree, uint64_t key, uint64_t data) {
+    if (!insert(&tree->root, key, data, 0)) {
+        return false;
+    }
+
+    tree->size++;
+    return true;
+}
+
+bool RadixTree_delete(RadixTree *tree, uint64_t key) {
+    if (!delete(&tree->root, key, 0)) {
+        return false;
+    }
+
+    tree->size--;
+    return true;
+}
+
+void RadixTree_for_each_range(RadixTree *tree, uint64_t from, uint64_t to, RadixTreeVisitor visitor, void *context) {
+    if (tree->root == NULL || from > to) {
+        return;
+    }
+
+    RangeIteration iteration = {from, to, visitor, context, 0, 0};
+    visit_range(tree->root, &iteration);
+}
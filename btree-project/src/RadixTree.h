@@ -0,0 +1,162 @@
+/**
+ * @file RadixTree.h
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#ifndef RADIX_TREE_H
+#define RADIX_TREE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define RADIX_TREE_KEY_SIZE_IN_BYTES 8
+
+// The types of the inner nodes are named after the number of children they can hold.
+#define RADIX_TREE_NODE4 4
+#define RADIX_TREE_NODE16 16
+#define RADIX_TREE_NODE48 48
+#define RADIX_TREE_NODE256 256
+
+/**
+ * @brief Data structure that represents the part common to the inner nodes of a radix tree. The bytes of the keys
+ * that are the same for all the keys below the node are stored once in its prefix (path compression).
+ *
+ */
+typedef struct RadixTreeNode {
+    uint16_t type;
+    uint16_t child_count;
+    uint8_t prefix_length;
+    uint8_t prefix[RADIX_TREE_KEY_SIZE_IN_BYTES - 1];
+} RadixTreeNode;
+
+/**
+ * @brief Data structure that represents an inner node of up to 4 children, the bytes of the children are sorted.
+ *
+ */
+typedef struct RadixTreeNode4 {
+    RadixTreeNode header;
+    uint8_t bytes[4];
+    void *children[4];
+} RadixTreeNode4;
+
+/**
+ * @brief Data structure that represents an inner node of up to 16 children, the bytes of the children are sorted
+ * and compared at once.
+ *
+ */
+typedef struct RadixTreeNode16 {
+    RadixTreeNode header;
+    uint8_t bytes[16];
+    void *children[16];
+} RadixTreeNode16;
+
+/**
+ * @brief Data structure that represents an inner node of up to 48 children. The child of a byte is at
+ * children[child_indexes[byte] - 1], 0 = the byte has no child.
+ *
+ */
+typedef struct RadixTreeNode48 {
+    RadixTreeNode header;
+    uint8_t child_indexes[256];
+    void *children[48];
+} RadixTreeNode48;
+
+/**
+ * @brief Data structure that represents an inner node with one child per byte.
+ *
+ */
+typedef struct RadixTreeNode256 {
+    RadixTreeNode header;
+    void *children[256];
+} RadixTreeNode256;
+
+/**
+ * @brief Data structure that represents a key and its data. A leaf is placed as high as possible in the tree, its key
+ * is compared as a whole once it is reached.
+ *
+ */
+typedef struct RadixTreeLeaf {
+    uint64_t key;
+    uint64_t data;
+} RadixTreeLeaf;
+
+/**
+ * @brief Data structure that represents an adaptive radix tree over 64-bit keys, a key is read one byte at a time
+ * starting from its most significant byte, so the keys are visited in ascending order. A child is either an inner
+ * node or a leaf whose address is tagged with its lowest bit.
+ *
+ */
+typedef struct RadixTree {
+    void *root;
+    int size;
+} RadixTree;
+
+/**
+ * @brief Function called for each key of a radix tree.
+ *
+ * @param key The key.
+ * @param data The data of the key.
+ * @param context The context given to the iteration.
+ */
+typedef void (*RadixTreeVisitor)(uint64_t key, uint64_t data, void *context);
+
+/**
+ * @brief Initializes the "RadixTree" data structure.
+ *
+ * @return RadixTree* An empty "RadixTree".
+ */
+RadixTree *RadixTree_init();
+
+/**
+ * @brief Destroys the tree and free its memory.
+ *
+ * @param tree The tree to be destroyed.
+ */
+void RadixTree_destroy(RadixTree **tree);
+
+/**
+ * @brief Searches for a key in the tree, at most one node is visited per byte of the key.
+ *
+ * @param tree The tree in which to search.
+ * @param key The key to search.
+ * @param data The data found will be assigned to this variable.
+ * @return true The key exists in the tree.
+ * @return false The key does not exist in the tree.
+ */
+bool RadixTree_search(RadixTree *tree, uint64_t key, uint64_t *data);
+
+/**
+ * @brief Inserts a key and its data in the tree.
+ *
+ * @param tree The tree in which the key is inserted.
+ * @param key The key to be inserted.
+ * @param data The data to be associated with the key.
+ * @return true The key has been inserted.
+ * @return false The key already exists, the tree is not modified.
+ */
+bool RadixTree_insert(RadixTree *tree, uint64_t key, uint64_t data);
+
+/**
+ * @brief Deletes a key from the tree, the nodes that hold too few children are replaced by smaller ones.
+ *
+ * @param tree The tree in which the key is deleted.
+ * @param key The key to be deleted.
+ * @return true The key has been deleted.
+ * @return false The key does not exist.
+ */
+bool RadixTree_delete(RadixTree *tree, uint64_t key);
+
+/**
+ * @brief Calls a function for each key between two keys, in ascending order. The subtrees whose keys are all out of
+ * the range are skipped.
+ *
+ * @param tree The tree.
+ * @param from The first key, included.
+ * @param to The last key, included.
+ * @param visitor The function called for each key.
+ * @param context Passed as is to the visitor.
+ */
+void RadixTree_for_each_range(RadixTree *tree, uint64_t from, uint64_t to, RadixTreeVisitor visitor, void *context);
+
+#endif
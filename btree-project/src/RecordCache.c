@@ -0,0 +1,273 @@
+/**
+ * @file RecordCache.c
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#include "RecordCache.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "DirectoryRecord.h"
+#include "HashIndex.h"
+
+/**
+ * @brief Initializes an empty queue.
+ *
+ * @param queue The queue.
+ * @param capacity The maximum number of entries in the queue.
+ */
+static void init_queue(RecordCacheQueue *queue, int capacity) {
+    queue->entries = (int *)malloc(sizeof(int) * capacity);
+    queue->head = 0;
+    queue->size = 0;
+    queue->capacity = capacity;
+}
+
+/**
+ * @brief Adds an entry at the end of a queue.
+ *
+ * @param queue The queue.
+ * @param entry The entry.
+ */
+static void push(RecordCacheQueue *queue, int entry) {
+    queue->entries[(queue->head + queue->size) % queue->capacity] = entry;
+    queue->size++;
+}
+
+/**
+ * @brief Removes the entry at the front of a queue.
+ *
+ * @param queue The queue, it must not be empty.
+ * @return int The entry.
+ */
+static int pop(RecordCacheQueue *queue) {
+    int entry = queue->entries[queue->head];
+    queue->head = (queue->head + 1) % queue->capacity;
+    queue->size--;
+    return entry;
+}
+
+/**
+ * @brief Gets the shard of a key. The directory picks its shards with the high bits of the key, the low bits are
+ * used here.
+ *
+ * @param cache The cache.
+ * @param key The hash of the phone number.
+ * @return RecordCacheShard* The shard.
+ */
+static RecordCacheShard *get_shard(RecordCache *cache, uint64_t key) {
+    return &cache->shards[key % RECORD_CACHE_SHARD_COUNT];
+}
+
+/**
+ * @brief Gets the position of a key in the ghost table.
+ *
+ * @param shard The shard.
+ * @param key The hash of the phone number.
+ * @return int The position.
+ */
+static int get_ghost_position(RecordCacheShard *shard, uint64_t key) {
+    return (key / RECORD_CACHE_SHARD_COUNT) % shard->ghost_capacity;
+}
+
+/**
+ * @brief Removes the entry at the front of the small queue. The entry moves to the main queue if it has been accessed
+ * since it was added, otherwise its key goes to the ghost table.
+ *
+ * @param shard The shard.
+ */
+static void evict_small(RecordCacheShard *shard) {
+    int index = pop(&shard->small);
+    RecordCacheEntry *entry = &shard->entries[index];
+
+    if (entry->is_valid && entry->frequency > 0) {
+        entry->frequency = 0;
+        push(&shard->main, index);
+        return;
+    }
+
+    if (entry->is_valid) {
+        int position = get_ghost_position(shard, entry->key);
+        shard->ghost_keys[position] = entry->key;
+        shard->is_ghost[position] = true;
+        HashIndex_delete(shard->table, entry->key);
+    }
+
+    shard->free_entries[shard->free_count++] = index;
+}
+
+/**
+ * @brief Removes the entry at the front of the main queue. The entry goes back to the end of the queue if it has been
+ * accessed since its last turn, and is then counted as accessed once less.
+ *
+ * @param shard The shard.
+ */
+static void evict_main(RecordCacheShard *shard) {
+    int index = pop(&shard->main);
+    RecordCacheEntry *entry = &shard->entries[index];
+
+    if (entry->is_valid && entry->frequency > 0) {
+        entry->frequency--;
+        push(&shard->main, index);
+        return;
+    }
+
+    if (entry->is_valid) {
+        HashIndex_delete(shard->table, entry->key);
+    }
+
+    shard->free_entries[shard->free_count++] = index;
+}
+
+/**
+ * @brief Evicts entries until one is free. The small queue is emptied first as long as it is beyond its share.
+ *
+ * @param shard The shard.
+ */
+static void make_room(RecordCacheShard *shard) {
+    while (shard->free_count == 0) {
+        if (shard->small.size > shard->small_capacity || shard->main.size == 0) {
+            evict_small(shard);
+        } else {
+            evict_main(shard);
+        }
+    }
+}
+
+RecordCache *RecordCache_init(int capacity) {
+    RecordCache *cache = (RecordCache *)malloc(sizeof(RecordCache));
+    int shard_capacity = capacity / RECORD_CACHE_SHARD_COUNT > 0 ? capacity / RECORD_CACHE_SHARD_COUNT : 1;
+
+    for (int i = 0; i < RECORD_CACHE_SHARD_COUNT; i++) {
+        RecordCacheShard *shard = &cache->shards[i];
+        pthread_mutex_init(&shard->lock, NULL);
+        shard->entries = (RecordCacheEntry *)malloc(sizeof(RecordCacheEntry) * shard_capacity);
+        shard->free_entries = (int *)malloc(sizeof(int) * shard_capacity);
+        shard->free_count = shard_capacity;
+
+        for (int j = 0; j < shard_capacity; j++) {
+            shard->free_entries[j] = j;
+        }
+
+        shard->table = HashIndex_init(shard_capacity);
+        // Every entry fits in either queue, the sizes of the queues are bounded by the evictions.
+        init_queue(&shard->small, shard_capacity);
+        init_queue(&shard->main, shard_capacity);
+        shard->small_capacity = shard_capacity / 10 > 0 ? shard_capacity / 10 : 1;
+        shard->ghost_capacity = shard_capacity;
+        shard->ghost_keys = (uint64_t *)malloc(sizeof(uint64_t) * shard_capacity);
+        shard->is_ghost = (bool *)calloc(shard_capacity, sizeof(bool));
+        shard->hit_count = 0;
+        shard->miss_count = 0;
+    }
+
+    return cache;
+}
+
+void RecordCache_destroy(RecordCache **cache) {
+    for (int i = 0; i < RECORD_CACHE_SHARD_COUNT; i++) {
+        RecordCacheShard *shard = &(*cache)->shards[i];
+        pthread_mutex_destroy(&shard->lock);
+        free(shard->entries);
+        free(shard->free_entries);
+        HashIndex_destroy(&shard->table);
+        free(shard->small.entries);
+        free(shard->main.entries);
+        free(shard->ghost_keys);
+        free(shard->is_ghost);
+    }
+
+    free(*cache);
+    *cache = NULL;
+}
+
+DirectoryRecord *RecordCache_get(RecordCache *cache, uint64_t key) {
+    RecordCacheShard *shard = get_shard(cache, key);
+    DirectoryRecord *record = NULL;
+    uint64_t index;
+
+    pthread_mutex_lock(&shard->lock);
+
+    if (HashIndex_search(shard->table, key, &index)) {
+        // A hit only counts the access, the entry is not moved.
+        RecordCacheEntry *entry = &shard->entries[index];
+        if (entry->frequency < RECORD_CACHE_MAX_FREQUENCY) {
+            entry->frequency++;
+        }
+
+        record = (DirectoryRecord *)malloc(sizeof(DirectoryRecord));
+        *record = entry->record;
+        shard->hit_count++;
+    } else {
+        shard->miss_count++;
+    }
+
+    pthread_mutex_unlock(&shard->lock);
+    return record;
+}
+
+void RecordCache_put(RecordCache *cache, uint64_t key, DirectoryRecord *record) {
+    RecordCacheShard *shard = get_shard(cache, key);
+    uint64_t index;
+
+    pthread_mutex_lock(&shard->lock);
+
+    if (HashIndex_search(shard->table, key, &index)) {
+        shard->entries[index].record = *record;
+        pthread_mutex_unlock(&shard->lock);
+        return;
+    }
+
+    make_room(shard);
+    index = shard->free_entries[--shard->free_count];
+    RecordCacheEntry *entry = &shard->entries[index];
+    entry->key = key;
+    entry->record = *record;
+    entry->frequency = 0;
+    entry->is_valid = true;
+    HashIndex_insert(shard->table, key, index);
+
+    int position = get_ghost_position(shard, key);
+
+    if (shard->is_ghost[position] && shard->ghost_keys[position] == key) {
+        // The record was evicted recently, it is given a place in the main queue this time.
+        shard->is_ghost[position] = false;
+        push(&shard->main, index);
+    } else {
+        push(&shard->small, index);
+    }
+
+    pthread_mutex_unlock(&shard->lock);
+}
+
+void RecordCache_invalidate(RecordCache *cache, uint64_t key) {
+    RecordCacheShard *shard = get_shard(cache, key);
+    uint64_t index;
+
+    pthread_mutex_lock(&shard->lock);
+
+    if (HashIndex_search(shard->table, key, &index)) {
+        // The entry remains in its queue until it reaches the front, it is freed there.
+        shard->entries[index].is_valid = false;
+        HashIndex_delete(shard->table, key);
+    }
+
+    pthread_mutex_unlock(&shard->lock);
+}
+
+void RecordCache_get_counters(RecordCache *cache, uint64_t *hit_count, uint64_t *miss_count) {
+    *hit_count = 0;
+    *miss_count = 0;
+
+    for (int i = 0; i < RECORD_CACHE_SHARD_COUNT; i++) {
+        RecordCacheShard *shard = &cache->shards[i];
+        pthread_mutex_lock(&shard->lock);
+        *hit_count += shard->hit_count;
+        *miss_count += shard->miss_count;
+        pthread_mutex_unlock(&shard->lock);
+    }
+}
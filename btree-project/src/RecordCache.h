@@ -0,0 +1,130 @@
+/**
+ * @file RecordCache.h
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#ifndef RECORD_CACHE_H
+#define RECORD_CACHE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "DirectoryRecord.h"
+#include "HashIndex.h"
+
+// The keys are spread over independent shards, each one with its own lock.
+#define RECORD_CACHE_SHARD_COUNT 16
+// The accesses to a record are counted up to this value.
+#define RECORD_CACHE_MAX_FREQUENCY 3
+
+/**
+ * @brief Data structure that represents a decoded record held by the cache.
+ *
+ */
+typedef struct RecordCacheEntry {
+    uint64_t key;
+    DirectoryRecord record;
+    uint8_t frequency;
+    // false = the record has been invalidated, the entry is freed once it leaves its queue.
+    bool is_valid;
+} RecordCacheEntry;
+
+/**
+ * @brief Data structure that represents a FIFO queue of entries, stored in a ring buffer.
+ *
+ */
+typedef struct RecordCacheQueue {
+    int *entries;
+    int head;
+    int size;
+    int capacity;
+} RecordCacheQueue;
+
+/**
+ * @brief Data structure that represents a shard of the cache, it is managed with the S3-FIFO policy. A new record
+ * enters the small queue, and moves to the main queue only if it is accessed again before it leaves the small one.
+ * The main queue gives another turn to the records accessed since their last turn. The keys evicted from the small
+ * queue are remembered in the ghost table, such a key goes straight to the main queue when it comes back.
+ *
+ */
+typedef struct RecordCacheShard {
+    pthread_mutex_t lock;
+    RecordCacheEntry *entries;
+    // The entries that are not in a queue.
+    int *free_entries;
+    int free_count;
+    // Key -> entry.
+    HashIndex *table;
+    RecordCacheQueue small;
+    RecordCacheQueue main;
+    // The size the small queue is kept to, 10% of the entries.
+    int small_capacity;
+    // The recently evicted keys, a key is placed at the position given by its hash and replaces the previous one.
+    uint64_t *ghost_keys;
+    bool *is_ghost;
+    int ghost_capacity;
+    uint64_t hit_count;
+    uint64_t miss_count;
+} RecordCacheShard;
+
+/**
+ * @brief Data structure that represents a bounded cache of decoded records, keyed by the hash of their phone number.
+ *
+ */
+typedef struct RecordCache {
+    RecordCacheShard shards[RECORD_CACHE_SHARD_COUNT];
+} RecordCache;
+
+/**
+ * @brief Initializes the "RecordCache" data structure.
+ *
+ * @param capacity The maximum number of records in the cache.
+ * @return RecordCache* An empty "RecordCache".
+ */
+RecordCache *RecordCache_init(int capacity);
+
+/**
+ * @brief Destroys the cache and free its memory.
+ *
+ * @param cache The cache to be destroyed.
+ */
+void RecordCache_destroy(RecordCache **cache);
+
+/**
+ * @brief Searches for a record in the cache, a hit or a miss is counted.
+ *
+ * @param cache The cache.
+ * @param key The hash of the phone number.
+ * @return DirectoryRecord* A copy of the record, NULL if it is not in the cache. The caller becomes the owner of the copy.
+ */
+DirectoryRecord *RecordCache_get(RecordCache *cache, uint64_t key);
+
+/**
+ * @brief Adds a record to the cache or replaces it, a record is evicted if the cache is full.
+ *
+ * @param cache The cache.
+ * @param key The hash of the phone number.
+ * @param record The record, it is copied.
+ */
+void RecordCache_put(RecordCache *cache, uint64_t key, DirectoryRecord *record);
+
+/**
+ * @brief Removes a record from the cache if it is there.
+ *
+ * @param cache The cache.
+ * @param key The hash of the phone number.
+ */
+void RecordCache_invalidate(RecordCache *cache, uint64_t key);
+
+/**
+ * @brief Sums the hits and the misses of the shards.
+ *
+ * @param cache The cache.
+ * @param hit_count The number of hits will be assigned to this variable.
+ * @param miss_count The number of misses will be assigned to this variable.
+ */
+void RecordCache_get_counters(RecordCache *cache, uint64_t *hit_count, uint64_t *miss_count);
+
+#endif
@@ -0,0 +1,654 @@
+/**
+ * @file Server.c
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+// accept4 is a GNU extension.
+#define _GNU_SOURCE
+#include "Server.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "Array.h"
+#include "Directory.h"
+#include "DirectoryRecord.h"
+#include "DirectoryStats.h"
+
+#define EPOLL_TIMEOUT_MS 200
+#define LISTEN_BACKLOG 128
+#define SERVER_READ_SIZE 4096
+// A connection is no longer read while it has more responses than this waiting to be sent, a client that does not read
+// its responses cannot make the server use more memory.
+#define SERVER_OUTPUT_LIMIT (1 << 20)
+
+static volatile sig_atomic_t is_stop_requested = 0;
+static volatile sig_atomic_t is_save_requested = 0;
+static volatile sig_atomic_t is_latency_dump_requested = 0;
+
+/**
+ * @brief Data structure that represents a connection of a client.
+ *
+ */
+typedef struct Connection {
+    int fd;
+    // The bytes received that do not form a complete request yet.
+    uint8_t *input;
+    int input_size;
+    int input_capacity;
+    // The responses not sent yet, from output_offset to output_size. They are sent as the client reads them.
+    uint8_t *output;
+    int output_offset;
+    int output_size;
+    int output_capacity;
+    struct Connection *previous;
+    struct Connection *next;
+} Connection;
+
+/**
+ * @brief Data structure that represents the state shared by the workers.
+ *
+ */
+typedef struct Server {
+    // The directory does its own locking, per shard if it is sharded.
+    Directory *directory;
+    int listen_fd;
+    int epoll_fd;
+    // The open connections, they are closed when the server stops.
+    Connection *connections;
+    pthread_mutex_t connections_mutex;
+} Server;
+
+/**
+ * @brief Requests the server to stop.
+ *
+ * @param signal_number The received signal.
+ */
+static void handle_stop_signal(int signal_number) {
+    (void)signal_number;
+    is_stop_requested = 1;
+}
+
+/**
+ * @brief Requests the server to save a snapshot of the index.
+ *
+ * @param signal_number The received signal.
+ */
+static void handle_save_signal(int signal_number) {
+    (void)signal_number;
+    is_save_requested = 1;
+}
+
+/**
+ * @brief Requests the server to display the latencies of the operations.
+ *
+ * @param signal_number The received signal.
+ */
+static void handle_latency_dump_signal(int signal_number) {
+    (void)signal_number;
+    is_latency_dump_requested = 1;
+}
+
+/**
+ * @brief Adds bytes to the responses waiting to be sent on a connection.
+ *
+ * @param connection The connection.
+ * @param bytes The bytes.
+ * @param size The number of bytes.
+ */
+static void append_output(Connection *connection, uint8_t *bytes, int size) {
+    if (connection->output_capacity - connection->output_size < size) {
+        // The bytes already sent are dropped before the buffer is enlarged.
+        memmove(connection->output, connection->output + connection->output_offset, connection->output_size - connection->output_offset);
+        connection->output_size -= connection->output_offset;
+        connection->output_offset = 0;
+    }
+
+    if (connection->output_capacity - connection->output_size < size) {
+        connection->output_capacity = 2 * connection->output_capacity + size;
+        connection->output = (uint8_t *)realloc(connection->output, connection->output_capacity);
+    }
+
+    memcpy(connection->output + connection->output_size, bytes, size);
+    connection->output_size += size;
+}
+
+/**
+ * @brief Gets the number of bytes of the responses waiting to be sent on a connection.
+ *
+ * @param connection The connection.
+ * @return int The number of bytes.
+ */
+static int get_pending_output_size(Connection *connection) {
+    return connection->output_size - connection->output_offset;
+}
+
+/**
+ * @brief Sends as many of the waiting responses as the socket accepts without blocking, the rest is sent when the
+ * socket becomes writable again.
+ *
+ * @param connection The connection.
+ * @return true The connection can be kept.
+ * @return false An error occurred, the connection must be closed.
+ */
+static bool flush_output(Connection *connection) {
+    while (get_pending_output_size(connection) > 0) {
+        ssize_t n = send(connection->fd, connection->output + connection->output_offset, get_pending_output_size(connection), MSG_NOSIGNAL);
+
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;
+        }
+
+        if (n <= 0) {
+            return false;
+        }
+
+        connection->output_offset += n;
+    }
+
+    connection->output_offset = 0;
+    connection->output_size = 0;
+    return true;
+}
+
+/**
+ * @brief Gets the size of a request other than BATCH from its opcode.
+ *
+ * @param opcode The opcode of the request.
+ * @return int The size of the request with its opcode, -1 if the opcode is unknown or BATCH.
+ */
+static int get_simple_request_size(uint8_t opcode) {
+    switch (opcode) {
+        case SERVER_OPCODE_SEARCH:
+        case SERVER_OPCODE_DELETE:
+            return 1 + PHONE_NUMBER_MAXLEN_WITHOUT_NULL_CHARACTER;
+        case SERVER_OPCODE_APPEND:
+        case SERVER_OPCODE_UPDATE:
+            return 1 + DirectoryRecord_size_on_disk();
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Finds out whether the bytes received start with a complete request.
+ *
+ * @param bytes The bytes received.
+ * @param size The number of bytes received.
+ * @return int The size of the request, 0 if it is not complete yet, -1 if it is malformed.
+ */
+static int get_request_size(uint8_t *bytes, int size) {
+    if (size < 1) {
+        return 0;
+    }
+
+    if (bytes[0] != SERVER_OPCODE_BATCH) {
+        int request_size = get_simple_request_size(bytes[0]);
+        return request_size < 0 || request_size <= size ? request_size : 0;
+    }
+
+    if (size < 3) {
+        return 0;
+    }
+
+    int count = (int)bytes[1] << 8 | (int)bytes[2];
+    int offset = 3;
+
+    for (int i = 0; i < count; i++) {
+        if (offset >= size) {
+            return 0;
+        }
+
+        // Batches cannot be nested.
+        int request_size = get_simple_request_size(bytes[offset]);
+        if (request_size < 0) {
+            return -1;
+        }
+
+        offset += request_size;
+    }
+
+    return offset <= size ? offset : 0;
+}
+
+/**
+ * @brief Appends the response of a SEARCH request.
+ *
+ * @param record The record found, NULL if not found. It is destroyed.
+ * @param response The response is appended to this array.
+ */
+static void append_search_response(DirectoryRecord *record, ByteArray *response) {
+    if (record == NULL) {
+        ByteArray_append(response, SERVER_STATUS_FAILURE);
+        return;
+    }
+
+    ByteArray_append(response, SERVER_STATUS_OK);
+    ByteArray *byte_array = DirectoryRecord_to_ByteArray(record);
+    for (int i = 0; i < byte_array->size; i++) {
+        ByteArray_append(response, byte_array->items[i]);
+    }
+    ByteArray_destroy(&byte_array);
+    DirectoryRecord_destroy(&record);
+}
+
+/**
+ * @brief Keeps a result of a batch search at the index of its phone number.
+ *
+ * @param index The index of the phone number in the batch.
+ * @param record The record found, NULL if not found.
+ * @param context The array of the records.
+ */
+static void store_search_result(int index, DirectoryRecord *record, void *context) {
+    ((DirectoryRecord **)context)[index] = record;
+}
+
+/**
+ * @brief Executes consecutive SEARCH requests of a batch at once, then appends their responses in their order.
+ *
+ * @param server The server.
+ * @param requests The first request, the others follow it.
+ * @param count The number of requests.
+ * @param response The responses are appended to this array.
+ */
+static void execute_searches(Server *server, uint8_t *requests, int count, ByteArray *response) {
+    if (count == 0) {
+        return;
+    }
+
+    char(*phone_numbers)[PHONE_NUMBER_MAXLEN] = (char(*)[PHONE_NUMBER_MAXLEN])malloc(sizeof(*phone_numbers) * count);
+    DirectoryRecord **records = (DirectoryRecord **)malloc(sizeof(DirectoryRecord *) * count);
+
+    for (int i = 0; i < count; i++) {
+        uint8_t *request = requests + i * get_simple_request_size(SERVER_OPCODE_SEARCH);
+        memcpy(phone_numbers[i], request + 1, PHONE_NUMBER_MAXLEN_WITHOUT_NULL_CHARACTER);
+        phone_numbers[i][PHONE_NUMBER_MAXLEN - 1] = '\0';
+    }
+
+    // The records are read concurrently, the results arrive in any order.
+    Directory_search_batch(server->directory, phone_numbers, count, store_search_result, records);
+
+    for (int i = 0; i < count; i++) {
+        append_search_response(records[i], response);
+    }
+
+    free(phone_numbers);
+    free(records);
+}
+
+/**
+ * @brief Executes a complete request other than BATCH and appends its response.
+ *
+ * @param server The server.
+ * @param request The request, starting with its opcode.
+ * @param response The response is appended to this array.
+ */
+static void execute_simple_request(Server *server, uint8_t *request, ByteArray *response) {
+    char phone_number[PHONE_NUMBER_MAXLEN];
+    phone_number[PHONE_NUMBER_MAXLEN - 1] = '\0';
+    ByteArray record_bytes = {request + 1, DirectoryRecord_size_on_disk()};
+    DirectoryRecord *record;
+    bool is_ok;
+
+    switch (request[0]) {
+        case SERVER_OPCODE_SEARCH:
+            memcpy(phone_number, request + 1, PHONE_NUMBER_MAXLEN_WITHOUT_NULL_CHARACTER);
+            append_search_response(Directory_search(server->directory, phone_number), response);
+            return;
+        case SERVER_OPCODE_APPEND:
+        case SERVER_OPCODE_UPDATE:
+            // A record is only deleted with DELETE.
+            if (request[1] != (uint8_t) false) {
+                ByteArray_append(response, SERVER_STATUS_BAD_REQUEST);
+                return;
+            }
+
+            record = ByteArray_to_DirectoryRecord(&record_bytes);
+
+            if (request[0] == SERVER_OPCODE_APPEND) {
+                is_ok = Directory_append(server->directory, record);
+            } else {
+                is_ok = Directory_update(server->directory, record);
+            }
+
+            DirectoryRecord_destroy(&record);
+            ByteArray_append(response, is_ok ? SERVER_STATUS_OK : SERVER_STATUS_FAILURE);
+            return;
+        case SERVER_OPCODE_DELETE:
+            memcpy(phone_number, request + 1, PHONE_NUMBER_MAXLEN_WITHOUT_NULL_CHARACTER);
+            is_ok = Directory_delete(server->directory, phone_number);
+            ByteArray_append(response, is_ok ? SERVER_STATUS_OK : SERVER_STATUS_FAILURE);
+            return;
+    }
+}
+
+/**
+ * @brief Executes a complete request and adds its response to those waiting to be sent.
+ *
+ * @param server The server.
+ * @param connection The connection.
+ * @param request The request, checked by get_request_size.
+ */
+static void serve_request(Server *server, Connection *connection, uint8_t *request) {
+    ByteArray *response;
+
+    if (request[0] == SERVER_OPCODE_BATCH) {
+        int count = (int)request[1] << 8 | (int)request[2];
+        response = ByteArray_init(2 + count * (1 + DirectoryRecord_size_on_disk()));
+        ByteArray_append(response, request[1]);
+        ByteArray_append(response, request[2]);
+        uint8_t *sub_request = request + 3;
+        // The consecutive searches are executed together, a modification is executed once the searches before it
+        // are done so that the responses are those of the requests executed in order.
+        uint8_t *first_search = NULL;
+        int search_count = 0;
+
+        for (int i = 0; i < count; i++) {
+            if (sub_request[0] == SERVER_OPCODE_SEARCH) {
+                first_search = search_count == 0 ? sub_request : first_search;
+                search_count++;
+            } else {
+                execute_searches(server, first_search, search_count, response);
+                search_count = 0;
+                execute_simple_request(server, sub_request, response);
+            }
+
+            sub_request += get_simple_request_size(sub_request[0]);
+        }
+
+        execute_searches(server, first_search, search_count, response);
+    } else {
+        response = ByteArray_init(1 + DirectoryRecord_size_on_disk());
+        execute_simple_request(server, request, response);
+    }
+
+    append_output(connection, response->items, response->size);
+    ByteArray_destroy(&response);
+}
+
+/**
+ * @brief Sends the waiting responses of a connection, then reads the bytes available and serves the requests that are
+ * complete. A request received in several parts is kept in the input buffer of the connection until its last part
+ * arrives, and the responses that the client does not read yet are kept in its output buffer, so a worker never waits
+ * for a client.
+ *
+ * @param server The server.
+ * @param connection The connection.
+ * @param events The events of the connection.
+ * @return true The connection can be kept.
+ * @return false The connection must be closed.
+ */
+static bool serve_connection(Server *server, Connection *connection, uint32_t events) {
+    if (!flush_output(connection)) {
+        return false;
+    }
+
+    if ((events & EPOLLIN) != 0 && get_pending_output_size(connection) < SERVER_OUTPUT_LIMIT) {
+        if (connection->input_capacity - connection->input_size < SERVER_READ_SIZE) {
+            connection->input_capacity = 2 * connection->input_capacity + SERVER_READ_SIZE;
+            connection->input = (uint8_t *)realloc(connection->input, connection->input_capacity);
+        }
+
+        ssize_t n = read(connection->fd, connection->input + connection->input_size, connection->input_capacity - connection->input_size);
+
+        if (n == 0) {
+            return false;
+        }
+
+        // Nothing to read yet: EAGAIN, EWOULDBLOCK or EINTR.
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            return false;
+        }
+
+        connection->input_size += n > 0 ? n : 0;
+    }
+
+    // The requests received while the output was full are served once the client has read enough of it.
+    int offset = 0;
+    int request_size = 0;
+
+    while (get_pending_output_size(connection) < SERVER_OUTPUT_LIMIT && (request_size = get_request_size(connection->input + offset, connection->input_size - offset)) > 0) {
+        serve_request(server, connection, connection->input + offset);
+        offset += request_size;
+    }
+
+    if (request_size < 0) {
+        // The rest of the stream cannot be interpreted, the client is told and disconnected.
+        uint8_t status = SERVER_STATUS_BAD_REQUEST;
+        append_output(connection, &status, 1);
+        flush_output(connection);
+        return false;
+    }
+
+    // The beginning of the next request is moved to the start of the buffer.
+    memmove(connection->input, connection->input + offset, connection->input_size - offset);
+    connection->input_size -= offset;
+    return flush_output(connection);
+}
+
+/**
+ * @brief Gets the events to wait for on a connection: the socket becoming writable while responses are waiting, and
+ * new bytes as long as the responses waiting do not exceed their limit.
+ *
+ * @param connection The connection.
+ * @return uint32_t The events.
+ */
+static uint32_t get_connection_events(Connection *connection) {
+    uint32_t events = EPOLLONESHOT;
+
+    if (get_pending_output_size(connection) > 0) {
+        events |= EPOLLOUT;
+    }
+
+    if (get_pending_output_size(connection) < SERVER_OUTPUT_LIMIT) {
+        events |= EPOLLIN;
+    }
+
+    return events;
+}
+
+/**
+ * @brief Closes a connection and forgets it.
+ *
+ * @param server The server.
+ * @param connection The connection.
+ */
+static void close_connection(Server *server, Connection *connection) {
+    pthread_mutex_lock(&server->connections_mutex);
+    if (connection->previous != NULL) {
+        connection->previous->next = connection->next;
+    } else {
+        server->connections = connection->next;
+    }
+    if (connection->next != NULL) {
+        connection->next->previous = connection->previous;
+    }
+    pthread_mutex_unlock(&server->connections_mutex);
+
+    // Closing the file descriptor also removes it from the epoll instance.
+    close(connection->fd);
+    free(connection->input);
+    free(connection->output);
+    free(connection);
+}
+
+/**
+ * @brief Accepts the pending connections and registers them in the event loop.
+ *
+ * @param server The server.
+ */
+static void accept_connections(Server *server) {
+    while (true) {
+        int fd = accept4(server->listen_fd, NULL, NULL, SOCK_NONBLOCK);
+
+        if (fd < 0) {
+            // EAGAIN: no more pending connection, another worker may also have taken it.
+            return;
+        }
+
+        Connection *connection = (Connection *)malloc(sizeof(Connection));
+        connection->fd = fd;
+        connection->input = NULL;
+        connection->input_size = 0;
+        connection->input_capacity = 0;
+        connection->output = NULL;
+        connection->output_offset = 0;
+        connection->output_size = 0;
+        connection->output_capacity = 0;
+        connection->previous = NULL;
+
+        pthread_mutex_lock(&server->connections_mutex);
+        connection->next = server->connections;
+        if (server->connections != NULL) {
+            server->connections->previous = connection;
+        }
+        server->connections = connection;
+        pthread_mutex_unlock(&server->connections_mutex);
+
+        // A connection is handled by a single worker at a time, it is rearmed once its bytes have been read or its
+        // responses sent.
+        struct epoll_event event;
+        event.events = EPOLLIN | EPOLLONESHOT;
+        event.data.ptr = connection;
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+/**
+ * @brief Event loop of a worker, all the workers wait on the same epoll instance.
+ *
+ * @param arg The server.
+ * @return void* Always NULL.
+ */
+static void *worker(void *arg) {
+    Server *server = (Server *)arg;
+
+    while (!is_stop_requested) {
+        struct epoll_event event;
+        int n = epoll_wait(server->epoll_fd, &event, 1, EPOLL_TIMEOUT_MS);
+
+        if (n <= 0) {
+            continue;
+        }
+
+        Connection *connection = (Connection *)event.data.ptr;
+
+        if (connection == NULL) {
+            // The listening socket is the only one registered without a connection.
+            accept_connections(server);
+        } else if ((event.events & (EPOLLHUP | EPOLLERR)) == 0 && serve_connection(server, connection, event.events)) {
+            event.events = get_connection_events(connection);
+            epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, connection->fd, &event);
+        } else {
+            close_connection(server, connection);
+        }
+    }
+
+    return NULL;
+}
+
+bool Server_run(Directory *directory, char *socket_path, int worker_count) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (strlen(socket_path) >= sizeof(address.sun_path)) {
+        return false;
+    }
+
+    strcpy(address.sun_path, socket_path);
+    unlink(socket_path);
+
+    Server server;
+    server.directory = directory;
+    server.connections = NULL;
+    pthread_mutex_init(&server.connections_mutex, NULL);
+    server.listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+
+    if (server.listen_fd < 0) {
+        pthread_mutex_destroy(&server.connections_mutex);
+        return false;
+    }
+
+    if (bind(server.listen_fd, (struct sockaddr *)&address, sizeof(address)) < 0 || listen(server.listen_fd, LISTEN_BACKLOG) < 0) {
+        close(server.listen_fd);
+        pthread_mutex_destroy(&server.connections_mutex);
+        return false;
+    }
+
+    server.epoll_fd = epoll_create1(0);
+
+    struct epoll_event event;
+    // Only one worker is woken up for a new connection.
+    event.events = EPOLLIN | EPOLLEXCLUSIVE;
+    event.data.ptr = NULL;
+    epoll_ctl(server.epoll_fd, EPOLL_CTL_ADD, server.listen_fd, &event);
+
+    is_stop_requested = 0;
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_stop_signal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    is_save_requested = 0;
+    action.sa_handler = handle_save_signal;
+    sigaction(SIGUSR1, &action, NULL);
+    is_latency_dump_requested = 0;
+    action.sa_handler = handle_latency_dump_signal;
+    sigaction(SIGUSR2, &action, NULL);
+
+    pthread_t *workers = (pthread_t *)malloc(sizeof(pthread_t) * worker_count);
+    for (int i = 0; i < worker_count; i++) {
+        pthread_create(&workers[i], NULL, worker, &server);
+    }
+
+    // The snapshots are started by the main thread, the workers keep serving while the index is saved.
+    while (!is_stop_requested) {
+        if (is_save_requested) {
+            is_save_requested = 0;
+            Directory_save_index(directory);
+        }
+
+        // The latencies are not written by the handler itself, fprintf is not safe in a signal handler.
+        if (is_latency_dump_requested) {
+            is_latency_dump_requested = 0;
+            Directory_print_latencies(stderr);
+        }
+
+        // The process that saves the snapshot is collected once it has exited.
+        Directory_is_saving_index(directory);
+        usleep(EPOLL_TIMEOUT_MS * 1000);
+    }
+
+    for (int i = 0; i < worker_count; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    free(workers);
+
+    // The workers have stopped, the connections still open are closed.
+    while (server.connections != NULL) {
+        close_connection(&server, server.connections);
+    }
+
+    pthread_mutex_destroy(&server.connections_mutex);
+    close(server.epoll_fd);
+    close(server.listen_fd);
+    unlink(socket_path);
+    return true;
+}
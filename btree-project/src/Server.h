@@ -0,0 +1,44 @@
+/**
+ * @file Server.h
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "Directory.h"
+
+#define SERVER_DEFAULT_WORKER_COUNT 4
+
+// Binary protocol, every request starts with an opcode byte and every response with a status byte.
+//   SEARCH : phone number (10 bytes)      -> status, followed by the record as stored on disk if status is SERVER_STATUS_OK
+//   APPEND : record as stored on disk     -> status, SERVER_STATUS_BAD_REQUEST if its deletion flag is set
+//   UPDATE : record as stored on disk     -> status, SERVER_STATUS_BAD_REQUEST if its deletion flag is set
+//   DELETE : phone number (10 bytes)      -> status
+//   BATCH  : count (2 bytes, big-endian) followed by count requests other than BATCH
+//            -> count (2 bytes, big-endian) followed by the count responses in the same order
+#define SERVER_OPCODE_SEARCH 1
+#define SERVER_OPCODE_APPEND 2
+#define SERVER_OPCODE_UPDATE 3
+#define SERVER_OPCODE_DELETE 4
+#define SERVER_OPCODE_BATCH 5
+
+#define SERVER_STATUS_FAILURE 0
+#define SERVER_STATUS_OK 1
+#define SERVER_STATUS_BAD_REQUEST 2
+
+/**
+ * @brief Serves the directory on a Unix domain socket until SIGINT or SIGTERM is received. A snapshot of the index is
+ * saved in the background when SIGUSR1 is received, and the latencies of the operations are written to the standard
+ * error when SIGUSR2 is received.
+ *
+ * @param directory The directory shared by all the connections.
+ * @param socket_path The path of the socket.
+ * @param worker_count The number of threads that process the requests.
+ * @return true The server has been stopped normally.
+ * @return false The socket could not be created.
+ */
+bool Server_run(Directory *directory, char *socket_path, int worker_count);
+
+#endif
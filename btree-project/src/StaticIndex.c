@@ -0,0 +1,104 @@
+/**
+ * @file StaticIndex.c
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#include "StaticIndex.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "BPTree.h"
+
+#define CACHE_LINE_SIZE 64
+
+/**
+ * @brief Places the sorted keys in the Eytzinger layout with an in-order traversal of the implicit tree.
+ *
+ * @param index The index being built.
+ * @param sorted_keys The keys in ascending order.
+ * @param sorted_data The data in the order of the keys.
+ * @param i The index of the next sorted key to place.
+ * @param k The position in the implicit tree.
+ * @return int The index of the next sorted key to place.
+ */
+static int eytzinger(StaticIndex *index, uint64_t *sorted_keys, uint64_t *sorted_data, int i, int k) {
+    if (k <= index->size) {
+        i = eytzinger(index, sorted_keys, sorted_data, i, 2 * k);
+        index->keys[k] = sorted_keys[i];
+        index->data[k] = sorted_data[i];
+        i++;
+        i = eytzinger(index, sorted_keys, sorted_data, i, 2 * k + 1);
+    }
+
+    return i;
+}
+
+StaticIndex *StaticIndex_init(BPTreeNode *root) {
+    int size = 0;
+
+    for (BPTreeNode *leaf = BPTree_find_first_leaf(root); leaf != NULL; leaf = leaf->next) {
+        size += leaf->keys->size;
+    }
+
+    // The leaf nodes are chained in ascending order, which gives the sorted keys.
+    uint64_t *sorted_keys = (uint64_t *)malloc(sizeof(uint64_t) * (size + 1));
+    uint64_t *sorted_data = (uint64_t *)malloc(sizeof(uint64_t) * (size + 1));
+    int i = 0;
+
+    for (BPTreeNode *leaf = BPTree_find_first_leaf(root); leaf != NULL; leaf = leaf->next) {
+        for (int j = 0; j < leaf->keys->size; j++) {
+            sorted_keys[i] = leaf->keys->items[j];
+            sorted_data[i] = leaf->data->items[j];
+            i++;
+        }
+    }
+
+    StaticIndex *index = StaticIndex_init_sorted(sorted_keys, sorted_data, size);
+    free(sorted_keys);
+    free(sorted_data);
+    return index;
+}
+
+StaticIndex *StaticIndex_init_sorted(uint64_t *sorted_keys, uint64_t *sorted_data, int size) {
+    StaticIndex *index = (StaticIndex *)malloc(sizeof(StaticIndex));
+    index->size = size;
+
+    // Index 0 is not used, the array is aligned so that the 8 keys of each level k * 8 ... k * 8 + 7 share a cache line.
+    size_t keys_size = sizeof(uint64_t) * (index->size + 1);
+    keys_size = (keys_size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    index->keys = (uint64_t *)aligned_alloc(CACHE_LINE_SIZE, keys_size);
+    index->data = (uint64_t *)malloc(sizeof(uint64_t) * (index->size + 1));
+    eytzinger(index, sorted_keys, sorted_data, 0, 1);
+    return index;
+}
+
+void StaticIndex_destroy(StaticIndex **index) {
+    free((*index)->keys);
+    free((*index)->data);
+    free(*index);
+    *index = NULL;
+}
+
+bool StaticIndex_search(StaticIndex *index, uint64_t key, uint64_t *data) {
+    int k = 1;
+
+    while (k <= index->size) {
+        // Prefetches the cache line of the descendants 3 levels below, they are read 3 iterations later.
+        __builtin_prefetch(index->keys + 8 * k);
+        // Branchless descent: goes to the right child if the key is greater.
+        k = 2 * k + (index->keys[k] < key);
+    }
+
+    // Goes back up the right turns taken after the last left turn, k is then the lower bound of the key.
+    k >>= __builtin_ffs(~k);
+
+    if (k == 0 || index->keys[k] != key) {
+        return false;
+    }
+
+    *data = index->data[k];
+    return true;
+}
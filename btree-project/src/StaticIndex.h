@@ -0,0 +1,62 @@
+/**
+ * @file StaticIndex.h
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#ifndef STATIC_INDEX_H
+#define STATIC_INDEX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "BPTree.h"
+
+/**
+ * @brief Data structure that represents a read-only index. The keys of a B+ Tree are stored in a single array
+ * using the Eytzinger layout (the layout of a binary heap), the children of the key at index k are at 2k and 2k + 1.
+ *
+ */
+typedef struct StaticIndex {
+    uint64_t *keys;
+    uint64_t *data;
+    int size;
+} StaticIndex;
+
+/**
+ * @brief Initializes a "StaticIndex" with the keys and data of a B+ Tree.
+ *
+ * @param root The root of the B+ Tree, it is not modified.
+ * @return StaticIndex* The read-only index.
+ */
+StaticIndex *StaticIndex_init(BPTreeNode *root);
+
+/**
+ * @brief Initializes a "StaticIndex" with keys that are already sorted.
+ *
+ * @param sorted_keys The keys in ascending order, without duplicates. The array is not modified.
+ * @param sorted_data The data in the order of the keys. The array is not modified.
+ * @param size The number of keys.
+ * @return StaticIndex* The read-only index.
+ */
+StaticIndex *StaticIndex_init_sorted(uint64_t *sorted_keys, uint64_t *sorted_data, int size);
+
+/**
+ * @brief Destroys the index and free its memory.
+ *
+ * @param index The index to be destroyed.
+ */
+void StaticIndex_destroy(StaticIndex **index);
+
+/**
+ * @brief Searches for a key in the index.
+ *
+ * @param index The index in which to search.
+ * @param key The key to search.
+ * @param data The data found will be assigned to this variable.
+ * @return true The key exists in the index.
+ * @return false The key does not exist in the index.
+ */
+bool StaticIndex_search(StaticIndex *index, uint64_t key, uint64_t *data);
+
+#endif
@@ -4,11 +4,18 @@
  * @version 1.0
  * @date 2022-06-17
  */
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "BPTree.h"
 #include "Directory.h"
 #include "DirectoryRecord.h"
+#include "DirectoryStats.h"
+#include "Server.h"
+
+#define DATABASE_FILENAME "directory_database"
 
 /**
  * @brief Empties the buffer.
@@ -137,29 +144,126 @@ void delete_record(Directory *directory) {
     }
 }
 
-int main() {
-    Directory *directory = Directory_init("directory_database");
+/**
+ * @brief Procedure for updating a record of the database.
+ *
+ * @param directory The directory.
+ */
+void update_record(Directory *directory) {
+    printf("Enter the phone number that corresponds to the record you wish to update: ");
+
+    char phone_number[PHONE_NUMBER_MAXLEN];
+    scanf("%10s", phone_number);
+    clear_buffer();
+    DirectoryRecord *record = Directory_search(directory, phone_number);
+    printf("\n");
+
+    if (record == NULL) {
+        printf("===>No records were found for this phone number.\n");
+        return;
+    }
+
+    printf("========================\n");
+    DirectoryRecord_print(record);
+    DirectoryRecord_destroy(&record);
+    printf("========================\n\n");
+
+    // Reads the user entry for the name.
+    char name[NAME_MAXLEN];
+    printf("Enter the new name: ");
+    scanf("%20s", name);
+    clear_buffer();
+
+    // Reads the user entry for the surname.
+    char surname[SURNAME_MAXLEN];
+    printf("Enter the new surname: ");
+    scanf("%20s", surname);
+    clear_buffer();
+
+    // Loop until three integers are given.
+    int birth_date_year, birth_date_month, birth_date_day;
+    do {
+        printf("Enter the new birth date (Y-m-d): ");
+    } while (scanf("%d-%d-%d", &birth_date_year, &birth_date_month, &birth_date_day) != 3);
+
+    clear_buffer();
+    printf("\nIs the information entered correct? (Y/n) ");
+
+    char choice = getchar();
+    if (choice != '\n') {
+        getchar();
+    }
+
+    if (choice == 'n') {
+        // The user has cancelled the procedure.
+        printf("\n===>The procedure has been cancelled.\n");
+        return;
+    }
+
+    record = DirectoryRecord_init(false, phone_number, name, surname, birth_date_year, birth_date_month, birth_date_day);
+    Directory_update(directory, record);
+    DirectoryRecord_destroy(&record);
+    printf("\n===>The record has been updated.\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc >= 3 && strcmp(argv[1], "--server") == 0) {
+        // Usage: ./program --server <socket path> [worker count] [shard count] [bptree|bptree-huge|hash|radix]
+        int worker_count = argc >= 4 ? atoi(argv[3]) : SERVER_DEFAULT_WORKER_COUNT;
+        int shard_count = argc >= 5 ? atoi(argv[4]) : 0;
+        const DirectoryIndexBackend *backend = argc >= 6 ? DirectoryIndexBackend_find(argv[5]) : &DIRECTORY_INDEX_BPTREE;
+
+        if (backend == NULL) {
+            fprintf(stderr, "Unknown index: %s\n", argv[5]);
+            return EXIT_FAILURE;
+        }
+
+        char filename[FILENAME_MAXLEN] = DATABASE_FILENAME;
+        Directory *directory = Directory_init_with_index(filename, shard_count > 0 ? shard_count : 0, backend);
+
+        Directory_enable_filter(directory);
+        Directory_enable_cache(directory, DEFAULT_CACHE_CAPACITY);
+        bool is_ok = Server_run(directory, argv[2], worker_count > 0 ? worker_count : SERVER_DEFAULT_WORKER_COUNT);
+
+        // The index is saved before leaving, so that the next start does not have to read the database.
+        if (is_ok && Directory_save_index(directory)) {
+            Directory_wait_index_save(directory);
+        }
+
+        uint64_t hit_count, miss_count;
+        Directory_get_cache_counters(directory, &hit_count, &miss_count);
+        fprintf(stderr, "Record cache: %" PRIu64 " hits, %" PRIu64 " misses.\n", hit_count, miss_count);
+        Directory_print_latencies(stderr);
+        Directory_destroy(&directory);
+        return is_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    char filename[FILENAME_MAXLEN] = DATABASE_FILENAME;
+    Directory *directory = Directory_init(filename);
+    Directory_enable_filter(directory);
 
     while (true) {
-        BPTree_print(directory->index, 0);
+        // The directory of the interactive mode is indexed by a B+ Tree.
+        BPTree_print((BPTreeNode *)directory->index->impl, 0);
 
         printf("Enter 1 to add a member.\n");
         printf("Enter 2 to search for a member via their phone number.\n");
         printf("Enter 3 to delete a member.\n");
-        printf("Enter 4 to display all members.\n");
-        printf("Enter 5 to exit the program.\n");
+        printf("Enter 4 to update a member.\n");
+        printf("Enter 5 to display all members.\n");
+        printf("Enter 6 to exit the program.\n");
         printf("What do you want to do? ");
         int action;
         scanf("%d", &action);
         clear_buffer();
 
-        if (action < 1 || action > 5) {
+        if (action < 1 || action > 6) {
             // The action is invalid.
             system("clear");
             continue;
         }
 
-        if (action == 5) {
+        if (action == 6) {
             // The program is exited.
             break;
         }
@@ -177,6 +281,9 @@ int main() {
                 delete_record(directory);
                 break;
             case 4:
+                update_record(directory);
+                break;
+            case 5:
                 Directory_print(directory);
                 break;
         }
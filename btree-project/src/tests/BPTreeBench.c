@@ -0,0 +1,266 @@
+/**
+ * @file BPTreeBench.c
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ *
+ * Benchmark of the memory of the nodes of the B+ tree: the same keys are inserted in a B+ tree whose nodes are on the
+ * heap, then in B+ trees whose nodes are in an arena of each kind of pages. The keys are then searched in random order
+ * and the program reports the time of a search, the data TLB misses counted by the processor and how much of the
+ * memory of the process is in huge pages. The same searches are finally made in the static index that freezes the B+
+ * tree whose nodes are on the heap.
+ *   ./bench_exec [number of keys] [number of searches] [order]
+ */
+#include <linux/perf_event.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../BPTree.h"
+#include "../NodeArena.h"
+#include "../StaticIndex.h"
+
+#define DEFAULT_KEY_COUNT 4000000
+#define DEFAULT_SEARCH_COUNT 4000000
+#define DEFAULT_ORDER 16
+
+/**
+ * @brief Data structure that represents the memory of the nodes of a tree being measured.
+ *
+ */
+typedef struct BenchConfiguration {
+    const char *name;
+    // false = the nodes are on the heap.
+    bool is_in_arena;
+    NodeArenaPages pages;
+} BenchConfiguration;
+
+/**
+ * @brief Generates random 64-bit keys.
+ *
+ * @param count The number of keys.
+ * @return uint64_t* The keys.
+ */
+static uint64_t *generate_random_keys(int count) {
+    uint64_t *keys = (uint64_t *)malloc(sizeof(uint64_t) * count);
+
+    for (int i = 0; i < count; i++) {
+        keys[i] = ((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ (uint64_t)rand();
+    }
+
+    return keys;
+}
+
+/**
+ * @brief Opens the counter of the data TLB misses of the loads of the calling thread.
+ *
+ * @return int The file descriptor of the counter, -1 if the processor or the kernel does not provide it.
+ */
+static int open_tlb_miss_counter() {
+    struct perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.type = PERF_TYPE_HW_CACHE;
+    attributes.size = sizeof(attributes);
+    attributes.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attributes.disabled = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    return (int)syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0);
+}
+
+/**
+ * @brief Reads how much memory of the process is in huge pages, transparent and explicit.
+ *
+ * @return long The memory in huge pages in KiB, -1 if it is not known.
+ */
+static long read_huge_page_memory() {
+    FILE *fp = fopen("/proc/self/smaps_rollup", "r");
+
+    if (fp == NULL) {
+        return -1;
+    }
+
+    char line[256];
+    long total = 0;
+
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        long size;
+
+        if (sscanf(line, "AnonHugePages: %ld kB", &size) == 1 || sscanf(line, "Private_Hugetlb: %ld kB", &size) == 1) {
+            total += size;
+        }
+    }
+
+    fclose(fp);
+    return total;
+}
+
+/**
+ * @brief Gets the current time in seconds.
+ *
+ * @return double The time.
+ */
+static double get_time() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Function that searches for a key in the index being measured.
+ *
+ * @param index The index.
+ * @param key The key.
+ * @param data The data found will be assigned to this variable.
+ * @return true The key has been found.
+ * @return false The key has not been found.
+ */
+typedef bool (*BenchSearch)(void *index, uint64_t key, uint64_t *data);
+
+/**
+ * @brief Searches for a key in a B+ tree.
+ *
+ * @param index The root of the B+ tree.
+ * @param key The key.
+ * @param data The data found will be assigned to this variable.
+ * @return true The key has been found.
+ * @return false The key has not been found.
+ */
+static bool search_tree(void *index, uint64_t key, uint64_t *data) {
+    return BPTree_search((BPTreeNode *)index, key, data);
+}
+
+/**
+ * @brief Searches for a key in a static index.
+ *
+ * @param index The static index.
+ * @param key The key.
+ * @param data The data found will be assigned to this variable.
+ * @return true The key has been found.
+ * @return false The key has not been found.
+ */
+static bool search_static_index(void *index, uint64_t key, uint64_t *data) {
+    return StaticIndex_search((StaticIndex *)index, key, data);
+}
+
+/**
+ * @brief Searches for keys in random order and displays the measurements.
+ *
+ * @param name The name of the index.
+ * @param pages The kind of pages of the index.
+ * @param search The function that searches in the index.
+ * @param index The index.
+ * @param keys The keys.
+ * @param search_order The positions of the keys to search, in the order of the searches.
+ * @param search_count The number of searches.
+ * @return bool true = every key has been found.
+ */
+static bool measure_searches(const char *name, const char *pages, BenchSearch search, void *index, uint64_t *keys, int *search_order, int search_count) {
+    int counter_fd = open_tlb_miss_counter();
+    if (counter_fd >= 0) {
+        ioctl(counter_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    double start = get_time();
+    int found_count = 0;
+
+    for (int i = 0; i < search_count; i++) {
+        uint64_t data;
+        found_count += search(index, keys[search_order[i]], &data);
+    }
+
+    double elapsed = get_time() - start;
+    uint64_t miss_count = 0;
+
+    if (counter_fd >= 0) {
+        ioctl(counter_fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(counter_fd, &miss_count, sizeof(miss_count)) != sizeof(miss_count)) {
+            miss_count = 0;
+        }
+        close(counter_fd);
+    }
+
+    printf("%-22s : %6.1f ns/search, ", name, elapsed * 1e9 / search_count);
+    if (counter_fd >= 0) {
+        printf("%5.2f dTLB misses/search, ", (double)miss_count / search_count);
+    } else {
+        printf("dTLB misses not available, ");
+    }
+    printf("%ld MiB in huge pages, %s\n", read_huge_page_memory() / 1024, pages);
+
+    return found_count == search_count;
+}
+
+/**
+ * @brief Builds a tree, searches its keys in random order and displays the measurements. The static index of the tree
+ * is measured too if its nodes are on the heap.
+ *
+ * @param configuration The memory of the nodes.
+ * @param order The order of the tree.
+ * @param keys The keys.
+ * @param key_count The number of keys.
+ * @param search_order The positions of the keys to search, in the order of the searches.
+ * @param search_count The number of searches.
+ * @return bool true = every key has been found.
+ */
+static bool run_configuration(BenchConfiguration *configuration, int order, uint64_t *keys, int key_count, int *search_order, int search_count) {
+    BPTreeNode *root = configuration->is_in_arena ? BPTree_init_in_arena(order, configuration->pages) : BPTree_init(order);
+
+    for (int i = 0; i < key_count; i++) {
+        BPTree_insert(root, keys[i], i);
+    }
+
+    const char *pages = configuration->is_in_arena ? NodeArenaPages_name(root->arena->pages) : "small pages";
+    bool is_ok = measure_searches(configuration->name, pages, search_tree, root, keys, search_order, search_count);
+
+    if (!configuration->is_in_arena) {
+        StaticIndex *index = StaticIndex_init(root);
+        is_ok &= measure_searches("static index", "small pages", search_static_index, index, keys, search_order, search_count);
+        StaticIndex_destroy(&index);
+    }
+
+    BPTree_destroy(&root);
+    return is_ok;
+}
+
+int main(int argc, char *argv[]) {
+    BenchConfiguration configurations[] = {
+        {"heap", false, NODE_ARENA_SMALL_PAGES},
+        {"arena, small pages", true, NODE_ARENA_SMALL_PAGES},
+        {"arena, transparent", true, NODE_ARENA_TRANSPARENT_HUGE_PAGES},
+        {"arena, explicit", true, NODE_ARENA_EXPLICIT_HUGE_PAGES},
+    };
+    int key_count = argc > 1 ? atoi(argv[1]) : DEFAULT_KEY_COUNT;
+    int search_count = argc > 2 ? atoi(argv[2]) : DEFAULT_SEARCH_COUNT;
+    int order = argc > 3 ? atoi(argv[3]) : DEFAULT_ORDER;
+
+    if (key_count <= 0 || search_count <= 0 || order <= 0) {
+        fprintf(stderr, "Usage: %s [number of keys] [number of searches] [order]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    srand(0);
+    uint64_t *keys = generate_random_keys(key_count);
+    int *search_order = (int *)malloc(sizeof(int) * search_count);
+    for (int i = 0; i < search_count; i++) {
+        search_order[i] = rand() % key_count;
+    }
+
+    printf("%d keys, %d searches, order %d\n", key_count, search_count, order);
+    bool is_ok = true;
+
+    for (int i = 0; i < (int)(sizeof(configurations) / sizeof(configurations[0])); i++) {
+        is_ok &= run_configuration(&configurations[i], order, keys, key_count, search_order, search_count);
+    }
+
+    free(search_order);
+    free(keys);
+    return is_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
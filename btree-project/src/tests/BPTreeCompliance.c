@@ -0,0 +1,235 @@
+/**
+ * @file BPTreeCompliance.c
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#include "BPTreeCompliance.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "../Array.h"
+#include "../BPTree.h"
+
+/**
+ * @brief Finds the leftmost leaf node.
+ *
+ * @param root The root node.
+ * @return BPTreeNode* The leftmost leaf node.
+ */
+static BPTreeNode *find_first_leaf(BPTreeNode *root) {
+    if (root->is_leaf) {
+        return root;
+    }
+
+    return find_first_leaf(root->children->items[0]);
+}
+
+static bool check_if_the_leaf_nodes_are_correctly_chained(BPTreeNode *root) {
+    BPTreeNode *current = find_first_leaf(root);
+
+    while (current->next != NULL) {
+        if (current->keys->items[current->keys->size - 1] >= current->next->keys->items[0]) {
+            return false;
+        }
+
+        current = current->next;
+    }
+
+    return true;
+}
+
+static bool check_if_all_leaf_nodes_nodes_have_no_children(BPTreeNode *root) {
+    if (root->is_leaf) {
+        return root->children->size == 0;
+    }
+
+    for (int i = 0; i < root->children->size; i++) {
+        if (!check_if_all_leaf_nodes_nodes_have_no_children(root->children->items[i])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool check_if_all_leaf_nodes_have_as_many_keys_as_data(BPTreeNode *root) {
+    if (root->is_leaf) {
+        return root->keys->size == root->data->size;
+    }
+
+    for (int i = 0; i < root->children->size; i++) {
+        if (!check_if_all_leaf_nodes_have_as_many_keys_as_data(root->children->items[i])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int compute_first_leaf_depth(BPTreeNode *root) {
+    if (root->is_leaf) {
+        return 0;
+    }
+
+    return compute_first_leaf_depth(root->children->items[0]) + 1;
+}
+
+static bool check_if_all_leaf_nodes_are_at_the_same_depth(BPTreeNode *root, int expected_depth, int depth) {
+    if (root->is_leaf) {
+        return depth == expected_depth;
+    }
+
+    for (int i = 0; i < root->children->size; i++) {
+        if (!check_if_all_leaf_nodes_are_at_the_same_depth(root->children->items[i], expected_depth, depth + 1)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool check_if_all_internal_nodes_have_no_data(BPTreeNode *root) {
+    if (root->is_leaf) {
+        return true;
+    }
+
+    for (int i = 0; i < root->children->size; i++) {
+        if (!check_if_all_internal_nodes_have_no_data(root->children->items[i])) {
+            return false;
+        }
+    }
+
+    return root->data->size == 0;
+}
+
+static bool check_if_all_internal_nodes_have_always_1_child_more_than_the_number_of_keys(BPTreeNode *root) {
+    if (root->is_leaf) {
+        return true;
+    }
+
+    for (int i = 0; i < root->children->size; i++) {
+        if (!check_if_all_internal_nodes_have_always_1_child_more_than_the_number_of_keys(root->children->items[i])) {
+            return false;
+        }
+    }
+
+    return root->children->size == root->keys->size + 1;
+}
+
+static bool check_if_the_array_is_sorted(IntegerArray *array) {
+    for (int i = 0; i < array->size - 1; i++) {
+        if (array->items[i] > array->items[i + 1]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool check_if_all_nodes_have_their_keys_sorted(BPTreeNode *root) {
+    for (int i = 0; i < root->children->size; i++) {
+        if (!check_if_all_nodes_have_their_keys_sorted(root->children->items[i])) {
+            return false;
+        }
+    }
+
+    return check_if_the_array_is_sorted(root->keys);
+}
+
+static bool check_if_all_nodes_have_no_more_keys_than_the_maximum_allowed(BPTreeNode *root) {
+    for (int i = 0; i < root->children->size; i++) {
+        if (!check_if_all_nodes_have_no_more_keys_than_the_maximum_allowed(root->children->items[i])) {
+            return false;
+        }
+    }
+
+    return root->keys->size <= 2 * root->order;
+}
+
+static bool check_if_all_nodes_except_the_root_node_have_not_less_keys_than_the_minimum_required(BPTreeNode *root, BPTreeNode *parent, bool is_last_node) {
+    for (int i = 0; i < root->children->size; i++) {
+        if (!check_if_all_nodes_except_the_root_node_have_not_less_keys_than_the_minimum_required(root->children->items[i], root, is_last_node && i == root->children->size - 1)) {
+            return false;
+        }
+    }
+
+    if (parent == NULL) {
+        return true;
+    }
+
+    if (is_last_node) {
+        // The keys inserted in ascending order are appended to the last node of each level, which keeps at least one key.
+        return root->keys->size >= 1;
+    }
+
+    return root->keys->size >= root->order;
+}
+
+static bool check_if_the_keys_have_been_correctly_inserted_within_range(BPTreeNode *root, uint64_t left, uint64_t right) {
+    for (int i = 0; i < root->keys->size; i++) {
+        if (root->keys->items[i] < left || root->keys->items[i] >= right) {
+            return false;
+        }
+    }
+
+    for (int i = 0; i < root->children->size; i++) {
+        if (!check_if_the_keys_have_been_correctly_inserted_within_range(root->children->items[i], left, right)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool check_if_the_keys_have_been_correctly_inserted(BPTreeNode *root) {
+    if (root->is_leaf) {
+        return true;
+    }
+
+    for (int i = 0; i < root->children->size; i++) {
+        if (i == 0) {
+            if (!check_if_the_keys_have_been_correctly_inserted_within_range(root->children->items[i], 0, root->keys->items[i])) {
+                return false;
+            }
+        } else if (i == root->children->size - 1) {
+            if (!check_if_the_keys_have_been_correctly_inserted_within_range(root->children->items[i], root->keys->items[i - 1], 18446744073709551615LLU)) {
+                return false;
+            }
+        } else {
+            if (!check_if_the_keys_have_been_correctly_inserted_within_range(root->children->items[i], root->keys->items[i - 1], root->keys->items[i])) {
+                return false;
+            }
+        }
+    }
+
+    for (int i = 0; i < root->children->size; i++) {
+        if (!check_if_the_keys_have_been_correctly_inserted(root->children->items[i])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool check_BPTree_compliance(BPTreeNode *root) {
+    bool is_compliant = true;
+
+    is_compliant &= check_if_the_leaf_nodes_are_correctly_chained(root);
+    is_compliant &= check_if_all_leaf_nodes_nodes_have_no_children(root);
+    is_compliant &= check_if_all_leaf_nodes_have_as_many_keys_as_data(root);
+    is_compliant &= check_if_all_leaf_nodes_are_at_the_same_depth(root, compute_first_leaf_depth(root), 0);
+
+    is_compliant &= check_if_all_internal_nodes_have_no_data(root);
+    is_compliant &= check_if_all_internal_nodes_have_always_1_child_more_than_the_number_of_keys(root);
+
+    is_compliant &= check_if_all_nodes_have_their_keys_sorted(root);
+    is_compliant &= check_if_all_nodes_have_no_more_keys_than_the_maximum_allowed(root);
+    is_compliant &= check_if_all_nodes_except_the_root_node_have_not_less_keys_than_the_minimum_required(root, NULL, true);
+
+    is_compliant &= check_if_the_keys_have_been_correctly_inserted(root);
+
+    return is_compliant;
+}
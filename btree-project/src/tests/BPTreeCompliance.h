@@ -0,0 +1,34 @@
+/**
+ * @file BPTreeCompliance.h
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#ifndef BPTREE_COMPLIANCE_H
+#define BPTREE_COMPLIANCE_H
+
+#include <stdbool.h>
+
+#include "../BPTree.h"
+
+/**
+ * @brief Computes the depth of the leftmost leaf node, the root node being at depth 0.
+ *
+ * @param root The root node.
+ * @return int The depth of the leftmost leaf node.
+ */
+int compute_first_leaf_depth(BPTreeNode *root);
+
+/**
+ * @brief Checks that a B+ tree is compliant with the B+ Tree rules: the leaves are chained in order and are all at the
+ * same depth, the internal nodes have one child more than keys and no data, the keys are sorted, within the range
+ * given by the parent and the number of keys of each node is within the bounds of the order, except that the last node
+ * of each level may have a single key.
+ *
+ * @param root The root node.
+ * @return true The B+ tree is compliant.
+ * @return false The B+ tree is not compliant.
+ */
+bool check_BPTree_compliance(BPTreeNode *root);
+
+#endif
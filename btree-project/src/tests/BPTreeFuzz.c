@@ -0,0 +1,317 @@
+/**
+ * @file BPTreeFuzz.c
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ *
+ * Differential stress test of the B+ tree: random operations are applied both to the B+ tree and to a reference, the
+ * results must always be the same and the B+ tree must remain compliant with the B+ Tree rules.
+ *
+ * Compiled normally, the program runs the operations for several orders and reports the throughput of each order:
+ *   ./fuzz_exec [number of operations] [seed]
+ * Compiled with -DBPTREE_FUZZER, the program is a libFuzzer target whose inputs are decoded into operations.
+ */
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../BPTree.h"
+#include "BPTreeCompliance.h"
+
+#define OPERATION_INSERT 0
+#define OPERATION_UPSERT 1
+#define OPERATION_DELETE 2
+#define OPERATION_SEARCH 3
+
+#define DEFAULT_OPERATION_COUNT 1000000
+#define DEFAULT_SEED 0
+// The keys of the random operations are drawn from [0, RANDOM_KEY_RANGE), small enough for the keys to collide.
+#define RANDOM_KEY_RANGE (1 << 20)
+// The keys decoded from the inputs of the fuzzer are 16-bit keys.
+#define FUZZER_KEY_RANGE (1 << 16)
+// The compliance of the B+ tree is checked every time this number of operations has been applied.
+#define RANDOM_CHECK_INTERVAL 65536
+
+/**
+ * @brief Data structure that represents an operation on the B+ tree.
+ *
+ */
+typedef struct Operation {
+    uint8_t type;
+    uint64_t key;
+} Operation;
+
+/**
+ * @brief Data structure that represents the expected content of the B+ tree: the keys are the positions of the array,
+ * which is therefore always sorted.
+ *
+ */
+typedef struct Reference {
+    bool *is_present;
+    uint64_t *data;
+    int key_range;
+} Reference;
+
+/**
+ * @brief Initializes an empty reference.
+ *
+ * @param key_range The keys are in [0, key_range).
+ * @return Reference* The initialized reference.
+ */
+static Reference *Reference_init(int key_range) {
+    Reference *reference = (Reference *)malloc(sizeof(Reference));
+    reference->is_present = (bool *)calloc(key_range, sizeof(bool));
+    reference->data = (uint64_t *)calloc(key_range, sizeof(uint64_t));
+    reference->key_range = key_range;
+    return reference;
+}
+
+/**
+ * @brief Destroys the reference and free its memory.
+ *
+ * @param reference The reference to be destroyed.
+ */
+static void Reference_destroy(Reference **reference) {
+    free((*reference)->is_present);
+    free((*reference)->data);
+    free(*reference);
+    *reference = NULL;
+}
+
+/**
+ * @brief Checks that the leaves of the B+ tree hold exactly the keys and the data of the reference, in order.
+ *
+ * @param root The root node.
+ * @param reference The reference.
+ * @return true The contents are the same.
+ * @return false The contents differ.
+ */
+static bool check_contents(BPTreeNode *root, Reference *reference) {
+    BPTreeNode *leaf = BPTree_find_first_leaf(root);
+    int i = 0;
+
+    for (uint64_t key = 0; key < (uint64_t)reference->key_range; key++) {
+        if (!reference->is_present[key]) {
+            continue;
+        }
+
+        // Moves to the next leaf that has keys, a leaf is only empty when it is the root.
+        while (leaf != NULL && i == leaf->keys->size) {
+            leaf = leaf->next;
+            i = 0;
+        }
+
+        if (leaf == NULL || leaf->keys->items[i] != key || leaf->data->items[i] != reference->data[key]) {
+            return false;
+        }
+
+        i++;
+    }
+
+    // The B+ tree must not have more keys than the reference.
+    while (leaf != NULL && i == leaf->keys->size) {
+        leaf = leaf->next;
+        i = 0;
+    }
+
+    return leaf == NULL;
+}
+
+/**
+ * @brief Applies an operation to the B+ tree and to the reference and compares the results.
+ *
+ * @param root The root node.
+ * @param reference The reference.
+ * @param operation The operation.
+ * @param data The data of the operation, it is different for each operation so that a stale data is noticed.
+ * @return true The results are the same.
+ * @return false The results differ.
+ */
+static bool apply_operation(BPTreeNode *root, Reference *reference, Operation *operation, uint64_t data) {
+    uint64_t key = operation->key;
+    bool was_present = reference->is_present[key];
+
+    switch (operation->type) {
+        case OPERATION_INSERT:
+            if (BPTree_insert(root, key, data) == was_present) {
+                return false;
+            }
+
+            if (!was_present) {
+                reference->is_present[key] = true;
+                reference->data[key] = data;
+            }
+
+            return true;
+        case OPERATION_UPSERT:
+            if (BPTree_upsert(root, key, data) == was_present) {
+                return false;
+            }
+
+            reference->is_present[key] = true;
+            reference->data[key] = data;
+            return true;
+        case OPERATION_DELETE:
+            if (BPTree_delete(root, key) != was_present) {
+                return false;
+            }
+
+            reference->is_present[key] = false;
+            return true;
+        default: {
+            uint64_t found_data;
+            bool is_found = BPTree_search(root, key, &found_data);
+            return is_found == was_present && (!is_found || found_data == reference->data[key]);
+        }
+    }
+}
+
+/**
+ * @brief Applies the operations to a new B+ tree and to a reference and checks the B+ tree after each batch of
+ * operations. The first operation that goes wrong is displayed.
+ *
+ * @param order The order of the B+ tree.
+ * @param operations The operations.
+ * @param operation_count The number of operations.
+ * @param key_range The keys of the operations are in [0, key_range).
+ * @param check_interval The B+ tree is checked every time this number of operations has been applied.
+ * @return true The B+ tree behaved like the reference.
+ * @return false The B+ tree went wrong.
+ */
+static bool run_differential(int order, Operation *operations, int operation_count, int key_range, int check_interval) {
+    static const char *operation_names[] = {"insert", "upsert", "delete", "search"};
+    BPTreeNode *root = BPTree_init(order);
+    Reference *reference = Reference_init(key_range);
+    bool is_ok = true;
+
+    for (int i = 0; i < operation_count && is_ok; i++) {
+        if (!apply_operation(root, reference, &operations[i], i)) {
+            fprintf(stderr, "order %d, operation %d (%s %" PRIu64 "): the result differs from the reference.\n", order, i, operation_names[operations[i].type], operations[i].key);
+            is_ok = false;
+        } else if (((i + 1) % check_interval == 0 || i + 1 == operation_count) && (!check_BPTree_compliance(root) || !check_contents(root, reference))) {
+            fprintf(stderr, "order %d, after operation %d (%s %" PRIu64 "): the B+ tree is corrupted.\n", order, i, operation_names[operations[i].type], operations[i].key);
+            is_ok = false;
+        }
+    }
+
+    Reference_destroy(&reference);
+    BPTree_destroy(&root);
+    return is_ok;
+}
+
+#ifdef BPTREE_FUZZER
+
+int LLVMFuzzerTestOneInput(const uint8_t *bytes, size_t size) {
+    if (size < 1) {
+        return 0;
+    }
+
+    // The first byte is the order, then each operation takes 3 bytes: its type and its key.
+    int order = 1 + bytes[0] % 16;
+    int operation_count = (size - 1) / 3;
+    Operation *operations = (Operation *)malloc(sizeof(Operation) * (operation_count > 0 ? operation_count : 1));
+
+    for (int i = 0; i < operation_count; i++) {
+        const uint8_t *operation_bytes = bytes + 1 + 3 * i;
+        operations[i].type = operation_bytes[0] % 4;
+        operations[i].key = (uint64_t)operation_bytes[1] | (uint64_t)operation_bytes[2] << 8;
+    }
+
+    // The inputs are short, the B+ tree is checked after every operation.
+    if (!run_differential(order, operations, operation_count, FUZZER_KEY_RANGE, 1)) {
+        abort();
+    }
+
+    free(operations);
+    return 0;
+}
+
+#else
+
+/**
+ * @brief Generates random operations: half of them add a key, so that the B+ tree grows while it is modified.
+ *
+ * @param operation_count The number of operations.
+ * @return Operation* The generated operations.
+ */
+static Operation *generate_random_operations(int operation_count) {
+    Operation *operations = (Operation *)malloc(sizeof(Operation) * operation_count);
+
+    for (int i = 0; i < operation_count; i++) {
+        int draw = rand() % 20;
+        operations[i].type = draw < 8 ? OPERATION_INSERT : draw < 10 ? OPERATION_UPSERT : draw < 15 ? OPERATION_DELETE : OPERATION_SEARCH;
+        operations[i].key = ((uint64_t)rand() << 16 ^ (uint64_t)rand()) % RANDOM_KEY_RANGE;
+    }
+
+    return operations;
+}
+
+/**
+ * @brief Measures the throughput of the B+ tree, the operations are applied to a new B+ tree without any check.
+ *
+ * @param order The order of the B+ tree.
+ * @param operations The operations.
+ * @param operation_count The number of operations.
+ * @return double The number of operations per second.
+ */
+static double measure_throughput(int order, Operation *operations, int operation_count) {
+    BPTreeNode *root = BPTree_init(order);
+    struct timespec start, end;
+    uint64_t data;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (int i = 0; i < operation_count; i++) {
+        switch (operations[i].type) {
+            case OPERATION_INSERT:
+                BPTree_insert(root, operations[i].key, i);
+                break;
+            case OPERATION_UPSERT:
+                BPTree_upsert(root, operations[i].key, i);
+                break;
+            case OPERATION_DELETE:
+                BPTree_delete(root, operations[i].key);
+                break;
+            default:
+                BPTree_search(root, operations[i].key, &data);
+                break;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    BPTree_destroy(&root);
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    return operation_count / seconds;
+}
+
+int main(int argc, char *argv[]) {
+    static const int orders[] = {1, 2, 3, 4, 8, 16};
+    int operation_count = argc > 1 ? atoi(argv[1]) : DEFAULT_OPERATION_COUNT;
+    int seed = argc > 2 ? atoi(argv[2]) : DEFAULT_SEED;
+
+    if (operation_count <= 0) {
+        fprintf(stderr, "Usage: %s [number of operations] [seed]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    srand(seed);
+    Operation *operations = generate_random_operations(operation_count);
+    bool is_ok = true;
+
+    for (int i = 0; i < (int)(sizeof(orders) / sizeof(orders[0])) && is_ok; i++) {
+        is_ok = run_differential(orders[i], operations, operation_count, RANDOM_KEY_RANGE, RANDOM_CHECK_INTERVAL);
+
+        if (is_ok) {
+            printf("order %2d : %d operations OK, %.0f operations/s\n", orders[i], operation_count, measure_throughput(orders[i], operations, operation_count));
+        }
+    }
+
+    free(operations);
+    return is_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+#endif
@@ -4,243 +4,59 @@
  * @version 1.0
  * @date 2022-06-17
  */
+#include <inttypes.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "../Array.h"
 #include "../BPTree.h"
+#include "../BPTreeStats.h"
+#include "../BPTreeTypes.h"
+#include "../BPTreeWriteBatch.h"
+#include "../Bitmap.h"
+#include "../BloomFilter.h"
+#include "../ColumnStore.h"
+#include "../Crc32c.h"
+#include "../HashIndex.h"
+#include "../NodeArena.h"
+#include "../RadixTree.h"
+#include "../RecordCache.h"
+#include "../StaticIndex.h"
+#include "BPTreeCompliance.h"
 #include "Unity/unity.h"
 
 #define RANDOM_MIN 0
 #define RANDOM_MAX 1000
 
-void setUp() {
-}
-
-void tearDown() {
-}
-
-// BEGIN : Functions that check that a B+ tree is compliant with the B+ Tree rules.
+// The specialized B+ trees are checked with more keys, so that they have several levels despite their large nodes.
+#define SPECIALIZED_RANDOM_MAX 20000
+#define SPECIALIZED_OPERATION_COUNT 50000
 
 /**
- * @brief Finds the leftmost leaf node.
+ * @brief Data structure stored inline as the data of a specialized B+ tree.
  *
- * @param root The root node.
- * @return BPTreeNode* The leftmost leaf node.
  */
-static BPTreeNode *find_first_leaf(BPTreeNode *root) {
-    if (root->is_leaf) {
-        return root;
-    }
-
-    return find_first_leaf(root->children->items[0]);
-}
-
-static bool check_if_the_leaf_nodes_are_correctly_chained(BPTreeNode *root) {
-    BPTreeNode *current = find_first_leaf(root);
-
-    while (current->next != NULL) {
-        if (current->keys->items[current->keys->size - 1] >= current->next->keys->items[0]) {
-            return false;
-        }
-
-        current = current->next;
-    }
-
-    return true;
-}
-
-static bool check_if_all_leaf_nodes_nodes_have_no_children(BPTreeNode *root) {
-    if (root->is_leaf) {
-        return root->children->size == 0;
-    }
-
-    for (int i = 0; i < root->children->size; i++) {
-        if (!check_if_all_leaf_nodes_nodes_have_no_children(root->children->items[i])) {
-            return false;
-        }
-    }
-
-    return true;
-}
-
-static bool check_if_all_leaf_nodes_have_as_many_keys_as_data(BPTreeNode *root) {
-    if (root->is_leaf) {
-        return root->keys->size == root->data->size;
-    }
-
-    for (int i = 0; i < root->children->size; i++) {
-        if (!check_if_all_leaf_nodes_have_as_many_keys_as_data(root->children->items[i])) {
-            return false;
-        }
-    }
-
-    return true;
-}
-
-static int compute_first_leaf_depth(BPTreeNode *root) {
-    if (root->is_leaf) {
-        return 0;
-    }
-
-    return compute_first_leaf_depth(root->children->items[0]) + 1;
-}
-
-static bool check_if_all_leaf_nodes_are_at_the_same_depth(BPTreeNode *root, int expected_depth, int depth) {
-    if (root->is_leaf) {
-        return depth == expected_depth;
-    }
-
-    for (int i = 0; i < root->children->size; i++) {
-        if (!check_if_all_leaf_nodes_are_at_the_same_depth(root->children->items[i], expected_depth, depth + 1)) {
-            return false;
-        }
-    }
-
-    return true;
-}
-
-static bool check_if_all_internal_nodes_have_no_data(BPTreeNode *root) {
-    if (root->is_leaf) {
-        return true;
-    }
-
-    for (int i = 0; i < root->children->size; i++) {
-        if (!check_if_all_internal_nodes_have_no_data(root->children->items[i])) {
-            return false;
-        }
-    }
-
-    return root->data->size == 0;
-}
-
-static bool check_if_all_internal_nodes_have_always_1_child_more_than_the_number_of_keys(BPTreeNode *root) {
-    if (root->is_leaf) {
-        return true;
-    }
-
-    for (int i = 0; i < root->children->size; i++) {
-        if (!check_if_all_internal_nodes_have_always_1_child_more_than_the_number_of_keys(root->children->items[i])) {
-            return false;
-        }
-    }
-
-    return root->children->size == root->keys->size + 1;
-}
-
-static bool check_if_the_array_is_sorted(IntegerArray *array) {
-    for (int i = 0; i < array->size - 1; i++) {
-        if (array->items[i] > array->items[i + 1]) {
-            return false;
-        }
-    }
-
-    return true;
-}
-
-static bool check_if_all_nodes_have_their_keys_sorted(BPTreeNode *root) {
-    for (int i = 0; i < root->children->size; i++) {
-        if (!check_if_all_nodes_have_their_keys_sorted(root->children->items[i])) {
-            return false;
-        }
-    }
-
-    return check_if_the_array_is_sorted(root->keys);
-}
-
-static bool check_if_all_nodes_have_no_more_keys_than_the_maximum_allowed(BPTreeNode *root) {
-    for (int i = 0; i < root->children->size; i++) {
-        if (!check_if_all_nodes_have_no_more_keys_than_the_maximum_allowed(root->children->items[i])) {
-            return false;
-        }
-    }
-
-    return root->keys->size <= 2 * root->order;
-}
-
-static bool check_if_all_nodes_except_the_root_node_have_not_less_keys_than_the_minimum_required(BPTreeNode *root, BPTreeNode *parent) {
-    for (int i = 0; i < root->children->size; i++) {
-        if (!check_if_all_nodes_except_the_root_node_have_not_less_keys_than_the_minimum_required(root->children->items[i], root)) {
-            return false;
-        }
-    }
-
-    if (parent == NULL) {
-        return true;
-    }
-
-    return root->keys->size >= root->order;
-}
-
-static bool check_if_the_keys_have_been_correctly_inserted_within_range(BPTreeNode *root, uint64_t left, uint64_t right) {
-    for (int i = 0; i < root->keys->size; i++) {
-        if (root->keys->items[i] < left || root->keys->items[i] >= right) {
-            return false;
-        }
-    }
-
-    for (int i = 0; i < root->children->size; i++) {
-        if (!check_if_the_keys_have_been_correctly_inserted_within_range(root->children->items[i], left, right)) {
-            return false;
-        }
-    }
-
-    return true;
-}
-
-static bool check_if_the_keys_have_been_correctly_inserted(BPTreeNode *root) {
-    if (root->is_leaf) {
-        return true;
-    }
-
-    for (int i = 0; i < root->children->size; i++) {
-        if (i == 0) {
-            if (!check_if_the_keys_have_been_correctly_inserted_within_range(root->children->items[i], 0, root->keys->items[i])) {
-                return false;
-            }
-        } else if (i == root->children->size - 1) {
-            if (!check_if_the_keys_have_been_correctly_inserted_within_range(root->children->items[i], root->keys->items[i - 1], 18446744073709551615LLU)) {
-                return false;
-            }
-        } else {
-            if (!check_if_the_keys_have_been_correctly_inserted_within_range(root->children->items[i], root->keys->items[i - 1], root->keys->items[i])) {
-                return false;
-            }
-        }
-    }
+typedef struct Date {
+    int year;
+    int month;
+    int day;
+} Date;
 
-    for (int i = 0; i < root->children->size; i++) {
-        if (!check_if_the_keys_have_been_correctly_inserted(root->children->items[i])) {
-            return false;
-        }
-    }
+#define BPTREE_NAME DateTree
+#define BPTREE_KEY uint32_t
+#define BPTREE_DATA Date
+#include "../BPTreeTemplate.h"
 
-    return true;
+void setUp() {
 }
 
-static bool check_BPTree_compliance(BPTreeNode *root) {
-    bool is_compliant = true;
-
-    is_compliant &= check_if_the_leaf_nodes_are_correctly_chained(root);
-    is_compliant &= check_if_all_leaf_nodes_nodes_have_no_children(root);
-    is_compliant &= check_if_all_leaf_nodes_have_as_many_keys_as_data(root);
-    is_compliant &= check_if_all_leaf_nodes_are_at_the_same_depth(root, compute_first_leaf_depth(root), 0);
-
-    is_compliant &= check_if_all_internal_nodes_have_no_data(root);
-    is_compliant &= check_if_all_internal_nodes_have_always_1_child_more_than_the_number_of_keys(root);
-
-    is_compliant &= check_if_all_nodes_have_their_keys_sorted(root);
-    is_compliant &= check_if_all_nodes_have_no_more_keys_than_the_maximum_allowed(root);
-    is_compliant &= check_if_all_nodes_except_the_root_node_have_not_less_keys_than_the_minimum_required(root, NULL);
-
-    is_compliant &= check_if_the_keys_have_been_correctly_inserted(root);
-
-    return is_compliant;
+void tearDown() {
 }
 
-// END : Functions that check that a B+ tree is compliant with the B+ Tree rules.
-
 /**
  * @brief Checks if an item is present in the array.
  *
@@ -472,31 +288,1260 @@ void test_BPTree_search_should_find_the_keys_that_exist_in_the_BPTree_using_BPTr
 
 // **** END : test_BPTree_search
 
-// END : Tests
+// **** BEGIN : test_BPTree_upsert
 
-int main(void) {
-    UNITY_BEGIN();
+void test_BPTree_upsert_should_replace_the_data_of_existing_keys_using_BPTree_of_given_order(int order) {
+    int size = 256;
 
-    RUN_TEST(test_BPTree_insert_should_comply_with_BPTree_rules_using_BPTree_of_order_1);
-    RUN_TEST(test_BPTree_insert_should_comply_with_BPTree_rules_using_BPTree_of_order_2);
-    RUN_TEST(test_BPTree_insert_should_comply_with_BPTree_rules_using_BPTree_of_order_3);
-    RUN_TEST(test_BPTree_insert_should_comply_with_BPTree_rules_using_BPTree_of_order_4);
-    RUN_TEST(test_BPTree_insert_should_comply_with_BPTree_rules_using_BPTree_of_order_8);
-    RUN_TEST(test_BPTree_insert_should_comply_with_BPTree_rules_using_BPTree_of_order_16);
+    srand(0);
 
-    RUN_TEST(test_BPTree_delete_should_comply_with_BPTree_rules_using_BPTree_of_order_1);
-    RUN_TEST(test_BPTree_delete_should_comply_with_BPTree_rules_using_BPTree_of_order_2);
-    RUN_TEST(test_BPTree_delete_should_comply_with_BPTree_rules_using_BPTree_of_order_3);
-    RUN_TEST(test_BPTree_delete_should_comply_with_BPTree_rules_using_BPTree_of_order_4);
-    RUN_TEST(test_BPTree_delete_should_comply_with_BPTree_rules_using_BPTree_of_order_8);
-    RUN_TEST(test_BPTree_delete_should_comply_with_BPTree_rules_using_BPTree_of_order_16);
+    IntegerArray *keys = generate_random_numbers_array(size, RANDOM_MIN, RANDOM_MAX);
+    BPTreeNode *root = BPTree_init(order);
 
-    RUN_TEST(test_BPTree_search_should_find_the_keys_that_exist_in_the_BPTree_using_BPTree_of_order_1);
-    RUN_TEST(test_BPTree_search_should_find_the_keys_that_exist_in_the_BPTree_using_BPTree_of_order_2);
-    RUN_TEST(test_BPTree_search_should_find_the_keys_that_exist_in_the_BPTree_using_BPTree_of_order_3);
-    RUN_TEST(test_BPTree_search_should_find_the_keys_that_exist_in_the_BPTree_using_BPTree_of_order_4);
-    RUN_TEST(test_BPTree_search_should_find_the_keys_that_exist_in_the_BPTree_using_BPTree_of_order_8);
-    RUN_TEST(test_BPTree_search_should_find_the_keys_that_exist_in_the_BPTree_using_BPTree_of_order_16);
+    // The first half of the keys is inserted with upsert, these keys did not exist.
+    for (int i = 0; i < keys->size / 2; i++) {
+        TEST_ASSERT(BPTree_upsert(root, keys->items[i], transform_key_to_data(keys->items[i])));
+        TEST_ASSERT(check_BPTree_compliance(root));
+    }
+
+    // All the keys are upserted, the first half must only have its data replaced.
+    for (int i = 0; i < keys->size; i++) {
+        bool is_inserted = BPTree_upsert(root, keys->items[i], transform_key_to_data(keys->items[i]) + 1);
+        TEST_ASSERT_EQUAL(i >= keys->size / 2, is_inserted);
+        TEST_ASSERT(check_BPTree_compliance(root));
+    }
+
+    for (int i = 0; i < keys->size; i++) {
+        uint64_t data;
+        TEST_ASSERT(BPTree_search(root, keys->items[i], &data));
+        TEST_ASSERT_EQUAL_UINT64(transform_key_to_data(keys->items[i]) + 1, data);
+    }
+
+    IntegerArray_destroy(&keys);
+    BPTree_destroy(&root);
+}
+
+void test_BPTree_upsert_should_replace_the_data_of_existing_keys_using_BPTree_of_order_1() {
+    test_BPTree_upsert_should_replace_the_data_of_existing_keys_using_BPTree_of_given_order(1);
+}
+
+void test_BPTree_upsert_should_replace_the_data_of_existing_keys_using_BPTree_of_order_2() {
+    test_BPTree_upsert_should_replace_the_data_of_existing_keys_using_BPTree_of_given_order(2);
+}
+
+void test_BPTree_upsert_should_replace_the_data_of_existing_keys_using_BPTree_of_order_3() {
+    test_BPTree_upsert_should_replace_the_data_of_existing_keys_using_BPTree_of_given_order(3);
+}
+
+void test_BPTree_upsert_should_replace_the_data_of_existing_keys_using_BPTree_of_order_4() {
+    test_BPTree_upsert_should_replace_the_data_of_existing_keys_using_BPTree_of_given_order(4);
+}
+
+void test_BPTree_upsert_should_replace_the_data_of_existing_keys_using_BPTree_of_order_8() {
+    test_BPTree_upsert_should_replace_the_data_of_existing_keys_using_BPTree_of_given_order(8);
+}
+
+void test_BPTree_upsert_should_replace_the_data_of_existing_keys_using_BPTree_of_order_16() {
+    test_BPTree_upsert_should_replace_the_data_of_existing_keys_using_BPTree_of_given_order(16);
+}
+
+// **** END : test_BPTree_upsert
+
+// **** BEGIN : test_BPTree_insert_batch
+
+void test_BPTree_insert_batch_should_insert_the_keys_that_do_not_exist_using_BPTree_of_given_order(int order) {
+    int size = 512;
+
+    // Test 10 times, variable i being the seed.
+    for (int i = 0; i < 10; i++) {
+        srand(i);
+
+        IntegerArray *keys = generate_random_numbers_array(size, RANDOM_MIN, RANDOM_MAX);
+        BPTreeNode *root = BPTree_init(order);
+
+        // The first quarter of the keys is inserted one by one, so that the batch goes into a tree that is not empty.
+        for (int j = 0; j < keys->size / 4; j++) {
+            BPTree_insert(root, keys->items[j], transform_key_to_data(keys->items[j]));
+        }
+
+        // The batch holds all the keys, in random order, then the second half of the keys a second time.
+        int batch_size = keys->size + keys->size / 2;
+        uint64_t *batch_keys = (uint64_t *)malloc(sizeof(uint64_t) * batch_size);
+        uint64_t *batch_data = (uint64_t *)malloc(sizeof(uint64_t) * batch_size);
+
+        for (int j = 0; j < batch_size; j++) {
+            int index = j < keys->size ? j : j - keys->size / 2;
+            batch_keys[j] = keys->items[index];
+            // Only the data of the first occurrence of a new key must be inserted.
+            batch_data[j] = transform_key_to_data(keys->items[index]) + (j < keys->size ? 0 : 1);
+        }
+
+        TEST_ASSERT_EQUAL(keys->size - keys->size / 4, BPTree_insert_batch(root, batch_keys, batch_data, batch_size));
+        TEST_ASSERT(check_BPTree_compliance(root));
+
+        for (int j = 0; j < keys->size; j++) {
+            uint64_t data;
+            TEST_ASSERT(BPTree_search(root, keys->items[j], &data));
+            TEST_ASSERT_EQUAL_UINT64(transform_key_to_data(keys->items[j]), data);
+        }
+
+        free(batch_keys);
+        free(batch_data);
+        IntegerArray_destroy(&keys);
+        BPTree_destroy(&root);
+    }
+}
+
+void test_BPTree_insert_batch_should_insert_the_keys_that_do_not_exist_using_BPTree_of_order_1() {
+    test_BPTree_insert_batch_should_insert_the_keys_that_do_not_exist_using_BPTree_of_given_order(1);
+}
+
+void test_BPTree_insert_batch_should_insert_the_keys_that_do_not_exist_using_BPTree_of_order_2() {
+    test_BPTree_insert_batch_should_insert_the_keys_that_do_not_exist_using_BPTree_of_given_order(2);
+}
+
+void test_BPTree_insert_batch_should_insert_the_keys_that_do_not_exist_using_BPTree_of_order_3() {
+    test_BPTree_insert_batch_should_insert_the_keys_that_do_not_exist_using_BPTree_of_given_order(3);
+}
+
+void test_BPTree_insert_batch_should_insert_the_keys_that_do_not_exist_using_BPTree_of_order_4() {
+    test_BPTree_insert_batch_should_insert_the_keys_that_do_not_exist_using_BPTree_of_given_order(4);
+}
+
+void test_BPTree_insert_batch_should_insert_the_keys_that_do_not_exist_using_BPTree_of_order_8() {
+    test_BPTree_insert_batch_should_insert_the_keys_that_do_not_exist_using_BPTree_of_given_order(8);
+}
+
+void test_BPTree_insert_batch_should_insert_the_keys_that_do_not_exist_using_BPTree_of_order_16() {
+    test_BPTree_insert_batch_should_insert_the_keys_that_do_not_exist_using_BPTree_of_given_order(16);
+}
+
+// **** END : test_BPTree_insert_batch
+
+// **** BEGIN : test_BPTree_bulk_load
+
+void test_BPTree_bulk_load_should_comply_with_BPTree_rules_using_BPTree_of_given_order(int order) {
+    // Every size up to a few levels, so that each way of spreading the keys over the nodes is met.
+    for (int size = 0; size < 300; size++) {
+        uint64_t *keys = (uint64_t *)malloc(sizeof(uint64_t) * (size > 0 ? size : 1));
+        uint64_t *data = (uint64_t *)malloc(sizeof(uint64_t) * (size > 0 ? size : 1));
+
+        for (int i = 0; i < size; i++) {
+            keys[i] = (uint64_t)i * 3;
+            data[i] = transform_key_to_data(keys[i]);
+        }
+
+        BPTreeNode *root = BPTree_init(order);
+        BPTree_bulk_load(root, keys, data, size);
+        TEST_ASSERT(check_BPTree_compliance(root));
+
+        for (int i = 0; i < size; i++) {
+            uint64_t found_data;
+            TEST_ASSERT(BPTree_search(root, keys[i], &found_data));
+            TEST_ASSERT_EQUAL_UINT64(data[i], found_data);
+            TEST_ASSERT_FALSE(BPTree_search(root, keys[i] + 1, &found_data));
+        }
+
+        // The tree built must remain valid once modified.
+        for (int i = 0; i < size; i += 2) {
+            TEST_ASSERT(BPTree_delete(root, keys[i]));
+            TEST_ASSERT(BPTree_insert(root, keys[i] + 1, 0));
+        }
+        TEST_ASSERT(check_BPTree_compliance(root));
+
+        free(keys);
+        free(data);
+        BPTree_destroy(&root);
+    }
+}
+
+void test_BPTree_bulk_load_should_comply_with_BPTree_rules_using_BPTree_of_order_1() {
+    test_BPTree_bulk_load_should_comply_with_BPTree_rules_using_BPTree_of_given_order(1);
+}
+
+void test_BPTree_bulk_load_should_comply_with_BPTree_rules_using_BPTree_of_order_2() {
+    test_BPTree_bulk_load_should_comply_with_BPTree_rules_using_BPTree_of_given_order(2);
+}
+
+// **** END : test_BPTree_bulk_load
+
+// **** BEGIN : test_BPTreeWriteBatch
+
+void test_BPTreeWriteBatch_should_find_the_same_keys_as_the_BPTree_using_BPTree_of_given_order(int order) {
+    srand(0);
+    BPTreeNode *root = BPTree_init(order);
+    BPTreeNode *batched_root = BPTree_init(order);
+    // A small batch so that it is applied many times.
+    BPTreeWriteBatch *batch = BPTreeWriteBatch_init(batched_root, 64);
+
+    for (int i = 0; i < 10000; i++) {
+        uint64_t key = RANDOM_MIN + rand() % (RANDOM_MAX - RANDOM_MIN);
+
+        if (rand() % 3 < 2) {
+            BPTree_upsert(root, key, transform_key_to_data(key) + i);
+            BPTreeWriteBatch_upsert(batch, key, transform_key_to_data(key) + i);
+        } else {
+            BPTree_delete(root, key);
+            BPTreeWriteBatch_delete(batch, key);
+        }
+
+        // The key must be found whether its last modification is still in the batch or not.
+        uint64_t expected_data = 0;
+        uint64_t data = 0;
+        TEST_ASSERT_EQUAL(BPTree_search(root, key, &expected_data), BPTreeWriteBatch_search(batch, key, &data));
+        TEST_ASSERT_EQUAL_UINT64(expected_data, data);
+    }
+
+    // The pending modifications are applied when the batch is destroyed.
+    BPTreeWriteBatch_destroy(&batch);
+    TEST_ASSERT(check_BPTree_compliance(batched_root));
+
+    for (uint64_t key = RANDOM_MIN; key < RANDOM_MAX; key++) {
+        uint64_t expected_data = 0;
+        uint64_t data = 0;
+        TEST_ASSERT_EQUAL(BPTree_search(root, key, &expected_data), BPTree_search(batched_root, key, &data));
+        TEST_ASSERT_EQUAL_UINT64(expected_data, data);
+    }
+
+    BPTree_destroy(&batched_root);
+    BPTree_destroy(&root);
+}
+
+void test_BPTreeWriteBatch_should_find_the_same_keys_as_the_BPTree_using_BPTree_of_order_1() {
+    test_BPTreeWriteBatch_should_find_the_same_keys_as_the_BPTree_using_BPTree_of_given_order(1);
+}
+
+void test_BPTreeWriteBatch_should_find_the_same_keys_as_the_BPTree_using_BPTree_of_order_16() {
+    test_BPTreeWriteBatch_should_find_the_same_keys_as_the_BPTree_using_BPTree_of_given_order(16);
+}
+
+// **** END : test_BPTreeWriteBatch
+
+// **** BEGIN : test_BPTree_init_in_arena
+
+void test_BPTree_init_in_arena_should_find_the_same_keys_as_the_BPTree_using_given_pages(NodeArenaPages pages) {
+    srand(0);
+    BPTreeNode *root = BPTree_init(2);
+    // The nodes freed by the deletions are reused by the next insertions.
+    BPTreeNode *arena_root = BPTree_init_in_arena(2, pages);
+
+    for (int i = 0; i < 20000; i++) {
+        uint64_t key = RANDOM_MIN + rand() % (RANDOM_MAX - RANDOM_MIN);
+
+        if (rand() % 3 < 2) {
+            TEST_ASSERT_EQUAL(BPTree_upsert(root, key, transform_key_to_data(key) + i), BPTree_upsert(arena_root, key, transform_key_to_data(key) + i));
+        } else {
+            TEST_ASSERT_EQUAL(BPTree_delete(root, key), BPTree_delete(arena_root, key));
+        }
+    }
+
+    TEST_ASSERT(check_BPTree_compliance(arena_root));
+
+    for (uint64_t key = RANDOM_MIN; key < RANDOM_MAX; key++) {
+        uint64_t expected_data = 0;
+        uint64_t data = 0;
+        TEST_ASSERT_EQUAL(BPTree_search(root, key, &expected_data), BPTree_search(arena_root, key, &data));
+        TEST_ASSERT_EQUAL_UINT64(expected_data, data);
+    }
+
+    BPTree_destroy(&arena_root);
+    BPTree_destroy(&root);
+}
+
+void test_BPTree_init_in_arena_should_find_the_same_keys_as_the_BPTree_using_small_pages() {
+    test_BPTree_init_in_arena_should_find_the_same_keys_as_the_BPTree_using_given_pages(NODE_ARENA_SMALL_PAGES);
+}
+
+void test_BPTree_init_in_arena_should_find_the_same_keys_as_the_BPTree_using_huge_pages() {
+    // Without huge pages reserved by the administrator, the arena falls back to transparent huge pages.
+    test_BPTree_init_in_arena_should_find_the_same_keys_as_the_BPTree_using_given_pages(NODE_ARENA_EXPLICIT_HUGE_PAGES);
+}
+
+// **** END : test_BPTree_init_in_arena
+
+// **** BEGIN : test_BPTree_compute_shape
+
+void test_BPTree_compute_shape_should_match_the_structure_of_the_BPTree() {
+    srand(0);
+
+    IntegerArray *keys = generate_random_numbers_array(256, RANDOM_MIN, RANDOM_MAX);
+    BPTreeNode *root = BPTree_init(2);
+    BPTree_reset_counters();
+
+    for (int i = 0; i < keys->size; i++) {
+        BPTree_insert(root, keys->items[i], transform_key_to_data(keys->items[i]));
+    }
+
+    BPTreeShape shape;
+    BPTree_compute_shape(root, &shape);
+
+    TEST_ASSERT_EQUAL_UINT64(keys->size, shape.key_count);
+    TEST_ASSERT_EQUAL(compute_first_leaf_depth(root) + 1, shape.height);
+
+    int histogram_leaf_count = 0;
+    for (int i = 0; i < BPTREE_FILL_HISTOGRAM_BUCKETS; i++) {
+        histogram_leaf_count += shape.leaf_fill_histogram[i];
+    }
+    TEST_ASSERT_EQUAL(shape.leaf_count, histogram_leaf_count);
+
+#ifdef BPTREE_STATS
+    BPTreeCounters counters;
+    BPTree_collect_counters(&counters);
+
+    // Without deletions, each leaf except the first one results from a split.
+    TEST_ASSERT_EQUAL_UINT64(keys->size, counters.insertions);
+    TEST_ASSERT_EQUAL_UINT64(shape.leaf_count - 1, counters.leaf_splits);
+    TEST_ASSERT_EQUAL_UINT64(shape.height - 1, counters.grows);
+#endif
+
+    IntegerArray_destroy(&keys);
+    BPTree_destroy(&root);
+}
+
+void test_BPTree_insert_should_fill_the_leaves_two_thirds_using_descending_keys() {
+    int order = 4;
+    BPTreeNode *root = BPTree_init(order);
+
+    for (uint64_t key = 1000; key > 0; key--) {
+        BPTree_insert(root, key, transform_key_to_data(key));
+    }
+
+    TEST_ASSERT_TRUE(check_BPTree_compliance(root));
+
+    // A full leaf shares its keys with its full right sibling over three leaves, only the first leaf can be less full.
+    for (BPTreeNode *leaf = BPTree_find_first_leaf(root)->next; leaf != NULL; leaf = leaf->next) {
+        TEST_ASSERT_GREATER_OR_EQUAL((4 * order + 1) / 3, leaf->keys->size);
+    }
+
+    BPTree_destroy(&root);
+}
+
+void test_BPTree_insert_should_fill_the_leaves_using_ascending_keys() {
+    int order = 4;
+    BPTreeNode *root = BPTree_init(order);
+
+    for (uint64_t key = 0; key < 1000; key++) {
+        BPTree_insert(root, key, transform_key_to_data(key));
+    }
+
+    // Deletions and insertions below the greatest key go through the usual path.
+    for (uint64_t key = 0; key < 1000; key += 7) {
+        BPTree_delete(root, key);
+    }
+    for (uint64_t key = 1000; key < 2000; key++) {
+        BPTree_insert(root, key, transform_key_to_data(key));
+    }
+
+    TEST_ASSERT_TRUE(check_BPTree_compliance(root));
+
+    for (uint64_t key = 0; key < 2000; key++) {
+        uint64_t data;
+        TEST_ASSERT_EQUAL(key >= 1000 || key % 7 != 0, BPTree_search(root, key, &data));
+    }
+
+    // The leaves filled by the appends are full, except the last one.
+    for (BPTreeNode *leaf = BPTree_find_first_leaf(root); leaf->next != NULL; leaf = leaf->next) {
+        if (leaf->keys->items[0] >= 1000) {
+            TEST_ASSERT_EQUAL(2 * order, leaf->keys->size);
+        }
+    }
+
+    BPTree_destroy(&root);
+}
+
+// **** END : test_BPTree_compute_shape
+
+// **** BEGIN : test_StaticIndex_search
+
+void test_StaticIndex_search_should_find_the_same_keys_as_the_BPTree_using_BPTree_of_given_order(int order) {
+    int size = 1;
+
+    srand(0);
+
+    // The size of the index goes through 1, 2, 4, ..., 512 so that the implicit tree is full, or not.
+    for (int j = 0; j < 10; j++) {
+        IntegerArray *keys = generate_random_numbers_array(size, RANDOM_MIN, RANDOM_MAX);
+        BPTreeNode *root = BPTree_init(order);
+
+        for (int i = 0; i < keys->size; i++) {
+            BPTree_insert(root, keys->items[i], transform_key_to_data(keys->items[i]));
+        }
+
+        StaticIndex *index = StaticIndex_init(root);
+
+        // Every possible key is searched, the static index must agree with the B+ tree.
+        for (uint64_t key = RANDOM_MIN; key <= RANDOM_MAX; key++) {
+            uint64_t expected_data = 0;
+            uint64_t data = 0;
+            bool is_expected_found = BPTree_search(root, key, &expected_data);
+
+            TEST_ASSERT_EQUAL(is_expected_found, StaticIndex_search(index, key, &data));
+            TEST_ASSERT_EQUAL_UINT64(expected_data, data);
+        }
+
+        StaticIndex_destroy(&index);
+        IntegerArray_destroy(&keys);
+        BPTree_destroy(&root);
+
+        size *= 2;
+    }
+}
+
+void test_StaticIndex_search_should_find_the_same_keys_as_the_BPTree_using_BPTree_of_order_1() {
+    test_StaticIndex_search_should_find_the_same_keys_as_the_BPTree_using_BPTree_of_given_order(1);
+}
+
+void test_StaticIndex_search_should_find_the_same_keys_as_the_BPTree_using_BPTree_of_order_16() {
+    test_StaticIndex_search_should_find_the_same_keys_as_the_BPTree_using_BPTree_of_given_order(16);
+}
+
+// **** END : test_StaticIndex_search
+
+// **** BEGIN : test_HashIndex
+
+void test_HashIndex_should_find_the_same_keys_as_the_BPTree() {
+    srand(0);
+    BPTreeNode *root = BPTree_init(2);
+    HashIndex *index = HashIndex_init(0);
+
+    for (int i = 0; i < SPECIALIZED_OPERATION_COUNT; i++) {
+        uint64_t key = rand() % SPECIALIZED_RANDOM_MAX;
+
+        // 3 insertions for 2 deletions, the table grows and reuses its deleted slots.
+        if (rand() % 5 < 3) {
+            TEST_ASSERT_EQUAL(BPTree_insert(root, key, transform_key_to_data(key)), HashIndex_insert(index, key, transform_key_to_data(key)));
+        } else {
+            TEST_ASSERT_EQUAL(BPTree_delete(root, key), HashIndex_delete(index, key));
+        }
+    }
+
+    for (uint64_t key = 0; key < SPECIALIZED_RANDOM_MAX; key++) {
+        uint64_t expected_data = 0;
+        uint64_t data = 0;
+        bool is_expected_found = BPTree_search(root, key, &expected_data);
+
+        TEST_ASSERT_EQUAL(is_expected_found, HashIndex_search(index, key, &data));
+        TEST_ASSERT_EQUAL_UINT64(expected_data, data);
+    }
+
+    BPTreeShape shape;
+    BPTree_compute_shape(root, &shape);
+    TEST_ASSERT_EQUAL(shape.key_count, index->size);
+    TEST_ASSERT(index->used_count <= index->slot_count / 8 * 7);
+
+    HashIndex_destroy(&index);
+    BPTree_destroy(&root);
+}
+
+// **** END : test_HashIndex
+
+// **** BEGIN : test_RadixTree
+
+/**
+ * @brief Converts an integer into a key of the radix tree. The first byte has 64 values so that the root becomes a
+ * Node256, the rest of the integer is placed at two depths so that the nodes have prefixes of different lengths.
+ *
+ * @param integer The integer.
+ * @return uint64_t The key.
+ */
+static uint64_t integer_to_radix_key(uint64_t integer) {
+    return (integer % 64) << 56 | (integer / 64) << (integer % 2 == 0 ? 8 : 24);
+}
+
+/**
+ * @brief Appends a key visited in the radix tree to an array.
+ *
+ * @param key The key.
+ * @param data The data of the key.
+ * @param context The array.
+ */
+static void append_radix_key(uint64_t key, uint64_t data, void *context) {
+    (void)data;
+    IntegerArray_append((IntegerArray *)context, key);
+}
+
+void test_RadixTree_should_find_the_same_keys_as_the_BPTree() {
+    srand(0);
+    BPTreeNode *root = BPTree_init(2);
+    RadixTree *tree = RadixTree_init();
+
+    for (int i = 0; i < SPECIALIZED_OPERATION_COUNT; i++) {
+        uint64_t key = integer_to_radix_key(rand() % SPECIALIZED_RANDOM_MAX);
+
+        // 3 insertions for 2 deletions, the nodes grow and shrink.
+        if (rand() % 5 < 3) {
+            TEST_ASSERT_EQUAL(BPTree_insert(root, key, transform_key_to_data(key)), RadixTree_insert(tree, key, transform_key_to_data(key)));
+        } else {
+            TEST_ASSERT_EQUAL(BPTree_delete(root, key), RadixTree_delete(tree, key));
+        }
+    }
+
+    for (uint64_t integer = 0; integer < SPECIALIZED_RANDOM_MAX; integer++) {
+        uint64_t key = integer_to_radix_key(integer);
+        uint64_t expected_data = 0;
+        uint64_t data = 0;
+        bool is_expected_found = BPTree_search(root, key, &expected_data);
+
+        TEST_ASSERT_EQUAL(is_expected_found, RadixTree_search(tree, key, &data));
+        TEST_ASSERT_EQUAL_UINT64(expected_data, data);
+    }
+
+    // A range is visited in ascending order, like the leaves of the B+ tree.
+    uint64_t from = integer_to_radix_key(10);
+    uint64_t to = integer_to_radix_key(40 + 64 * 100);
+    IntegerArray *keys = IntegerArray_init(SPECIALIZED_RANDOM_MAX);
+    RadixTree_for_each_range(tree, from, to, append_radix_key, keys);
+
+    int i = 0;
+    for (BPTreeNode *leaf = BPTree_find_first_leaf(root); leaf != NULL; leaf = leaf->next) {
+        for (int j = 0; j < leaf->keys->size; j++) {
+            if (leaf->keys->items[j] >= from && leaf->keys->items[j] <= to) {
+                TEST_ASSERT(i < keys->size);
+                TEST_ASSERT_EQUAL_UINT64(leaf->keys->items[j], keys->items[i]);
+                i++;
+            }
+        }
+    }
+
+    TEST_ASSERT_EQUAL(keys->size, i);
+
+    BPTreeShape shape;
+    BPTree_compute_shape(root, &shape);
+    TEST_ASSERT_EQUAL(shape.key_count, tree->size);
+
+    IntegerArray_destroy(&keys);
+    RadixTree_destroy(&tree);
+    BPTree_destroy(&root);
+}
+
+// **** END : test_RadixTree
+
+// **** BEGIN : test_specialized_BPTree
+
+/**
+ * @brief Converts an integer into a 16-byte key, the integers are not in the same order as the keys so that both
+ * halves of the keys are compared.
+ *
+ * @param integer The integer.
+ * @return Key128 The key.
+ */
+static Key128 integer_to_Key128(uint64_t integer) {
+    return (Key128){integer % 7, integer};
+}
+
+void test_U32Tree_should_find_the_same_keys_as_the_BPTree() {
+    srand(0);
+    BPTreeNode *root = BPTree_init(2);
+    U32TreeNode *specialized_root = U32Tree_init();
+
+    for (int i = 0; i < SPECIALIZED_OPERATION_COUNT; i++) {
+        uint32_t key = rand() % SPECIALIZED_RANDOM_MAX;
+
+        // 3 insertions for 2 deletions, the B+ trees grow while keys are deleted.
+        if (rand() % 5 < 3) {
+            TEST_ASSERT_EQUAL(BPTree_insert(root, key, transform_key_to_data(key)), U32Tree_insert(specialized_root, key, transform_key_to_data(key)));
+        } else {
+            TEST_ASSERT_EQUAL(BPTree_delete(root, key), U32Tree_delete(specialized_root, key));
+        }
+    }
+
+    for (uint32_t key = 0; key < SPECIALIZED_RANDOM_MAX; key++) {
+        uint64_t expected_data = 0;
+        uint32_t data = 0;
+        bool is_expected_found = BPTree_search(root, key, &expected_data);
+
+        TEST_ASSERT_EQUAL(is_expected_found, U32Tree_search(specialized_root, key, &data));
+        TEST_ASSERT_EQUAL_UINT32((uint32_t)expected_data, data);
+    }
+
+    // The leaves are chained in order and hold as many keys as the B+ tree, each one at least half full.
+    int key_count = 0;
+    for (U32TreeNode *leaf = U32Tree_find_first_leaf(specialized_root); leaf != NULL; leaf = leaf->next) {
+        TEST_ASSERT(leaf == specialized_root || leaf->size >= U32Tree_ORDER);
+
+        for (int i = 0; i < leaf->size; i++) {
+            TEST_ASSERT(i == 0 || leaf->keys[i - 1] < leaf->keys[i]);
+            TEST_ASSERT(leaf->next == NULL || leaf->keys[i] < leaf->next->keys[0]);
+        }
+
+        key_count += leaf->size;
+    }
+
+    BPTreeShape shape;
+    BPTree_compute_shape(root, &shape);
+    TEST_ASSERT_EQUAL(shape.key_count, key_count);
+
+    U32Tree_destroy(&specialized_root);
+    BPTree_destroy(&root);
+}
+
+void test_Key128Tree_should_find_the_same_keys_as_the_BPTree() {
+    srand(1);
+    BPTreeNode *root = BPTree_init(2);
+    Key128TreeNode *specialized_root = Key128Tree_init();
+
+    for (int i = 0; i < SPECIALIZED_OPERATION_COUNT; i++) {
+        uint64_t key = rand() % SPECIALIZED_RANDOM_MAX;
+
+        if (rand() % 5 < 3) {
+            TEST_ASSERT_EQUAL(BPTree_insert(root, key, transform_key_to_data(key)), Key128Tree_insert(specialized_root, integer_to_Key128(key), transform_key_to_data(key)));
+        } else {
+            TEST_ASSERT_EQUAL(BPTree_delete(root, key), Key128Tree_delete(specialized_root, integer_to_Key128(key)));
+        }
+    }
+
+    for (uint64_t key = 0; key < SPECIALIZED_RANDOM_MAX; key++) {
+        uint64_t expected_data = 0;
+        uint64_t data = 0;
+        bool is_expected_found = BPTree_search(root, key, &expected_data);
+
+        TEST_ASSERT_EQUAL(is_expected_found, Key128Tree_search(specialized_root, integer_to_Key128(key), &data));
+        TEST_ASSERT_EQUAL_UINT64(expected_data, data);
+    }
+
+    Key128Tree_destroy(&specialized_root);
+    BPTree_destroy(&root);
+}
+
+void test_DateTree_should_store_the_data_inline() {
+    DateTreeNode *root = DateTree_init();
+
+    for (uint32_t key = 0; key < RANDOM_MAX; key++) {
+        TEST_ASSERT(DateTree_insert(root, key, (Date){1900 + key % 100, 1 + key % 12, 1 + key % 28}));
+    }
+
+    // The data of an existing key is only replaced by an upsert.
+    TEST_ASSERT_FALSE(DateTree_insert(root, 42, (Date){2000, 1, 1}));
+    TEST_ASSERT_FALSE(DateTree_upsert(root, 43, (Date){2000, 1, 1}));
+
+    for (uint32_t key = 0; key < RANDOM_MAX; key++) {
+        Date date;
+        TEST_ASSERT(DateTree_search(root, key, &date));
+        TEST_ASSERT_EQUAL(key == 43 ? 2000 : (int)(1900 + key % 100), date.year);
+        TEST_ASSERT_EQUAL(key == 43 ? 1 : (int)(1 + key % 12), date.month);
+        TEST_ASSERT_EQUAL(key == 43 ? 1 : (int)(1 + key % 28), date.day);
+    }
+
+    DateTree_destroy(&root);
+}
+
+// **** END : test_specialized_BPTree
+
+// **** BEGIN : test_BloomFilter
+
+#define BLOOM_FILTER_TEST_KEY_COUNT 6553
+#define BLOOM_FILTER_TEST_PROBE_COUNT 200000
+
+/**
+ * @brief Generates the i-th key added to the filters of the tests, the odd multipliers keep the keys distinct.
+ *
+ * @param i The number of the key.
+ * @return uint64_t The key, its low bit is 0.
+ */
+static uint64_t generate_bloom_filter_key(uint64_t i) {
+    return (i * 0x9e3779b97f4a7c15LLU) << 1;
+}
+
+void test_BloomFilter_may_contain_should_find_every_added_key() {
+    BloomFilter *filter = BloomFilter_init(BLOOM_FILTER_TEST_KEY_COUNT);
+
+    for (int i = 0; i < BLOOM_FILTER_TEST_KEY_COUNT; i++) {
+        BloomFilter_add(filter, generate_bloom_filter_key(i));
+    }
+
+    for (int i = 0; i < BLOOM_FILTER_TEST_KEY_COUNT; i++) {
+        TEST_ASSERT_TRUE(BloomFilter_may_contain(filter, generate_bloom_filter_key(i)));
+    }
+
+    TEST_ASSERT_EQUAL(BLOOM_FILTER_TEST_KEY_COUNT, filter->size);
+    BloomFilter_destroy(&filter);
+}
+
+void test_BloomFilter_may_contain_should_keep_the_false_positive_rate_near_its_target() {
+    // 6553 keys of 10 bits are 65530 bits, so the filter has about BLOOM_FILTER_BITS_PER_ITEM bits per key.
+    BloomFilter *filter = BloomFilter_init(BLOOM_FILTER_TEST_KEY_COUNT);
+
+    for (int i = 0; i < BLOOM_FILTER_TEST_KEY_COUNT; i++) {
+        BloomFilter_add(filter, generate_bloom_filter_key(i));
+    }
+
+    int false_positive_count = 0;
+    for (int i = 0; i < BLOOM_FILTER_TEST_PROBE_COUNT; i++) {
+        // The keys that have not been added are odd.
+        false_positive_count += BloomFilter_may_contain(filter, generate_bloom_filter_key(i) | 1);
+    }
+
+    // The expected rate of a Bloom filter of m bits with k hashes that holds n keys: (1 - e^(-k * n / m))^k.
+    double bit_count = (double)(filter->mask + 1);
+    double target = pow(1 - exp(-BLOOM_FILTER_HASH_COUNT * BLOOM_FILTER_TEST_KEY_COUNT / bit_count), BLOOM_FILTER_HASH_COUNT);
+    double rate = (double)false_positive_count / BLOOM_FILTER_TEST_PROBE_COUNT;
+
+    TEST_ASSERT_TRUE(rate < 2 * target);
+    TEST_ASSERT_TRUE(rate > target / 2);
+    BloomFilter_destroy(&filter);
+}
+
+// **** END : test_BloomFilter
+
+// **** BEGIN : test_ColumnStore
+
+// Two scan blocks, the last one is not a multiple of the 4 dates compared at once.
+#define COLUMN_STORE_TEST_RECORD_COUNT (COLUMN_STORE_SCAN_BLOCK_SIZE + 7)
+
+/**
+ * @brief Creates an empty column store whose files are in the temporary directory.
+ *
+ * @return ColumnStore* The empty store.
+ */
+static ColumnStore *create_empty_column_store() {
+    char name[COLUMN_STORE_FILENAME_MAXLEN] = "/tmp/BPTreeTests_column_store";
+    ColumnStore *store = ColumnStore_init(name);
+    ColumnStore_clear(store);
+    return store;
+}
+
+/**
+ * @brief Generates the birth date of the record of a slot, the dates go back and forth so that they are not sorted.
+ *
+ * @param slot The slot of the record.
+ * @return Date The birth date.
+ */
+static Date generate_column_store_birth_date(int slot) {
+    return (Date){1950 + (slot * 7) % 70, 1 + (slot * 5) % 12, 1 + (slot * 3) % 28};
+}
+
+/**
+ * @brief Creates a column store with COLUMN_STORE_TEST_RECORD_COUNT records, every tenth one is deleted.
+ *
+ * @return ColumnStore* The store.
+ */
+static ColumnStore *create_column_store() {
+    ColumnStore *store = create_empty_column_store();
+    DirectoryRecord **records = (DirectoryRecord **)malloc(sizeof(DirectoryRecord *) * COLUMN_STORE_TEST_RECORD_COUNT);
+    char name[NAME_MAXLEN] = "Name";
+    char surnames[2][SURNAME_MAXLEN] = {"Smith", "Doe"};
+
+    for (int i = 0; i < COLUMN_STORE_TEST_RECORD_COUNT; i++) {
+        char phone_number[PHONE_NUMBER_MAXLEN];
+        snprintf(phone_number, sizeof(phone_number), "%010d", i);
+        Date birth_date = generate_column_store_birth_date(i);
+        records[i] = DirectoryRecord_init(false, phone_number, name, surnames[i % 3 == 0 ? 0 : 1], birth_date.year, birth_date.month, birth_date.day);
+    }
+
+    ColumnStore_append_batch(store, records, COLUMN_STORE_TEST_RECORD_COUNT);
+
+    for (int i = 0; i < COLUMN_STORE_TEST_RECORD_COUNT; i++) {
+        DirectoryRecord_destroy(&records[i]);
+
+        if (i % 10 == 0) {
+            ColumnStore_delete(store, i);
+        }
+    }
+
+    free(records);
+    return store;
+}
+
+/**
+ * @brief Checks the count and the selection of the records born between two dates against a scan done one record at
+ * a time.
+ *
+ * @param store The store created by create_column_store.
+ * @param from The first date, included.
+ * @param to The last date, included.
+ */
+static void check_born_between(ColumnStore *store, uint32_t from, uint32_t to) {
+    IntegerArray *expected_slots = IntegerArray_init(COLUMN_STORE_TEST_RECORD_COUNT);
+
+    for (int i = 0; i < COLUMN_STORE_TEST_RECORD_COUNT; i++) {
+        Date birth_date = generate_column_store_birth_date(i);
+        uint32_t packed_birth_date = ColumnStore_pack_birth_date(birth_date.year, birth_date.month, birth_date.day);
+
+        if (i % 10 != 0 && packed_birth_date >= from && packed_birth_date <= to) {
+            IntegerArray_append(expected_slots, i);
+        }
+    }
+
+    IntegerArray *slots = ColumnStore_select_born_between(store, from, to);
+    TEST_ASSERT_EQUAL(expected_slots->size, ColumnStore_count_born_between(store, from, to));
+    TEST_ASSERT_EQUAL(expected_slots->size, slots->size);
+
+    for (int i = 0; i < slots->size; i++) {
+        TEST_ASSERT_EQUAL_UINT64(expected_slots->items[i], slots->items[i]);
+    }
+
+    IntegerArray_destroy(&expected_slots);
+    IntegerArray_destroy(&slots);
+}
+
+void test_ColumnStore_born_between_should_find_the_same_records_as_a_scan_one_record_at_a_time() {
+    ColumnStore *store = create_column_store();
+    TEST_ASSERT_EQUAL(COLUMN_STORE_TEST_RECORD_COUNT, store->size);
+
+    check_born_between(store, ColumnStore_pack_birth_date(1960, 1, 1), ColumnStore_pack_birth_date(1979, 12, 31));
+    check_born_between(store, ColumnStore_pack_birth_date(1990, 6, 15), ColumnStore_pack_birth_date(1990, 6, 15));
+    check_born_between(store, 0, UINT32_MAX);
+
+    ColumnStore_clear(store);
+    ColumnStore_destroy(&store);
+}
+
+void test_ColumnStore_born_between_should_include_the_boundary_dates() {
+    ColumnStore *store = create_column_store();
+
+    // The slot 1 is born at the first date tested, the slot 0 is deleted.
+    Date first = generate_column_store_birth_date(1);
+    uint32_t packed_first = ColumnStore_pack_birth_date(first.year, first.month, first.day);
+    Date deleted = generate_column_store_birth_date(0);
+    uint32_t packed_deleted = ColumnStore_pack_birth_date(deleted.year, deleted.month, deleted.day);
+
+    check_born_between(store, packed_first, packed_first);
+    check_born_between(store, packed_first - 1, packed_first);
+    check_born_between(store, packed_first, packed_first + 1);
+    check_born_between(store, packed_first + 1, UINT32_MAX);
+    check_born_between(store, 0, packed_first - 1);
+    check_born_between(store, packed_deleted, packed_deleted);
+
+    // The last date is clamped to BIRTH_DATE_MAX, so that "to + 1" cannot overflow in the comparisons.
+    check_born_between(store, packed_first, 0x7fffffff);
+    check_born_between(store, packed_first, 0x80000000);
+
+    // The first date comes after the last one.
+    TEST_ASSERT_EQUAL(0, ColumnStore_count_born_between(store, packed_first + 1, packed_first));
+    TEST_ASSERT_EQUAL(0, ColumnStore_count_born_between(store, UINT32_MAX, UINT32_MAX));
+
+    ColumnStore_clear(store);
+    ColumnStore_destroy(&store);
+}
+
+void test_ColumnStore_should_leave_out_the_deleted_records() {
+    ColumnStore *store = create_column_store();
+    char surname[SURNAME_MAXLEN] = "Smith";
+    int smith_count = 0;
+
+    for (int i = 0; i < COLUMN_STORE_TEST_RECORD_COUNT; i++) {
+        smith_count += i % 3 == 0 && i % 10 != 0;
+    }
+
+    IntegerArray *slots = ColumnStore_select_by_surname(store, surname);
+    TEST_ASSERT_EQUAL(smith_count, slots->size);
+
+    for (int i = 0; i < slots->size; i++) {
+        TEST_ASSERT_TRUE(slots->items[i] % 3 == 0 && slots->items[i] % 10 != 0);
+    }
+
+    IntegerArray_destroy(&slots);
+
+    // A record deleted in the last block, in the records that are not compared 4 at a time.
+    int last_slot = COLUMN_STORE_TEST_RECORD_COUNT - 1;
+    Date birth_date = generate_column_store_birth_date(last_slot);
+    uint32_t packed_birth_date = ColumnStore_pack_birth_date(birth_date.year, birth_date.month, birth_date.day);
+    int count = ColumnStore_count_born_between(store, packed_birth_date, packed_birth_date);
+
+    ColumnStore_delete(store, last_slot);
+    TEST_ASSERT_EQUAL(count - 1, ColumnStore_count_born_between(store, packed_birth_date, packed_birth_date));
+
+    DirectoryRecord *record = ColumnStore_read(store, last_slot);
+    TEST_ASSERT_TRUE(record->is_deleted);
+    DirectoryRecord_destroy(&record);
+
+    ColumnStore_clear(store);
+    ColumnStore_destroy(&store);
+}
+
+void test_ColumnStore_should_find_nothing_in_an_empty_store() {
+    ColumnStore *store = create_empty_column_store();
+    char surname[SURNAME_MAXLEN] = "Smith";
+    TEST_ASSERT_EQUAL(0, store->size);
+    TEST_ASSERT_EQUAL(0, ColumnStore_count_born_between(store, 0, UINT32_MAX));
+
+    IntegerArray *slots = ColumnStore_select_born_between(store, 0, UINT32_MAX);
+    TEST_ASSERT_EQUAL(0, slots->size);
+    IntegerArray_destroy(&slots);
+
+    slots = ColumnStore_select_by_surname(store, surname);
+    TEST_ASSERT_EQUAL(0, slots->size);
+    IntegerArray_destroy(&slots);
+
+    ColumnStore_destroy(&store);
+}
+
+// **** END : test_ColumnStore
+
+// **** BEGIN : test_Crc32c
+
+void test_Crc32c_compute_should_give_the_check_value_of_CRC32C() {
+    uint8_t bytes[] = "123456789";
+
+    TEST_ASSERT_EQUAL_HEX32(0xE3069283, Crc32c_compute(bytes, 9));
+    TEST_ASSERT_EQUAL_HEX32(0xE3069283, Crc32c_update_with_table(0, bytes, 9));
+    TEST_ASSERT_EQUAL_HEX32(0xE3069283, Crc32c_update(Crc32c_compute(bytes, 4), bytes + 4, 5));
+    TEST_ASSERT_EQUAL_HEX32(0, Crc32c_compute(bytes, 0));
+}
+
+void test_Crc32c_compute_should_give_the_same_checksum_as_the_lookup_table_using_unaligned_bytes() {
+    // 8 more bytes so that every size can start at every offset within a word.
+    uint8_t bytes[64 + 8];
+
+    for (int i = 0; i < (int)sizeof(bytes); i++) {
+        bytes[i] = (uint8_t)(i * 167 + 13);
+    }
+
+    for (int offset = 0; offset < 8; offset++) {
+        for (int size = 0; size <= 64; size++) {
+            TEST_ASSERT_EQUAL_HEX32(Crc32c_update_with_table(0, bytes + offset, size), Crc32c_compute(bytes + offset, size));
+        }
+    }
+}
+
+// **** END : test_Crc32c
+
+// **** BEGIN : test_Bitmap
+
+#define BITMAP_TEST_SIZE 1000
+#define BITMAP_TEST_OPERATION_COUNT 10000
+
+/**
+ * @brief Checks every bit of a bitmap and its count against an array of booleans.
+ *
+ * @param bitmap The bitmap.
+ * @param expected_bits The expected value of each bit.
+ */
+static void check_bitmap(Bitmap *bitmap, bool *expected_bits) {
+    int count = 0;
+
+    for (int i = 0; i < bitmap->size; i++) {
+        TEST_ASSERT_EQUAL(expected_bits[i], Bitmap_get(bitmap, i));
+        count += expected_bits[i];
+    }
+
+    TEST_ASSERT_EQUAL(count, Bitmap_count(bitmap));
+}
+
+void test_Bitmap_set_and_clear_should_change_only_the_given_bit() {
+    Bitmap *bitmap = Bitmap_init(BITMAP_TEST_SIZE);
+    bool expected_bits[BITMAP_TEST_SIZE] = {false};
+    check_bitmap(bitmap, expected_bits);
+
+    for (int i = 0; i < BITMAP_TEST_OPERATION_COUNT; i++) {
+        int index = rand() % BITMAP_TEST_SIZE;
+
+        if (rand() % 2 == 0) {
+            Bitmap_set(bitmap, index);
+            expected_bits[index] = true;
+        } else {
+            Bitmap_clear(bitmap, index);
+            expected_bits[index] = false;
+        }
+    }
+
+    check_bitmap(bitmap, expected_bits);
+    Bitmap_destroy(&bitmap);
+}
+
+void test_Bitmap_resize_should_clear_the_bits_across_word_boundaries() {
+    Bitmap *bitmap = Bitmap_init(0);
+    bool expected_bits[BITMAP_TEST_SIZE] = {false};
+
+    // The bitmap grows one bit at a time past several words, and past its initial capacity.
+    for (int size = 1; size <= 200; size++) {
+        Bitmap_resize(bitmap, size);
+        TEST_ASSERT_FALSE(Bitmap_get(bitmap, size - 1));
+        Bitmap_set(bitmap, size - 1);
+        expected_bits[size - 1] = true;
+    }
+
+    check_bitmap(bitmap, expected_bits);
+
+    // The bits removed by a shrink are 0 once the bitmap grows again.
+    Bitmap_resize(bitmap, 63);
+    Bitmap_resize(bitmap, BITMAP_TEST_SIZE);
+    memset(expected_bits + 63, false, BITMAP_TEST_SIZE - 63);
+    check_bitmap(bitmap, expected_bits);
+
+    // Setting a byte past the end grows the bitmap to the end of that byte.
+    Bitmap_set_byte(bitmap, 200, 0x81);
+    TEST_ASSERT_EQUAL(8 * 201, bitmap->size);
+    TEST_ASSERT_EQUAL_HEX8(0x81, Bitmap_get_byte(bitmap, 200));
+    TEST_ASSERT_TRUE(Bitmap_get(bitmap, 1600));
+    TEST_ASSERT_TRUE(Bitmap_get(bitmap, 1607));
+    TEST_ASSERT_EQUAL(63 + 2, Bitmap_count(bitmap));
+
+    Bitmap_destroy(&bitmap);
+}
+
+void test_Bitmap_find_next_set_should_find_the_first_free_slot() {
+    // Like the tombstones of a directory, a set bit is a free slot.
+    Bitmap *bitmap = Bitmap_init(BITMAP_TEST_SIZE);
+    TEST_ASSERT_EQUAL(-1, Bitmap_find_next_set(bitmap, 0));
+    TEST_ASSERT_EQUAL(0, Bitmap_find_next_clear(bitmap, 0));
+
+    int free_slots[] = {63, 64, 127, 500, BITMAP_TEST_SIZE - 1};
+    int free_slot_count = (int)(sizeof(free_slots) / sizeof(free_slots[0]));
+
+    for (int i = 0; i < free_slot_count; i++) {
+        Bitmap_set(bitmap, free_slots[i]);
+    }
+
+    // Each free slot is found from any index between the previous one and itself.
+    for (int i = 0; i < free_slot_count; i++) {
+        int from = i == 0 ? 0 : free_slots[i - 1] + 1;
+
+        for (int j = from; j <= free_slots[i]; j++) {
+            TEST_ASSERT_EQUAL(free_slots[i], Bitmap_find_next_set(bitmap, j));
+        }
+    }
+
+    TEST_ASSERT_EQUAL(-1, Bitmap_find_next_set(bitmap, BITMAP_TEST_SIZE));
+
+    // The free slots are reused one by one, the lowest first.
+    for (int i = 0; i < free_slot_count; i++) {
+        int slot = Bitmap_find_next_set(bitmap, 0);
+        TEST_ASSERT_EQUAL(free_slots[i], slot);
+        Bitmap_clear(bitmap, slot);
+    }
+
+    TEST_ASSERT_EQUAL(-1, Bitmap_find_next_set(bitmap, 0));
+
+    // The bits beyond the size are never found.
+    Bitmap_set_byte(bitmap, 0, 0xFF);
+    Bitmap_resize(bitmap, 4);
+    TEST_ASSERT_EQUAL(-1, Bitmap_find_next_clear(bitmap, 0));
+    Bitmap_resize(bitmap, 64);
+    TEST_ASSERT_EQUAL(-1, Bitmap_find_next_set(bitmap, 4));
+    TEST_ASSERT_EQUAL(4, Bitmap_find_next_clear(bitmap, 0));
+
+    Bitmap_destroy(&bitmap);
+}
+
+// **** END : test_Bitmap
+
+// **** BEGIN : test_RecordCache
+
+// Each shard of the caches of the tests holds 10 records, 1 of them in the small queue.
+#define RECORD_CACHE_TEST_SHARD_CAPACITY 10
+#define RECORD_CACHE_TEST_CAPACITY (RECORD_CACHE_TEST_SHARD_CAPACITY * RECORD_CACHE_SHARD_COUNT)
+
+/**
+ * @brief Creates the record put in the caches of the tests under a key, its phone number is the key.
+ *
+ * @param key The key.
+ * @return DirectoryRecord* The record.
+ */
+static DirectoryRecord *create_cache_record(uint64_t key) {
+    char phone_number[PHONE_NUMBER_MAXLEN];
+    char name[NAME_MAXLEN] = "Name";
+    char surname[SURNAME_MAXLEN] = "Surname";
+    snprintf(phone_number, sizeof(phone_number), "%010" PRIu64, key);
+    return DirectoryRecord_init(false, phone_number, name, surname, 2000, 1, 1);
+}
+
+/**
+ * @brief Puts the record of a key in a cache.
+ *
+ * @param cache The cache.
+ * @param key The key.
+ */
+static void put_cache_record(RecordCache *cache, uint64_t key) {
+    DirectoryRecord *record = create_cache_record(key);
+    RecordCache_put(cache, key, record);
+    DirectoryRecord_destroy(&record);
+}
+
+/**
+ * @brief Checks whether the record of a key is in a cache, a hit or a miss is counted.
+ *
+ * @param cache The cache.
+ * @param key The key.
+ * @return true The record of the key is in the cache.
+ * @return false The record of the key is not in the cache.
+ */
+static bool is_in_cache(RecordCache *cache, uint64_t key) {
+    DirectoryRecord *record = RecordCache_get(cache, key);
+
+    if (record == NULL) {
+        return false;
+    }
+
+    char phone_number[PHONE_NUMBER_MAXLEN];
+    snprintf(phone_number, sizeof(phone_number), "%010" PRIu64, key);
+    TEST_ASSERT_EQUAL_STRING(phone_number, record->phone_number);
+    DirectoryRecord_destroy(&record);
+    return true;
+}
+
+void test_RecordCache_should_keep_the_last_records_and_count_the_hits_and_misses() {
+    RecordCache *cache = RecordCache_init(RECORD_CACHE_TEST_CAPACITY);
+    // 3 times the capacity, spread over all the shards.
+    uint64_t key_count = 3 * RECORD_CACHE_TEST_CAPACITY;
+
+    for (uint64_t key = 0; key < key_count; key++) {
+        put_cache_record(cache, key);
+    }
+
+    // None of the records has been accessed, so the last ones put in each shard are kept.
+    for (uint64_t key = 0; key < key_count; key++) {
+        TEST_ASSERT_EQUAL(key >= key_count - RECORD_CACHE_TEST_CAPACITY, is_in_cache(cache, key));
+    }
+
+    uint64_t hit_count, miss_count;
+    RecordCache_get_counters(cache, &hit_count, &miss_count);
+    TEST_ASSERT_EQUAL_UINT64(RECORD_CACHE_TEST_CAPACITY, hit_count);
+    TEST_ASSERT_EQUAL_UINT64(key_count - RECORD_CACHE_TEST_CAPACITY, miss_count);
+
+    RecordCache_destroy(&cache);
+}
+
+void test_RecordCache_put_should_replace_an_invalidated_record() {
+    RecordCache *cache = RecordCache_init(RECORD_CACHE_TEST_CAPACITY);
+    DirectoryRecord *record = create_cache_record(0);
+
+    // The invalidated entries stay in their queue, they must not prevent the key from being put again.
+    for (int i = 0; i < 3 * RECORD_CACHE_TEST_SHARD_CAPACITY; i++) {
+        record->birth_date_year = 2000 + i;
+        RecordCache_put(cache, 0, record);
+
+        DirectoryRecord *cached_record = RecordCache_get(cache, 0);
+        TEST_ASSERT_NOT_NULL(cached_record);
+        TEST_ASSERT_EQUAL(2000 + i, cached_record->birth_date_year);
+        DirectoryRecord_destroy(&cached_record);
+
+        RecordCache_invalidate(cache, 0);
+        TEST_ASSERT_FALSE(is_in_cache(cache, 0));
+    }
+
+    // The other records of the shard go through the queues that held the invalidated entries.
+    for (uint64_t key = RECORD_CACHE_SHARD_COUNT; key <= RECORD_CACHE_TEST_SHARD_CAPACITY * RECORD_CACHE_SHARD_COUNT; key += RECORD_CACHE_SHARD_COUNT) {
+        put_cache_record(cache, key);
+        TEST_ASSERT_TRUE(is_in_cache(cache, key));
+    }
+
+    RecordCache_put(cache, 0, record);
+    TEST_ASSERT_TRUE(is_in_cache(cache, 0));
+
+    DirectoryRecord_destroy(&record);
+    RecordCache_destroy(&cache);
+}
+
+void test_RecordCache_put_should_keep_a_ghost_key_through_a_scan() {
+    RecordCache *cache = RecordCache_init(RECORD_CACHE_TEST_CAPACITY);
+    // All the keys are multiples of the number of shards so that they fall into the same shard.
+    uint64_t hot_key = 0;
+    put_cache_record(cache, hot_key);
+
+    // The key leaves the small queue without having been accessed, it is remembered as a ghost.
+    for (uint64_t i = 1; i <= RECORD_CACHE_TEST_SHARD_CAPACITY; i++) {
+        put_cache_record(cache, i * RECORD_CACHE_SHARD_COUNT);
+    }
+
+    TEST_ASSERT_FALSE(is_in_cache(cache, hot_key));
+
+    // The key comes back, it goes straight to the main queue.
+    put_cache_record(cache, hot_key);
+
+    // Records accessed only once pass through the small queue without evicting it.
+    uint64_t scan_start = RECORD_CACHE_TEST_SHARD_CAPACITY + 1;
+    uint64_t scan_end = scan_start + 10 * RECORD_CACHE_TEST_SHARD_CAPACITY;
+
+    for (uint64_t i = scan_start; i < scan_end; i++) {
+        put_cache_record(cache, i * RECORD_CACHE_SHARD_COUNT);
+    }
+
+    TEST_ASSERT_TRUE(is_in_cache(cache, hot_key));
+    TEST_ASSERT_FALSE(is_in_cache(cache, scan_start * RECORD_CACHE_SHARD_COUNT));
+    TEST_ASSERT_TRUE(is_in_cache(cache, (scan_end - 1) * RECORD_CACHE_SHARD_COUNT));
+
+    RecordCache_destroy(&cache);
+}
+
+// **** END : test_RecordCache
+
+// END : Tests
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_BPTree_insert_should_comply_with_BPTree_rules_using_BPTree_of_order_1);
+    RUN_TEST(test_BPTree_insert_should_comply_with_BPTree_rules_using_BPTree_of_order_2);
+    RUN_TEST(test_BPTree_insert_should_comply_with_BPTree_rules_using_BPTree_of_order_3);
+    RUN_TEST(test_BPTree_insert_should_comply_with_BPTree_rules_using_BPTree_of_order_4);
+    RUN_TEST(test_BPTree_insert_should_comply_with_BPTree_rules_using_BPTree_of_order_8);
+    RUN_TEST(test_BPTree_insert_should_comply_with_BPTree_rules_using_BPTree_of_order_16);
+
+    RUN_TEST(test_BPTree_delete_should_comply_with_BPTree_rules_using_BPTree_of_order_1);
+    RUN_TEST(test_BPTree_delete_should_comply_with_BPTree_rules_using_BPTree_of_order_2);
+    RUN_TEST(test_BPTree_delete_should_comply_with_BPTree_rules_using_BPTree_of_order_3);
+    RUN_TEST(test_BPTree_delete_should_comply_with_BPTree_rules_using_BPTree_of_order_4);
+    RUN_TEST(test_BPTree_delete_should_comply_with_BPTree_rules_using_BPTree_of_order_8);
+    RUN_TEST(test_BPTree_delete_should_comply_with_BPTree_rules_using_BPTree_of_order_16);
+
+    RUN_TEST(test_BPTree_search_should_find_the_keys_that_exist_in_the_BPTree_using_BPTree_of_order_1);
+    RUN_TEST(test_BPTree_search_should_find_the_keys_that_exist_in_the_BPTree_using_BPTree_of_order_2);
+    RUN_TEST(test_BPTree_search_should_find_the_keys_that_exist_in_the_BPTree_using_BPTree_of_order_3);
+    RUN_TEST(test_BPTree_search_should_find_the_keys_that_exist_in_the_BPTree_using_BPTree_of_order_4);
+    RUN_TEST(test_BPTree_search_should_find_the_keys_that_exist_in_the_BPTree_using_BPTree_of_order_8);
+    RUN_TEST(test_BPTree_search_should_find_the_keys_that_exist_in_the_BPTree_using_BPTree_of_order_16);
+
+    RUN_TEST(test_BPTree_upsert_should_replace_the_data_of_existing_keys_using_BPTree_of_order_1);
+    RUN_TEST(test_BPTree_upsert_should_replace_the_data_of_existing_keys_using_BPTree_of_order_2);
+    RUN_TEST(test_BPTree_upsert_should_replace_the_data_of_existing_keys_using_BPTree_of_order_3);
+    RUN_TEST(test_BPTree_upsert_should_replace_the_data_of_existing_keys_using_BPTree_of_order_4);
+    RUN_TEST(test_BPTree_upsert_should_replace_the_data_of_existing_keys_using_BPTree_of_order_8);
+    RUN_TEST(test_BPTree_upsert_should_replace_the_data_of_existing_keys_using_BPTree_of_order_16);
+
+    RUN_TEST(test_BPTree_insert_batch_should_insert_the_keys_that_do_not_exist_using_BPTree_of_order_1);
+    RUN_TEST(test_BPTree_insert_batch_should_insert_the_keys_that_do_not_exist_using_BPTree_of_order_2);
+    RUN_TEST(test_BPTree_insert_batch_should_insert_the_keys_that_do_not_exist_using_BPTree_of_order_3);
+    RUN_TEST(test_BPTree_insert_batch_should_insert_the_keys_that_do_not_exist_using_BPTree_of_order_4);
+    RUN_TEST(test_BPTree_insert_batch_should_insert_the_keys_that_do_not_exist_using_BPTree_of_order_8);
+    RUN_TEST(test_BPTree_insert_batch_should_insert_the_keys_that_do_not_exist_using_BPTree_of_order_16);
+
+    RUN_TEST(test_BPTree_bulk_load_should_comply_with_BPTree_rules_using_BPTree_of_order_1);
+    RUN_TEST(test_BPTree_bulk_load_should_comply_with_BPTree_rules_using_BPTree_of_order_2);
+
+    RUN_TEST(test_BPTreeWriteBatch_should_find_the_same_keys_as_the_BPTree_using_BPTree_of_order_1);
+    RUN_TEST(test_BPTreeWriteBatch_should_find_the_same_keys_as_the_BPTree_using_BPTree_of_order_16);
+
+    RUN_TEST(test_BPTree_init_in_arena_should_find_the_same_keys_as_the_BPTree_using_small_pages);
+    RUN_TEST(test_BPTree_init_in_arena_should_find_the_same_keys_as_the_BPTree_using_huge_pages);
+
+    RUN_TEST(test_BPTree_compute_shape_should_match_the_structure_of_the_BPTree);
+    RUN_TEST(test_BPTree_insert_should_fill_the_leaves_two_thirds_using_descending_keys);
+    RUN_TEST(test_BPTree_insert_should_fill_the_leaves_using_ascending_keys);
+
+    RUN_TEST(test_StaticIndex_search_should_find_the_same_keys_as_the_BPTree_using_BPTree_of_order_1);
+    RUN_TEST(test_StaticIndex_search_should_find_the_same_keys_as_the_BPTree_using_BPTree_of_order_16);
+
+    RUN_TEST(test_HashIndex_should_find_the_same_keys_as_the_BPTree);
+    RUN_TEST(test_RadixTree_should_find_the_same_keys_as_the_BPTree);
+
+    RUN_TEST(test_U32Tree_should_find_the_same_keys_as_the_BPTree);
+    RUN_TEST(test_Key128Tree_should_find_the_same_keys_as_the_BPTree);
+    RUN_TEST(test_DateTree_should_store_the_data_inline);
+
+
+    RUN_TEST(test_BloomFilter_may_contain_should_find_every_added_key);
+    RUN_TEST(test_BloomFilter_may_contain_should_keep_the_false_positive_rate_near_its_target);
+
+
+    RUN_TEST(test_ColumnStore_born_between_should_find_the_same_records_as_a_scan_one_record_at_a_time);
+    RUN_TEST(test_ColumnStore_born_between_should_include_the_boundary_dates);
+    RUN_TEST(test_ColumnStore_should_leave_out_the_deleted_records);
+    RUN_TEST(test_ColumnStore_should_find_nothing_in_an_empty_store);
+
+
+    RUN_TEST(test_Crc32c_compute_should_give_the_check_value_of_CRC32C);
+    RUN_TEST(test_Crc32c_compute_should_give_the_same_checksum_as_the_lookup_table_using_unaligned_bytes);
+
+
+    RUN_TEST(test_Bitmap_set_and_clear_should_change_only_the_given_bit);
+    RUN_TEST(test_Bitmap_resize_should_clear_the_bits_across_word_boundaries);
+    RUN_TEST(test_Bitmap_find_next_set_should_find_the_first_free_slot);
+
+
+    RUN_TEST(test_RecordCache_should_keep_the_last_records_and_count_the_hits_and_misses);
+    RUN_TEST(test_RecordCache_put_should_replace_an_invalidated_record);
+    RUN_TEST(test_RecordCache_put_should_keep_a_ghost_key_through_a_scan);
 
     return UNITY_END();
 }
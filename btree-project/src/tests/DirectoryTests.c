@@ -0,0 +1,1026 @@
+/**
+ * @file DirectoryTests.c
+ * @author Florian Burgener (florian.burgener@etu.hesge.ch)
+ * @version 1.0
+ * @date 2022-06-17
+ */
+#include <glob.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../ColumnStore.h"
+#include "../Directory.h"
+#include "../DirectoryIndex.h"
+#include "../DirectoryRecord.h"
+#include "Unity/unity.h"
+
+// All the files of the tests start with this name, they are removed before each test.
+#define TEST_DATABASE_FILENAME "/tmp/DirectoryTests_database"
+
+// Enough records for the shards of the scans to be made of several blocks.
+#define SCAN_TEST_RECORD_COUNT (3 * DIRECTORY_SCAN_BLOCK_SIZE)
+#define TEST_RECORD_COUNT 1000
+
+/**
+ * @brief Removes the files of the database of the tests: the database files, their tombstones and their snapshots.
+ *
+ */
+static void remove_test_database() {
+    glob_t files;
+
+    if (glob(TEST_DATABASE_FILENAME "*", 0, NULL, &files) == 0) {
+        for (size_t i = 0; i < files.gl_pathc; i++) {
+            unlink(files.gl_pathv[i]);
+        }
+    }
+
+    globfree(&files);
+}
+
+void setUp() {
+    remove_test_database();
+}
+
+void tearDown() {
+    remove_test_database();
+}
+
+/**
+ * @brief Opens the directory of the tests.
+ *
+ * @param shard_count The number of shards, 0 = the directory is not sharded.
+ * @param backend The kind of index.
+ * @return Directory* The directory.
+ */
+static Directory *open_test_directory(int shard_count, const DirectoryIndexBackend *backend) {
+    char filename[FILENAME_MAXLEN] = TEST_DATABASE_FILENAME;
+    return Directory_init_with_index(filename, shard_count, backend);
+}
+
+/**
+ * @brief Builds the phone number of the record of a number.
+ *
+ * @param number The number of the record.
+ * @param phone_number The phone number will be assigned to this variable.
+ */
+static void get_test_phone_number(int number, char phone_number[PHONE_NUMBER_MAXLEN]) {
+    snprintf(phone_number, PHONE_NUMBER_MAXLEN, "%010d", number);
+}
+
+/**
+ * @brief Creates the record of a number, its phone number is the number and one record out of three is a Smith.
+ *
+ * @param number The number of the record.
+ * @return DirectoryRecord* The record.
+ */
+static DirectoryRecord *create_test_record(int number) {
+    char phone_number[PHONE_NUMBER_MAXLEN];
+    char name[NAME_MAXLEN];
+    char surname[SURNAME_MAXLEN];
+    get_test_phone_number(number, phone_number);
+    snprintf(name, NAME_MAXLEN, "Name%d", number);
+    snprintf(surname, SURNAME_MAXLEN, "%s", number % 3 == 0 ? "Smith" : "Doe");
+    return DirectoryRecord_init(false, phone_number, name, surname, 1950 + number % 70, 1 + number % 12, 1 + number % 28);
+}
+
+/**
+ * @brief Appends the records of the numbers from 0 to count - 1.
+ *
+ * @param directory The directory.
+ * @param count The number of records.
+ */
+static void fill_test_directory(Directory *directory, int count) {
+    for (int i = 0; i < count; i++) {
+        DirectoryRecord *record = create_test_record(i);
+        TEST_ASSERT_TRUE(Directory_append(directory, record));
+        DirectoryRecord_destroy(&record);
+    }
+}
+
+/**
+ * @brief Deletes the record of a number.
+ *
+ * @param directory The directory.
+ * @param number The number of the record.
+ * @return true The record has been deleted.
+ * @return false There is no record with this number.
+ */
+static bool delete_test_record(Directory *directory, int number) {
+    char phone_number[PHONE_NUMBER_MAXLEN];
+    get_test_phone_number(number, phone_number);
+    return Directory_delete(directory, phone_number);
+}
+
+/**
+ * @brief Searches for the record of a number and checks that it is the one created by create_test_record.
+ *
+ * @param directory The directory.
+ * @param number The number of the record.
+ * @return true The record has been found.
+ * @return false The record has not been found.
+ */
+static bool is_test_record_found(Directory *directory, int number) {
+    char phone_number[PHONE_NUMBER_MAXLEN];
+    get_test_phone_number(number, phone_number);
+    DirectoryRecord *record = Directory_search(directory, phone_number);
+
+    if (record == NULL) {
+        return false;
+    }
+
+    DirectoryRecord *expected_record = create_test_record(number);
+    TEST_ASSERT_EQUAL_STRING(expected_record->phone_number, record->phone_number);
+    TEST_ASSERT_EQUAL_STRING(expected_record->name, record->name);
+    TEST_ASSERT_EQUAL_STRING(expected_record->surname, record->surname);
+    TEST_ASSERT_EQUAL(expected_record->birth_date_year, record->birth_date_year);
+    DirectoryRecord_destroy(&expected_record);
+    DirectoryRecord_destroy(&record);
+    return true;
+}
+
+/**
+ * @brief Data structure that represents the records delivered to a callback, by number and by rank.
+ *
+ */
+typedef struct DeliveredRecords {
+    int *number_counts;
+    int *rank_counts;
+    int capacity;
+    int count;
+} DeliveredRecords;
+
+/**
+ * @brief Initializes the records delivered, none so far.
+ *
+ * @param delivered The records delivered.
+ * @param capacity The greatest number of a record plus 1.
+ */
+static void DeliveredRecords_init(DeliveredRecords *delivered, int capacity) {
+    delivered->number_counts = (int *)calloc(capacity, sizeof(int));
+    delivered->rank_counts = (int *)calloc(capacity, sizeof(int));
+    delivered->capacity = capacity;
+    delivered->count = 0;
+}
+
+/**
+ * @brief Frees the memory of the records delivered.
+ *
+ * @param delivered The records delivered.
+ */
+static void DeliveredRecords_destroy(DeliveredRecords *delivered) {
+    free(delivered->number_counts);
+    free(delivered->rank_counts);
+}
+
+/**
+ * @brief Counts a record delivered to a callback, the callback becomes the owner of the record.
+ *
+ * @param index The rank of the record.
+ * @param record The record.
+ * @param context The records delivered.
+ */
+static void count_delivered_record(int index, DirectoryRecord *record, void *context) {
+    DeliveredRecords *delivered = (DeliveredRecords *)context;
+    TEST_ASSERT_NOT_NULL(record);
+    int number = atoi(record->phone_number);
+    TEST_ASSERT_TRUE(number >= 0 && number < delivered->capacity);
+    TEST_ASSERT_TRUE(index >= 0 && index < delivered->capacity);
+    delivered->number_counts[number]++;
+    delivered->rank_counts[index]++;
+    delivered->count++;
+    DirectoryRecord_destroy(&record);
+}
+
+/**
+ * @brief Checks that each record has been delivered once if it is expected, and never otherwise, with distinct ranks.
+ *
+ * @param delivered The records delivered.
+ * @param is_expected true for the numbers of the records expected.
+ * @param returned_count The number of records returned by the function that delivered them.
+ */
+static void check_delivered_records(DeliveredRecords *delivered, bool *is_expected, int returned_count) {
+    int expected_count = 0;
+
+    for (int i = 0; i < delivered->capacity; i++) {
+        TEST_ASSERT_EQUAL(is_expected[i] ? 1 : 0, delivered->number_counts[i]);
+        expected_count += is_expected[i];
+    }
+
+    TEST_ASSERT_EQUAL(expected_count, delivered->count);
+    TEST_ASSERT_EQUAL(expected_count, returned_count);
+
+    // The ranks are 0 to count - 1.
+    for (int i = 0; i < delivered->capacity; i++) {
+        TEST_ASSERT_EQUAL(i < expected_count ? 1 : 0, delivered->rank_counts[i]);
+    }
+}
+
+// BEGIN : Tests
+
+// **** BEGIN : test_Directory_scan
+
+/**
+ * @brief Selects the records whose phone number ends with an even digit, without decoding them.
+ *
+ * @param bytes The record as written on disk.
+ * @param context Unused.
+ * @return true The record is selected.
+ * @return false The record is not selected.
+ */
+static bool is_phone_number_even(const uint8_t *bytes, void *context) {
+    (void)context;
+    return (bytes[PHONE_NUMBER_OFFSET + PHONE_NUMBER_MAXLEN_WITHOUT_NULL_CHARACTER - 1] - '0') % 2 == 0;
+}
+
+void test_Directory_scan_should_select_the_same_records_with_any_number_of_threads() {
+    Directory *directory = open_test_directory(2, &DIRECTORY_INDEX_BPTREE);
+    fill_test_directory(directory, SCAN_TEST_RECORD_COUNT);
+
+    bool *is_expected = (bool *)malloc(sizeof(bool) * SCAN_TEST_RECORD_COUNT);
+    for (int i = 0; i < SCAN_TEST_RECORD_COUNT; i++) {
+        // The deleted records, some of which are in blocks of another shard, are left out.
+        bool is_deleted = i % 7 == 0;
+        if (is_deleted) {
+            TEST_ASSERT_TRUE(delete_test_record(directory, i));
+        }
+
+        is_expected[i] = !is_deleted && i % 2 == 0;
+    }
+
+    int thread_counts[] = {1, 2, 4, 16};
+    for (int i = 0; i < (int)(sizeof(thread_counts) / sizeof(thread_counts[0])); i++) {
+        DeliveredRecords delivered;
+        DeliveredRecords_init(&delivered, SCAN_TEST_RECORD_COUNT);
+        int count = Directory_scan(directory, is_phone_number_even, count_delivered_record, &delivered, thread_counts[i]);
+        check_delivered_records(&delivered, is_expected, count);
+        DeliveredRecords_destroy(&delivered);
+    }
+
+    free(is_expected);
+    Directory_destroy(&directory);
+}
+
+void test_Directory_scan_should_select_nothing_in_an_empty_directory() {
+    Directory *directory = open_test_directory(4, &DIRECTORY_INDEX_BPTREE);
+    DeliveredRecords delivered;
+    DeliveredRecords_init(&delivered, 1);
+
+    TEST_ASSERT_EQUAL(0, Directory_scan(directory, is_phone_number_even, count_delivered_record, &delivered, 4));
+    TEST_ASSERT_EQUAL(0, delivered.count);
+
+    DeliveredRecords_destroy(&delivered);
+    Directory_destroy(&directory);
+}
+
+// **** END : test_Directory_scan
+
+// **** BEGIN : test_Directory_search_prefix
+
+/**
+ * @brief Searches for the records of a prefix and checks them against the numbers of the records that start with it.
+ *
+ * @param directory The directory, filled with the records of the numbers from 0 to TEST_RECORD_COUNT - 1.
+ * @param prefix The prefix.
+ * @param is_deleted true for the numbers of the deleted records.
+ */
+static void check_prefix(Directory *directory, char prefix[PHONE_NUMBER_MAXLEN], bool *is_deleted) {
+    bool is_expected[TEST_RECORD_COUNT];
+
+    for (int i = 0; i < TEST_RECORD_COUNT; i++) {
+        char phone_number[PHONE_NUMBER_MAXLEN];
+        get_test_phone_number(i, phone_number);
+        is_expected[i] = !is_deleted[i] && strncmp(phone_number, prefix, strlen(prefix)) == 0;
+    }
+
+    DeliveredRecords delivered;
+    DeliveredRecords_init(&delivered, TEST_RECORD_COUNT);
+    int count = Directory_search_prefix(directory, prefix, count_delivered_record, &delivered);
+    check_delivered_records(&delivered, is_expected, count);
+    DeliveredRecords_destroy(&delivered);
+}
+
+void test_Directory_search_prefix_should_find_the_records_of_every_shard() {
+    Directory *directory = open_test_directory(4, &DIRECTORY_INDEX_RADIX);
+    fill_test_directory(directory, TEST_RECORD_COUNT);
+    bool is_deleted[TEST_RECORD_COUNT] = {false};
+
+    char prefixes[][PHONE_NUMBER_MAXLEN] = {"0000000", "00000001", "000000012", "0000000123", "00000009", "1"};
+    int prefix_count = (int)(sizeof(prefixes) / sizeof(prefixes[0]));
+
+    for (int i = 0; i < prefix_count; i++) {
+        check_prefix(directory, prefixes[i], is_deleted);
+    }
+
+    for (int i = 100; i < 200; i += 3) {
+        TEST_ASSERT_TRUE(delete_test_record(directory, i));
+        is_deleted[i] = true;
+    }
+
+    for (int i = 0; i < prefix_count; i++) {
+        check_prefix(directory, prefixes[i], is_deleted);
+    }
+
+    Directory_destroy(&directory);
+}
+
+void test_Directory_search_prefix_should_need_an_ordered_index() {
+    Directory *directory = open_test_directory(0, &DIRECTORY_INDEX_BPTREE);
+    fill_test_directory(directory, 10);
+
+    char prefix[PHONE_NUMBER_MAXLEN] = "0";
+    TEST_ASSERT_EQUAL(-1, Directory_search_prefix(directory, prefix, count_delivered_record, NULL));
+
+    Directory_destroy(&directory);
+}
+
+// **** END : test_Directory_search_prefix
+
+// **** BEGIN : test_Directory_export_columns
+
+void test_Directory_export_columns_should_copy_the_live_records() {
+    Directory *directory = open_test_directory(2, &DIRECTORY_INDEX_BPTREE);
+    fill_test_directory(directory, TEST_RECORD_COUNT);
+    int smith_count = 0;
+
+    for (int i = 0; i < TEST_RECORD_COUNT; i++) {
+        if (i % 10 == 0) {
+            TEST_ASSERT_TRUE(delete_test_record(directory, i));
+        } else if (i % 3 == 0) {
+            smith_count++;
+        }
+    }
+
+    char name[COLUMN_STORE_FILENAME_MAXLEN] = TEST_DATABASE_FILENAME ".columns";
+    ColumnStore *store = ColumnStore_init(name);
+
+    // The previous content of the store is removed, the export is done twice.
+    for (int i = 0; i < 2; i++) {
+        Directory_export_columns(directory, store);
+        TEST_ASSERT_EQUAL(Directory_count(directory), store->size);
+        TEST_ASSERT_EQUAL(TEST_RECORD_COUNT - TEST_RECORD_COUNT / 10, store->size);
+    }
+
+    char surname[SURNAME_MAXLEN] = "Smith";
+    IntegerArray *slots = ColumnStore_select_by_surname(store, surname);
+    TEST_ASSERT_EQUAL(smith_count, slots->size);
+
+    for (int i = 0; i < slots->size; i++) {
+        DirectoryRecord *record = ColumnStore_read(store, (int)slots->items[i]);
+        int number = atoi(record->phone_number);
+        TEST_ASSERT_TRUE(number % 3 == 0 && number % 10 != 0);
+        TEST_ASSERT_EQUAL_STRING("Smith", record->surname);
+        DirectoryRecord_destroy(&record);
+    }
+
+    IntegerArray_destroy(&slots);
+    ColumnStore_destroy(&store);
+    Directory_destroy(&directory);
+}
+
+// **** END : test_Directory_export_columns
+
+// **** BEGIN : test_Directory_freeze
+
+/**
+ * @brief Counts the shards whose index is frozen.
+ *
+ * @param directory The directory.
+ * @return int The number of shards.
+ */
+static int count_frozen_shards(Directory *directory) {
+    int count = 0;
+
+    for (int i = 0; i < directory->shard_count; i++) {
+        count += directory->shards[i]->frozen_index != NULL;
+    }
+
+    return count;
+}
+
+void test_Directory_freeze_should_be_dropped_by_an_append_and_a_deletion() {
+    Directory *directory = open_test_directory(2, &DIRECTORY_INDEX_BPTREE);
+    fill_test_directory(directory, TEST_RECORD_COUNT);
+
+    Directory_freeze(directory);
+    TEST_ASSERT_EQUAL(2, count_frozen_shards(directory));
+
+    for (int i = 0; i < TEST_RECORD_COUNT; i++) {
+        TEST_ASSERT_TRUE(is_test_record_found(directory, i));
+    }
+
+    TEST_ASSERT_FALSE(is_test_record_found(directory, TEST_RECORD_COUNT));
+
+    // Only the shard of the record appended goes back to its index.
+    DirectoryRecord *record = create_test_record(TEST_RECORD_COUNT);
+    TEST_ASSERT_TRUE(Directory_append(directory, record));
+    DirectoryRecord_destroy(&record);
+    TEST_ASSERT_EQUAL(1, count_frozen_shards(directory));
+    TEST_ASSERT_TRUE(is_test_record_found(directory, TEST_RECORD_COUNT));
+
+    Directory_freeze(directory);
+    TEST_ASSERT_EQUAL(2, count_frozen_shards(directory));
+    TEST_ASSERT_TRUE(is_test_record_found(directory, TEST_RECORD_COUNT));
+
+    TEST_ASSERT_TRUE(delete_test_record(directory, 0));
+    TEST_ASSERT_EQUAL(1, count_frozen_shards(directory));
+    TEST_ASSERT_FALSE(is_test_record_found(directory, 0));
+
+    for (int i = 1; i <= TEST_RECORD_COUNT; i++) {
+        TEST_ASSERT_TRUE(is_test_record_found(directory, i));
+    }
+
+    Directory_destroy(&directory);
+}
+
+void test_Directory_freeze_should_leave_a_hash_index_as_it_is() {
+    Directory *directory = open_test_directory(2, &DIRECTORY_INDEX_HASH);
+    fill_test_directory(directory, TEST_RECORD_COUNT);
+
+    Directory_freeze(directory);
+    TEST_ASSERT_EQUAL(0, count_frozen_shards(directory));
+    TEST_ASSERT_TRUE(is_test_record_found(directory, TEST_RECORD_COUNT / 2));
+
+    Directory_destroy(&directory);
+}
+
+// **** END : test_Directory_freeze
+
+// **** BEGIN : test_Directory_tombstones
+
+/**
+ * @brief Fills the directory of the tests with 16 records and deletes those of the odd numbers.
+ *
+ * @return Directory* The directory.
+ */
+static Directory *create_directory_with_deleted_records() {
+    Directory *directory = open_test_directory(0, &DIRECTORY_INDEX_BPTREE);
+    fill_test_directory(directory, 16);
+
+    for (int i = 1; i < 16; i += 2) {
+        TEST_ASSERT_TRUE(delete_test_record(directory, i));
+    }
+
+    TEST_ASSERT_EQUAL(8, Directory_count(directory));
+    return directory;
+}
+
+void test_Directory_init_should_forget_the_tombstones_of_a_removed_database() {
+    Directory *directory = create_directory_with_deleted_records();
+    Directory_destroy(&directory);
+
+    // Only the database file is removed, its tombstones are left behind.
+    unlink(TEST_DATABASE_FILENAME);
+    directory = open_test_directory(0, &DIRECTORY_INDEX_BPTREE);
+    TEST_ASSERT_EQUAL(0, Directory_count(directory));
+    fill_test_directory(directory, 16);
+    Directory_destroy(&directory);
+
+    directory = open_test_directory(0, &DIRECTORY_INDEX_BPTREE);
+    TEST_ASSERT_EQUAL(16, Directory_count(directory));
+
+    for (int i = 0; i < 16; i++) {
+        TEST_ASSERT_TRUE(is_test_record_found(directory, i));
+    }
+
+    Directory_destroy(&directory);
+}
+
+void test_Directory_init_should_rebuild_lost_tombstones_from_the_database() {
+    Directory *directory = create_directory_with_deleted_records();
+    Directory_destroy(&directory);
+
+    unlink(TEST_DATABASE_FILENAME ".tombstones");
+    directory = open_test_directory(0, &DIRECTORY_INDEX_BPTREE);
+    TEST_ASSERT_EQUAL(8, Directory_count(directory));
+
+    for (int i = 0; i < 16; i++) {
+        TEST_ASSERT_EQUAL(i % 2 == 0, is_test_record_found(directory, i));
+    }
+
+    Directory_destroy(&directory);
+
+    // The bitmap has been saved again.
+    TEST_ASSERT_EQUAL(0, access(TEST_DATABASE_FILENAME ".tombstones", F_OK));
+}
+
+void test_Directory_append_should_store_a_record_as_alive() {
+    Directory *directory = open_test_directory(0, &DIRECTORY_INDEX_BPTREE);
+    DirectoryRecord *record = create_test_record(0);
+    record->is_deleted = true;
+    TEST_ASSERT_TRUE(Directory_append(directory, record));
+    DirectoryRecord_destroy(&record);
+    Directory_destroy(&directory);
+
+    // The flag given with the record is not written, the record would otherwise be lost with the bitmap.
+    unlink(TEST_DATABASE_FILENAME ".tombstones");
+    directory = open_test_directory(0, &DIRECTORY_INDEX_BPTREE);
+    TEST_ASSERT_TRUE(is_test_record_found(directory, 0));
+    Directory_destroy(&directory);
+}
+
+// **** END : test_Directory_tombstones
+
+// **** BEGIN : test_Directory_migration
+
+/**
+ * @brief Gets the size of a file of the tests.
+ *
+ * @param filename The name of the file.
+ * @return long The size of the file in bytes.
+ */
+static long get_test_file_size(const char *filename) {
+    struct stat file_stat;
+    TEST_ASSERT_EQUAL(0, stat(filename, &file_stat));
+    return (long)file_stat.st_size;
+}
+
+/**
+ * @brief Gets the size of a database file of the tests made of a number of records.
+ *
+ * @param record_count The number of records.
+ * @return long The size of the file in bytes.
+ */
+static long get_test_database_size(int record_count) {
+    return DIRECTORY_HEADER_SIZE_IN_BYTES + (long)record_count * (DirectoryRecord_size_on_disk() + CHECKSUM_SIZE_IN_BYTES);
+}
+
+/**
+ * @brief Writes a database file as the versions without header did: the records one after the other, without
+ * checksum, the deleted ones with their first byte set.
+ *
+ * @param count The number of records.
+ * @param is_deleted true for the numbers of the records deleted.
+ * @param tail_size The number of bytes of an incomplete record written at the end of the file.
+ */
+static void write_legacy_test_database(int count, bool *is_deleted, int tail_size) {
+    FILE *fp = fopen(TEST_DATABASE_FILENAME, "wb");
+    TEST_ASSERT_NOT_NULL(fp);
+
+    for (int i = 0; i < count; i++) {
+        DirectoryRecord *record = create_test_record(i);
+        record->is_deleted = is_deleted[i];
+        ByteArray *bytes = DirectoryRecord_to_ByteArray(record);
+        fwrite(bytes->items, 1, bytes->size, fp);
+        ByteArray_destroy(&bytes);
+        DirectoryRecord_destroy(&record);
+    }
+
+    uint8_t tail[tail_size + 1];
+    memset(tail, 0, tail_size + 1);
+    fwrite(tail, 1, tail_size, fp);
+    fclose(fp);
+}
+
+void test_Directory_init_should_migrate_a_legacy_database() {
+    bool is_deleted[16];
+    for (int i = 0; i < 16; i++) {
+        is_deleted[i] = i % 4 == 1;
+    }
+
+    write_legacy_test_database(16, is_deleted, 0);
+    Directory *directory = open_test_directory(0, &DIRECTORY_INDEX_BPTREE);
+    TEST_ASSERT_EQUAL(12, Directory_count(directory));
+
+    for (int i = 0; i < 16; i++) {
+        TEST_ASSERT_EQUAL(!is_deleted[i], is_test_record_found(directory, i));
+    }
+
+    Directory_destroy(&directory);
+    TEST_ASSERT_EQUAL(get_test_database_size(16), get_test_file_size(TEST_DATABASE_FILENAME));
+
+    // The migrated file is opened as is.
+    directory = open_test_directory(0, &DIRECTORY_INDEX_BPTREE);
+    TEST_ASSERT_EQUAL(12, Directory_count(directory));
+    TEST_ASSERT_TRUE(is_test_record_found(directory, 15));
+    Directory_destroy(&directory);
+}
+
+void test_Directory_init_should_drop_the_truncated_tail_of_a_legacy_database() {
+    bool is_deleted[8] = {false};
+    write_legacy_test_database(8, is_deleted, DirectoryRecord_size_on_disk() / 2);
+
+    Directory *directory = open_test_directory(0, &DIRECTORY_INDEX_BPTREE);
+    TEST_ASSERT_EQUAL(8, Directory_count(directory));
+    Directory_destroy(&directory);
+    TEST_ASSERT_EQUAL(get_test_database_size(8), get_test_file_size(TEST_DATABASE_FILENAME));
+
+    // The next record is appended after the last complete one.
+    directory = open_test_directory(0, &DIRECTORY_INDEX_BPTREE);
+    DirectoryRecord *record = create_test_record(8);
+    TEST_ASSERT_TRUE(Directory_append(directory, record));
+    DirectoryRecord_destroy(&record);
+    TEST_ASSERT_EQUAL(9, Directory_count(directory));
+    TEST_ASSERT_TRUE(is_test_record_found(directory, 8));
+    Directory_destroy(&directory);
+    TEST_ASSERT_EQUAL(get_test_database_size(9), get_test_file_size(TEST_DATABASE_FILENAME));
+}
+
+void test_Directory_init_should_skip_and_reuse_a_corrupted_slot() {
+    Directory *directory = open_test_directory(0, &DIRECTORY_INDEX_BPTREE);
+    fill_test_directory(directory, 8);
+    Directory_destroy(&directory);
+
+    // A byte of the name of the record of slot 3 is flipped, the record no longer matches its checksum.
+    FILE *fp = fopen(TEST_DATABASE_FILENAME, "r+b");
+    TEST_ASSERT_NOT_NULL(fp);
+    fseek(fp, get_test_database_size(3) + NAME_OFFSET, SEEK_SET);
+    int byte = fgetc(fp);
+    fseek(fp, get_test_database_size(3) + NAME_OFFSET, SEEK_SET);
+    fputc(byte ^ 0xFF, fp);
+    fclose(fp);
+
+    directory = open_test_directory(0, &DIRECTORY_INDEX_BPTREE);
+    TEST_ASSERT_EQUAL(7, Directory_count(directory));
+
+    for (int i = 0; i < 8; i++) {
+        TEST_ASSERT_EQUAL(i != 3, is_test_record_found(directory, i));
+    }
+
+    // The slot has been tombstoned, the next append fills it instead of growing the file.
+    DirectoryRecord *record = create_test_record(100);
+    TEST_ASSERT_TRUE(Directory_append(directory, record));
+    DirectoryRecord_destroy(&record);
+    Directory_destroy(&directory);
+    TEST_ASSERT_EQUAL(get_test_database_size(8), get_test_file_size(TEST_DATABASE_FILENAME));
+
+    directory = open_test_directory(0, &DIRECTORY_INDEX_BPTREE);
+    TEST_ASSERT_EQUAL(8, Directory_count(directory));
+    TEST_ASSERT_TRUE(is_test_record_found(directory, 100));
+    Directory_destroy(&directory);
+}
+
+// **** END : test_Directory_migration
+
+// **** BEGIN : test_Directory_snapshot
+
+/**
+ * @brief Fills the directory of the tests, saves the snapshot of its index, then appends and deletes records, which
+ * are written to the journal of the snapshot.
+ *
+ * @param backend The kind of index.
+ */
+static void create_test_snapshot(const DirectoryIndexBackend *backend) {
+    Directory *directory = open_test_directory(0, backend);
+    fill_test_directory(directory, TEST_RECORD_COUNT);
+    TEST_ASSERT_TRUE(Directory_save_index(directory));
+    TEST_ASSERT_TRUE(Directory_wait_index_save(directory));
+
+    for (int i = 0; i < TEST_RECORD_COUNT; i += 10) {
+        TEST_ASSERT_TRUE(delete_test_record(directory, i));
+    }
+
+    // The first appends fill the slots that have just been freed, the others grow the file.
+    for (int i = TEST_RECORD_COUNT; i < TEST_RECORD_COUNT + TEST_RECORD_COUNT / 5; i++) {
+        DirectoryRecord *record = create_test_record(i);
+        TEST_ASSERT_TRUE(Directory_append(directory, record));
+        DirectoryRecord_destroy(&record);
+    }
+
+    Directory_destroy(&directory);
+}
+
+/**
+ * @brief Checks that the directory of the tests holds the records left by create_test_snapshot.
+ *
+ * @param backend The kind of index.
+ * @param is_snapshot_loaded true if the snapshot is expected to be loaded, false if it is expected to be discarded.
+ */
+static void check_test_snapshot(const DirectoryIndexBackend *backend, bool is_snapshot_loaded) {
+    Directory *directory = open_test_directory(0, backend);
+    // A snapshot that cannot be loaded is removed with its journal.
+    TEST_ASSERT_EQUAL(is_snapshot_loaded, access(TEST_DATABASE_FILENAME ".index", F_OK) == 0);
+    TEST_ASSERT_EQUAL(is_snapshot_loaded, access(TEST_DATABASE_FILENAME ".journal", F_OK) == 0);
+    TEST_ASSERT_EQUAL(TEST_RECORD_COUNT - TEST_RECORD_COUNT / 10 + TEST_RECORD_COUNT / 5, Directory_count(directory));
+
+    for (int i = 0; i < TEST_RECORD_COUNT + TEST_RECORD_COUNT / 5; i++) {
+        TEST_ASSERT_EQUAL(i >= TEST_RECORD_COUNT || i % 10 != 0, is_test_record_found(directory, i));
+    }
+
+    Directory_destroy(&directory);
+}
+
+void test_Directory_init_should_replay_the_journal_of_the_snapshot() {
+    create_test_snapshot(&DIRECTORY_INDEX_BPTREE);
+    check_test_snapshot(&DIRECTORY_INDEX_BPTREE, true);
+    // The snapshot is still followed by its journal once reopened.
+    check_test_snapshot(&DIRECTORY_INDEX_BPTREE, true);
+}
+
+void test_Directory_init_should_rebuild_the_index_after_a_truncated_journal_entry() {
+    create_test_snapshot(&DIRECTORY_INDEX_BPTREE);
+
+    FILE *fp = fopen(TEST_DATABASE_FILENAME ".journal", "ab");
+    TEST_ASSERT_NOT_NULL(fp);
+    uint8_t entry[JOURNAL_ENTRY_SIZE_IN_BYTES - 1] = {0};
+    fwrite(entry, 1, JOURNAL_ENTRY_SIZE_IN_BYTES - 1, fp);
+    fclose(fp);
+
+    check_test_snapshot(&DIRECTORY_INDEX_BPTREE, false);
+}
+
+void test_Directory_init_should_rebuild_the_index_saved_with_another_backend() {
+    create_test_snapshot(&DIRECTORY_INDEX_BPTREE);
+    check_test_snapshot(&DIRECTORY_INDEX_HASH, false);
+}
+
+// **** END : test_Directory_snapshot
+
+// **** BEGIN : test_Directory_update
+
+/**
+ * @brief Creates the record of a number as it is after an update: the same phone number, another name.
+ *
+ * @param number The number of the record.
+ * @return DirectoryRecord* The record.
+ */
+static DirectoryRecord *create_updated_test_record(int number) {
+    DirectoryRecord *record = create_test_record(number);
+    snprintf(record->name, NAME_MAXLEN, "Updated%d", number);
+    return record;
+}
+
+/**
+ * @brief Checks that the record of a number has been updated by create_updated_test_record.
+ *
+ * @param directory The directory.
+ * @param number The number of the record.
+ */
+static void check_updated_test_record(Directory *directory, int number) {
+    char phone_number[PHONE_NUMBER_MAXLEN];
+    char name[NAME_MAXLEN];
+    get_test_phone_number(number, phone_number);
+    snprintf(name, NAME_MAXLEN, "Updated%d", number);
+    DirectoryRecord *record = Directory_search(directory, phone_number);
+    TEST_ASSERT_NOT_NULL(record);
+    TEST_ASSERT_EQUAL_STRING(name, record->name);
+    DirectoryRecord_destroy(&record);
+}
+
+void test_Directory_update_should_overwrite_the_record_in_its_slot() {
+    Directory *directory = open_test_directory(0, &DIRECTORY_INDEX_BPTREE);
+    fill_test_directory(directory, 16);
+
+    DirectoryRecord *record = create_updated_test_record(7);
+    TEST_ASSERT_TRUE(Directory_update(directory, record));
+    DirectoryRecord_destroy(&record);
+    record = create_updated_test_record(16);
+    TEST_ASSERT_FALSE(Directory_update(directory, record));
+    DirectoryRecord_destroy(&record);
+
+    check_updated_test_record(directory, 7);
+    TEST_ASSERT_EQUAL(16, Directory_count(directory));
+    Directory_destroy(&directory);
+    TEST_ASSERT_EQUAL(get_test_database_size(16), get_test_file_size(TEST_DATABASE_FILENAME));
+
+    directory = open_test_directory(0, &DIRECTORY_INDEX_BPTREE);
+    check_updated_test_record(directory, 7);
+
+    for (int i = 0; i < 16; i++) {
+        if (i != 7) {
+            TEST_ASSERT_TRUE(is_test_record_found(directory, i));
+        }
+    }
+
+    Directory_destroy(&directory);
+}
+
+void test_Directory_update_should_refresh_the_cache() {
+    Directory *directory = open_test_directory(4, &DIRECTORY_INDEX_BPTREE);
+    Directory_enable_cache(directory, 64);
+    fill_test_directory(directory, 16);
+
+    // The second search is answered by the cache.
+    TEST_ASSERT_TRUE(is_test_record_found(directory, 7));
+    TEST_ASSERT_TRUE(is_test_record_found(directory, 7));
+    uint64_t hit_count;
+    uint64_t miss_count;
+    Directory_get_cache_counters(directory, &hit_count, &miss_count);
+    TEST_ASSERT_EQUAL(1, hit_count);
+
+    DirectoryRecord *record = create_updated_test_record(7);
+    TEST_ASSERT_TRUE(Directory_update(directory, record));
+    DirectoryRecord_destroy(&record);
+    check_updated_test_record(directory, 7);
+    check_updated_test_record(directory, 7);
+    Directory_destroy(&directory);
+}
+
+// **** END : test_Directory_update
+
+// **** BEGIN : test_Directory_free_slots
+
+/**
+ * @brief Reads the phone number of the record stored in a slot of the database file of the tests.
+ *
+ * @param slot The slot.
+ * @param phone_number The phone number will be assigned to this variable.
+ */
+static void read_test_slot_phone_number(int slot, char phone_number[PHONE_NUMBER_MAXLEN]) {
+    FILE *fp = fopen(TEST_DATABASE_FILENAME, "rb");
+    TEST_ASSERT_NOT_NULL(fp);
+    fseek(fp, get_test_database_size(slot) + PHONE_NUMBER_OFFSET, SEEK_SET);
+    phone_number[PHONE_NUMBER_MAXLEN - 1] = '\0';
+    TEST_ASSERT_EQUAL(1, fread(phone_number, PHONE_NUMBER_MAXLEN_WITHOUT_NULL_CHARACTER, 1, fp));
+    fclose(fp);
+}
+
+/**
+ * @brief Appends the record of a number and checks the slot in which it has been written.
+ *
+ * @param directory The directory.
+ * @param number The number of the record.
+ * @param expected_slot The slot expected.
+ */
+static void append_test_record_to_slot(Directory *directory, int number, int expected_slot) {
+    DirectoryRecord *record = create_test_record(number);
+    TEST_ASSERT_TRUE(Directory_append(directory, record));
+    DirectoryRecord_destroy(&record);
+
+    char phone_number[PHONE_NUMBER_MAXLEN];
+    char expected_phone_number[PHONE_NUMBER_MAXLEN];
+    read_test_slot_phone_number(expected_slot, phone_number);
+    get_test_phone_number(number, expected_phone_number);
+    TEST_ASSERT_EQUAL_STRING(expected_phone_number, phone_number);
+}
+
+void test_Directory_append_should_fill_the_lowest_free_slot() {
+    Directory *directory = open_test_directory(0, &DIRECTORY_INDEX_BPTREE);
+    fill_test_directory(directory, 16);
+    TEST_ASSERT_TRUE(delete_test_record(directory, 11));
+    TEST_ASSERT_TRUE(delete_test_record(directory, 5));
+    TEST_ASSERT_TRUE(delete_test_record(directory, 2));
+
+    append_test_record_to_slot(directory, 100, 2);
+    append_test_record_to_slot(directory, 101, 5);
+    Directory_destroy(&directory);
+
+    // The free slots are found again when the directory is opened.
+    directory = open_test_directory(0, &DIRECTORY_INDEX_BPTREE);
+    append_test_record_to_slot(directory, 102, 11);
+    TEST_ASSERT_EQUAL(get_test_database_size(16), get_test_file_size(TEST_DATABASE_FILENAME));
+
+    // There is no free slot left, the file grows.
+    append_test_record_to_slot(directory, 103, 16);
+    TEST_ASSERT_EQUAL(17, Directory_count(directory));
+
+    for (int i = 100; i < 104; i++) {
+        TEST_ASSERT_TRUE(is_test_record_found(directory, i));
+    }
+
+    Directory_destroy(&directory);
+}
+
+// **** END : test_Directory_free_slots
+
+// **** BEGIN : test_Directory_search_batch
+
+/**
+ * @brief Data structure that represents a batch search of the tests, the records found are deleted by the callback if
+ * the directory is given.
+ *
+ */
+typedef struct TestBatchSearch {
+    Directory *directory;
+    bool *is_found;
+    int *result_counts;
+} TestBatchSearch;
+
+/**
+ * @brief Checks a result of a batch search and deletes its record if the search is asked to.
+ *
+ * @param index The index of the phone number in the batch, it is the number of the record.
+ * @param record The record, NULL if not found.
+ * @param context The search.
+ */
+static void check_batch_result(int index, DirectoryRecord *record, void *context) {
+    TestBatchSearch *search = (TestBatchSearch *)context;
+    search->result_counts[index]++;
+    search->is_found[index] = record != NULL;
+
+    if (record == NULL) {
+        return;
+    }
+
+    char phone_number[PHONE_NUMBER_MAXLEN];
+    get_test_phone_number(index, phone_number);
+    TEST_ASSERT_EQUAL_STRING(phone_number, record->phone_number);
+    DirectoryRecord_destroy(&record);
+
+    // No lock of the directory is held while the results are delivered.
+    if (search->directory != NULL) {
+        TEST_ASSERT_TRUE(Directory_delete(search->directory, phone_number));
+    }
+}
+
+/**
+ * @brief Searches for the records of the numbers from 0 to 2 * TEST_RECORD_COUNT - 1 at once, only the first half
+ * exists in the directory.
+ *
+ * @param directory The directory filled with TEST_RECORD_COUNT records.
+ * @param is_deleting true if the callback deletes the records found.
+ */
+static void check_search_batch(Directory *directory, bool is_deleting) {
+    int count = 2 * TEST_RECORD_COUNT;
+    char(*phone_numbers)[PHONE_NUMBER_MAXLEN] = (char(*)[PHONE_NUMBER_MAXLEN])malloc(sizeof(*phone_numbers) * count);
+    TestBatchSearch search = {is_deleting ? directory : NULL, (bool *)calloc(count, sizeof(bool)), (int *)calloc(count, sizeof(int))};
+
+    for (int i = 0; i < count; i++) {
+        get_test_phone_number(i, phone_numbers[i]);
+    }
+
+    Directory_search_batch(directory, phone_numbers, count, check_batch_result, &search);
+
+    for (int i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL(1, search.result_counts[i]);
+        TEST_ASSERT_EQUAL(i < TEST_RECORD_COUNT, search.is_found[i]);
+    }
+
+    TEST_ASSERT_EQUAL(is_deleting ? 0 : TEST_RECORD_COUNT, Directory_count(directory));
+    free(phone_numbers);
+    free(search.is_found);
+    free(search.result_counts);
+}
+
+void test_Directory_search_batch_should_find_the_records() {
+    Directory *directory = open_test_directory(4, &DIRECTORY_INDEX_BPTREE);
+    fill_test_directory(directory, TEST_RECORD_COUNT);
+    check_search_batch(directory, false);
+    Directory_destroy(&directory);
+}
+
+void test_Directory_search_batch_should_find_the_records_with_the_threads() {
+    Directory *directory = open_test_directory(4, &DIRECTORY_INDEX_BPTREE);
+    // The reads are performed by the threads, as when io_uring is not available.
+    AsyncReader_destroy(&directory->reader);
+    directory->reader = AsyncReader_init_with_threads();
+    fill_test_directory(directory, TEST_RECORD_COUNT);
+    check_search_batch(directory, false);
+    Directory_destroy(&directory);
+}
+
+void test_Directory_search_batch_should_let_the_callback_modify_the_directory() {
+    Directory *directory = open_test_directory(4, &DIRECTORY_INDEX_BPTREE);
+    fill_test_directory(directory, TEST_RECORD_COUNT);
+    check_search_batch(directory, true);
+    Directory_destroy(&directory);
+
+    directory = open_test_directory(4, &DIRECTORY_INDEX_BPTREE);
+    AsyncReader_destroy(&directory->reader);
+    directory->reader = AsyncReader_init_with_threads();
+    fill_test_directory(directory, TEST_RECORD_COUNT);
+    check_search_batch(directory, true);
+    Directory_destroy(&directory);
+}
+
+// **** END : test_Directory_search_batch
+
+// END : Tests
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_Directory_scan_should_select_the_same_records_with_any_number_of_threads);
+    RUN_TEST(test_Directory_scan_should_select_nothing_in_an_empty_directory);
+
+    RUN_TEST(test_Directory_search_prefix_should_find_the_records_of_every_shard);
+    RUN_TEST(test_Directory_search_prefix_should_need_an_ordered_index);
+
+    RUN_TEST(test_Directory_export_columns_should_copy_the_live_records);
+
+    RUN_TEST(test_Directory_freeze_should_be_dropped_by_an_append_and_a_deletion);
+    RUN_TEST(test_Directory_freeze_should_leave_a_hash_index_as_it_is);
+
+
+    RUN_TEST(test_Directory_init_should_forget_the_tombstones_of_a_removed_database);
+    RUN_TEST(test_Directory_init_should_rebuild_lost_tombstones_from_the_database);
+    RUN_TEST(test_Directory_append_should_store_a_record_as_alive);
+
+
+    RUN_TEST(test_Directory_init_should_migrate_a_legacy_database);
+    RUN_TEST(test_Directory_init_should_drop_the_truncated_tail_of_a_legacy_database);
+    RUN_TEST(test_Directory_init_should_skip_and_reuse_a_corrupted_slot);
+
+
+    RUN_TEST(test_Directory_init_should_replay_the_journal_of_the_snapshot);
+    RUN_TEST(test_Directory_init_should_rebuild_the_index_after_a_truncated_journal_entry);
+    RUN_TEST(test_Directory_init_should_rebuild_the_index_saved_with_another_backend);
+
+
+    RUN_TEST(test_Directory_update_should_overwrite_the_record_in_its_slot);
+    RUN_TEST(test_Directory_update_should_refresh_the_cache);
+
+
+    RUN_TEST(test_Directory_append_should_fill_the_lowest_free_slot);
+
+
+    RUN_TEST(test_Directory_search_batch_should_find_the_records);
+    RUN_TEST(test_Directory_search_batch_should_find_the_records_with_the_threads);
+    RUN_TEST(test_Directory_search_batch_should_let_the_callback_modify_the_directory);
+
+    return UNITY_END();
+}